@@ -0,0 +1,73 @@
+# Bakes the world positions of animated objects into a trajectory file
+# for the cablerobot-2D Choreography importer.
+#
+# Usage: select the objects that stand in for each cable robot (they are
+# assigned to robots in the order of their names), then run this script
+# from Blender's Text Editor. Copy the output file into the app's bin/data folder.
+#
+# Blender's front (XZ) view maps onto the robots' drawing plane:
+#   robot x = blender x,  robot y = blender z,  robot z = blender y  (all in mm)
+
+import bpy
+import json
+import os
+
+OUTPUT_PATH = "//choreography.csv"  # use a .json extension to export JSON instead
+SCALE = 1000.0                       # blender units (m) to mm
+
+
+def to_robot_coords(loc):
+    return (loc.x * SCALE, loc.z * SCALE, loc.y * SCALE)
+
+
+def bake(objects, scene):
+    fps = scene.render.fps / scene.render.fps_base
+    frames = range(scene.frame_start, scene.frame_end + 1)
+    samples = {obj.name: [] for obj in objects}
+
+    frame_current = scene.frame_current
+    for frame in frames:
+        scene.frame_set(frame)
+        for obj in objects:
+            samples[obj.name].append(to_robot_coords(obj.matrix_world.translation))
+    scene.frame_set(frame_current)
+
+    return fps, list(frames), samples
+
+
+def write_csv(path, fps, frames, samples):
+    with open(path, "w") as f:
+        f.write("object,frame,time,x,y,z\n")
+        for name, positions in sorted(samples.items()):
+            for i, (x, y, z) in enumerate(positions):
+                f.write(f"{name},{frames[i]},{i / fps:.6f},{x:.3f},{y:.3f},{z:.3f}\n")
+
+
+def write_json(path, fps, frames, samples):
+    data = {
+        "fps": fps,
+        "frame_start": frames[0],
+        "objects": {name: [[round(v, 3) for v in p] for p in positions] for name, positions in samples.items()},
+    }
+    with open(path, "w") as f:
+        json.dump(data, f)
+
+
+def main():
+    scene = bpy.context.scene
+    objects = sorted(bpy.context.selected_objects, key=lambda o: o.name)
+    if not objects:
+        print("bake_trajectories: select at least one object to bake")
+        return
+
+    fps, frames, samples = bake(objects, scene)
+    path = bpy.path.abspath(OUTPUT_PATH)
+    if os.path.splitext(path)[1].lower() == ".json":
+        write_json(path, fps, frames, samples)
+    else:
+        write_csv(path, fps, frames, samples)
+    print(f"bake_trajectories: wrote {len(objects)} objects x {len(frames)} frames @ {fps:g} fps to {path}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,193 @@
+#include "BatchRenderer.h"
+
+/**
+ * @brief Starts a new frame of primitives.
+ */
+void BatchRenderer::begin()
+{
+	triangles.mode = GL_TRIANGLES;
+	triangles.clear();
+	for (auto& batch : lines)
+		batch->clear();
+}
+
+/**
+ * @brief Uploads what changed and draws every batch: filled shapes first, then lines.
+ */
+void BatchRenderer::end()
+{
+	draw_calls = 0;
+	bytes_uploaded = 0;
+
+	ofPushStyle();
+	bytes_uploaded += triangles.upload();
+	if (!triangles.vertices.empty()) {
+		triangles.vbo.draw(GL_TRIANGLES, 0, triangles.vertices.size());
+		draw_calls++;
+	}
+	for (auto& batch : lines) {
+		bytes_uploaded += batch->upload();
+		if (batch->vertices.empty())
+			continue;
+		ofSetLineWidth(batch->width);
+		batch->vbo.draw(GL_LINES, 0, batch->vertices.size());
+		draw_calls++;
+	}
+	ofPopStyle();
+}
+
+void BatchRenderer::add_line(const glm::vec3& a, const glm::vec3& b, const ofColor& color, float width)
+{
+	auto& batch = get_lines(width);
+	batch.vertices.push_back(a);
+	batch.vertices.push_back(b);
+	batch.colors.insert(batch.colors.end(), 2, ofFloatColor(color));
+}
+
+void BatchRenderer::add_polyline(const ofPolyline& line, const ofColor& color, float width)
+{
+	auto& vertices = line.getVertices();
+	if (!vertices.empty())
+		add_polyline(&vertices[0], vertices.size(), color, width, line.isClosed());
+}
+
+/**
+ * @brief Adds a line strip.
+ *
+ * @param (glm::vec3*)  points: contiguous points
+ * @param (size_t)  size: number of points
+ * @param (ofColor)  color
+ * @param (float)  width: line width
+ * @param (bool)  closed: also join the last point to the first
+ */
+void BatchRenderer::add_polyline(const glm::vec3* points, size_t size, const ofColor& color, float width, bool closed)
+{
+	if (size < 2)
+		return;
+	auto& batch = get_lines(width);
+	size_t segments = closed ? size : size - 1;
+	batch.vertices.reserve(batch.vertices.size() + 2 * segments);
+	for (size_t i = 0; i < segments; i++) {
+		batch.vertices.push_back(points[i]);
+		batch.vertices.push_back(points[(i + 1) % size]);
+	}
+	batch.colors.insert(batch.colors.end(), 2 * segments, ofFloatColor(color));
+}
+
+/**
+ * @brief Adds an ellipse facing the camera's default view (in the XY plane), like ofDrawEllipse.
+ */
+void BatchRenderer::add_ellipse(const glm::vec3& center, float width, float height, const ofColor& color, bool filled, float line_width)
+{
+	if (unit_circle.size() != resolution) {
+		unit_circle.clear();
+		for (int i = 0; i < resolution; i++)
+			unit_circle.push_back(glm::vec2(cos(TWO_PI * i / resolution), sin(TWO_PI * i / resolution)));
+	}
+
+	auto& batch = filled ? triangles : get_lines(line_width);
+	glm::vec3 radius(width / 2, height / 2, 1);
+	for (int i = 0; i < resolution; i++) {
+		glm::vec3 a = center + radius * glm::vec3(unit_circle[i], 0);
+		glm::vec3 b = center + radius * glm::vec3(unit_circle[(i + 1) % resolution], 0);
+		if (filled)
+			batch.vertices.push_back(center);
+		batch.vertices.push_back(a);
+		batch.vertices.push_back(b);
+	}
+	batch.colors.insert(batch.colors.end(), (filled ? 3 : 2) * resolution, ofFloatColor(color));
+}
+
+void BatchRenderer::add_rectangle(const glm::vec3& position, float width, float height, const ofColor& color, bool filled, float line_width)
+{
+	glm::vec3 corners[4] = { position, position + glm::vec3(width, 0, 0), position + glm::vec3(width, height, 0), position + glm::vec3(0, height, 0) };
+	if (!filled) {
+		add_polyline(corners, 4, color, line_width, true);
+		return;
+	}
+	for (int i : { 0, 1, 2, 0, 2, 3 })
+		triangles.vertices.push_back(corners[i]);
+	triangles.colors.insert(triangles.colors.end(), 6, ofFloatColor(color));
+}
+
+/**
+ * @brief Adds an axis-aligned cube, like ofDrawBox(center, size).
+ */
+void BatchRenderer::add_box(const glm::vec3& center, float size, const ofColor& color, bool filled, float line_width)
+{
+	float h = size / 2;
+	glm::vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+		corners[i] = center + glm::vec3(i & 1 ? h : -h, i & 2 ? h : -h, i & 4 ? h : -h);
+
+	if (filled) {
+		static const int faces[36] = {
+			0, 1, 3, 0, 3, 2,	4, 6, 7, 4, 7, 5,	// -z, +z
+			0, 4, 5, 0, 5, 1,	2, 3, 7, 2, 7, 6,	// -y, +y
+			0, 2, 6, 0, 6, 4,	1, 5, 7, 1, 7, 3	// -x, +x
+		};
+		for (int i : faces)
+			triangles.vertices.push_back(corners[i]);
+		triangles.colors.insert(triangles.colors.end(), 36, ofFloatColor(color));
+	}
+	else {
+		static const int edges[24] = { 0, 1, 1, 3, 3, 2, 2, 0,	4, 5, 5, 7, 7, 6, 6, 4,	0, 4, 1, 5, 2, 6, 3, 7 };
+		auto& batch = get_lines(line_width);
+		for (int i : edges)
+			batch.vertices.push_back(corners[i]);
+		batch.colors.insert(batch.colors.end(), 24, ofFloatColor(color));
+	}
+}
+
+BatchRenderer::Batch& BatchRenderer::get_lines(float width)
+{
+	auto it = lines.begin();
+	for (; it != lines.end() && (*it)->width <= width; it++) {
+		if ((*it)->width == width)
+			return **it;
+	}
+	auto batch = make_unique<Batch>();
+	batch->width = width;
+	return **lines.insert(it, move(batch));
+}
+
+/**
+ * @brief Uploads the range of vertices that changed since the last upload.
+ *
+ * @return (size_t)  bytes uploaded
+ */
+size_t BatchRenderer::Batch::upload()
+{
+	size_t n = vertices.size();
+	if (n == 0)
+		return 0;
+
+	// reallocate (with headroom) when the batch outgrows the buffer
+	if (n > vertices_uploaded.capacity() || !vbo.getIsAllocated()) {
+		vertices_uploaded.reserve(n + n / 2);
+		colors_uploaded.reserve(n + n / 2);
+		vertices_uploaded = vertices;
+		colors_uploaded = colors;
+		vertices_uploaded.resize(vertices_uploaded.capacity());
+		colors_uploaded.resize(colors_uploaded.capacity());
+		vbo.setVertexData(&vertices_uploaded[0], vertices_uploaded.size(), GL_DYNAMIC_DRAW);
+		vbo.setColorData(&colors_uploaded[0], colors_uploaded.size(), GL_DYNAMIC_DRAW);
+		return vertices_uploaded.size() * (sizeof(glm::vec3) + sizeof(ofFloatColor));
+	}
+
+	size_t first = 0;
+	while (first < n && vertices[first] == vertices_uploaded[first] && colors[first] == colors_uploaded[first])
+		first++;
+	if (first == n)
+		return 0;
+	size_t last = n;
+	while (last > first && vertices[last - 1] == vertices_uploaded[last - 1] && colors[last - 1] == colors_uploaded[last - 1])
+		last--;
+
+	size_t count = last - first;
+	copy(vertices.begin() + first, vertices.begin() + last, vertices_uploaded.begin() + first);
+	copy(colors.begin() + first, colors.begin() + last, colors_uploaded.begin() + first);
+	vbo.getVertexBuffer().updateData(first * sizeof(glm::vec3), count * sizeof(glm::vec3), &vertices[first]);
+	vbo.getColorBuffer().updateData(first * sizeof(ofFloatColor), count * sizeof(ofFloatColor), &colors[first]);
+	return count * (sizeof(glm::vec3) + sizeof(ofFloatColor));
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ofMain.h"
+
+/**
+ * @brief Batches a frame's lines and shapes into one VBO per primitive type.
+ *
+ * Callers add primitives between begin() and end() instead of drawing them
+ * one at a time. end() draws all filled shapes in one call, then the lines,
+ * one call per line width, so the number of draw calls stays fixed however
+ * many robots, cables and paths are on screen.
+ *
+ * The vertex buffers persist across frames: end() only uploads the range of
+ * vertices that changed since the last frame, and reallocates only when a
+ * batch outgrows its buffer.
+ *
+ * Vertices are in the coordinate system current at end().
+ */
+class BatchRenderer
+{
+public:
+	void begin();
+	void end();
+
+	void add_line(const glm::vec3& a, const glm::vec3& b, const ofColor& color, float width = 1);
+	void add_polyline(const ofPolyline& line, const ofColor& color, float width = 1);
+	void add_polyline(const glm::vec3* points, size_t size, const ofColor& color, float width = 1, bool closed = false);
+	void add_ellipse(const glm::vec3& center, float width, float height, const ofColor& color, bool filled = true, float line_width = 1);
+	void add_rectangle(const glm::vec3& position, float width, float height, const ofColor& color, bool filled = true, float line_width = 1);
+	void add_box(const glm::vec3& center, float size, const ofColor& color, bool filled = true, float line_width = 1);
+
+	int get_draw_calls() { return draw_calls; }			// in the last frame
+	size_t get_bytes_uploaded() { return bytes_uploaded; }	// in the last frame
+
+	int resolution = 32;		// segments per ellipse
+
+private:
+	struct Batch {
+		GLenum mode = GL_LINES;
+		float width = 1;
+		vector<glm::vec3> vertices;
+		vector<ofFloatColor> colors;
+
+		// what the GPU holds, to find the changed range
+		ofVbo vbo;
+		vector<glm::vec3> vertices_uploaded;
+		vector<ofFloatColor> colors_uploaded;
+
+		size_t upload();
+		void clear() { vertices.clear(); colors.clear(); }
+	};
+
+	Batch triangles;
+	vector<unique_ptr<Batch>> lines;	// one per line width, thinnest first
+	Batch& get_lines(float width);
+
+	vector<glm::vec2> unit_circle;		// cached for the current resolution
+
+	int draw_calls = 0;
+	size_t bytes_uploaded = 0;
+};
@@ -0,0 +1,90 @@
+#include "Benchmark.h"
+
+volatile char Benchmark::sink = 0;
+
+/**
+ * @brief Reads the benchmark settings from the command line:
+ * --benchmark [--label name] [--min-time s] [--repetitions n] [--threshold %]
+ */
+Benchmark::Settings Benchmark::Settings::parse_args(int argc, char* argv[])
+{
+	Settings settings;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool has_val = i + 1 < argc;
+		if (arg == "--benchmark")
+			settings.enabled = true;
+		else if (arg == "--label" && has_val)
+			settings.label = argv[++i];
+		else if (arg == "--min-time" && has_val)
+			settings.min_time = MAX(0.001f, ofToFloat(argv[++i]));
+		else if (arg == "--repetitions" && has_val)
+			settings.repetitions = MAX(1, ofToInt(argv[++i]));
+		else if (arg == "--threshold" && has_val)
+			settings.threshold = ofToFloat(argv[++i]);
+	}
+	return settings;
+}
+
+void Benchmark::setup(Settings settings)
+{
+	this->settings = settings;
+	results.clear();
+}
+
+/**
+ * @brief Compares the results against the last recorded run, appends them to the history and logs a summary.
+ *
+ * @param (string)  filename: history CSV in the local /bin/data folder. Defaults to "benchmark_history.csv"
+ * @return (bool)  false if any benchmark slowed down past the threshold.
+ */
+bool Benchmark::report(string filename)
+{
+	// find the last recorded time of each benchmark
+	map<string, double> previous;
+	bool is_new = !ofFile::doesFileExist(filename);
+	if (!is_new) {
+		ofBuffer buffer = ofBufferFromFile(filename);
+		for (auto line : buffer.getLines()) {
+			auto vals = ofSplitString(line, ",", false, true);
+			if (vals.size() < 4 || vals[0] == "time")
+				continue;
+			previous[vals[2]] = ofToDouble(vals[3]);
+		}
+	}
+
+	bool pass = true;
+	stringstream ss;
+	ss << "benchmark,ns_per_op,previous,change\n";
+	for (auto& result : results) {
+		ss << result.name << "," << ofToString(result.ns_per_op, 1) << ",";
+		auto it = previous.find(result.name);
+		if (it == previous.end() || it->second <= 0) {
+			ss << "-,-\n";
+			continue;
+		}
+		result.ns_previous = it->second;
+		float change = 100 * (result.ns_per_op - result.ns_previous) / result.ns_previous;
+		ss << ofToString(result.ns_previous, 1) << "," << (change >= 0 ? "+" : "") << ofToString(change, 1) << "%";
+		if (change > settings.threshold) {
+			ss << " REGRESSION";
+			pass = false;
+		}
+		ss << "\n";
+	}
+	ofLogNotice("Benchmark::report") << (settings.label.empty() ? "" : settings.label + "\n") << ss.str();
+
+	ofFile history;
+	if (!history.open(filename, ofFile::Append, false)) {
+		ofLogError("Benchmark::report") << "Could not open: /bin/data/" << filename;
+		return pass;
+	}
+	if (is_new)
+		history << "time,label,benchmark,ns_per_op,ns_min,ns_max,iterations\n";
+	string time = ofGetTimestampString("%Y-%m-%d %H:%M:%S");
+	for (auto& result : results) {
+		history << time << "," << settings.label << "," << result.name << ",";
+		history << result.ns_per_op << "," << result.ns_min << "," << result.ns_max << "," << result.iterations << "\n";
+	}
+	return pass;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ofMain.h"
+
+/**
+ * @brief Micro-benchmark runner for the control loop's hot path.
+ *
+ * Each benchmark is timed in batches: the batch size doubles until one batch
+ * takes at least min_time, then several batches are timed and the median time
+ * per operation is kept. Results are appended to a history CSV with a label
+ * (e.g. the commit being tested), and compared against the last recorded run
+ * of the same benchmark, so a regression shows up as a flagged slowdown.
+ */
+class Benchmark
+{
+public:
+	struct Settings {
+		bool enabled = false;
+		string label;				// tag for this run in the history, e.g. a commit hash
+		float min_time = 0.1;		// s per timed batch
+		int repetitions = 5;		// timed batches per benchmark
+		float threshold = 10;		// % slowdown vs. the last run that counts as a regression
+
+		static Settings parse_args(int argc, char* argv[]);
+	};
+
+	struct Result {
+		string name;
+		uint64_t iterations = 0;	// per batch
+		double ns_per_op = 0;		// median over the batches
+		double ns_min = 0;
+		double ns_max = 0;
+		double ns_previous = -1;	// last recorded run, -1 if none
+	};
+
+	void setup(Settings settings);
+
+	/**
+	 * @brief Times one operation.
+	 *
+	 * @param (string)  name: benchmark name, stable across runs
+	 * @param (F)  fn: operation to time; return results through keep() so they aren't optimized out
+	 */
+	template<typename F>
+	void run(string name, F fn) {
+		uint64_t n = 1;
+		double elapsed = 0;
+		while (true) {
+			elapsed = time_batch(fn, n);
+			if (elapsed >= settings.min_time * 1e9 || n >= (1ull << 40))
+				break;
+			// jump toward the target batch size, at most 10x at a time
+			n = elapsed > 0 ? MIN(n * 10, MAX(n + 1, uint64_t(n * 1.4 * settings.min_time * 1e9 / elapsed))) : n * 10;
+		}
+
+		vector<double> samples;
+		for (int i = 0; i < MAX(1, settings.repetitions); i++)
+			samples.push_back(time_batch(fn, n) / n);
+		sort(samples.begin(), samples.end());
+
+		Result result;
+		result.name = name;
+		result.iterations = n;
+		result.ns_per_op = samples[samples.size() / 2];
+		result.ns_min = samples.front();
+		result.ns_max = samples.back();
+		results.push_back(result);
+		ofLogNotice("Benchmark") << name << ": " << ofToString(result.ns_per_op, 1) << " ns/op (" << n << " iterations)";
+	}
+
+	/**
+	 * @brief Forces a result to be computed, by reading it through a volatile pointer.
+	 */
+	template<typename T>
+	static void keep(const T& val) {
+		sink = *reinterpret_cast<const volatile char*>(&val);
+	}
+
+	bool report(string filename = "benchmark_history.csv");
+	vector<Result> get_results() { return results; }
+
+private:
+	Settings settings;
+	vector<Result> results;
+	static volatile char sink;
+
+	template<typename F>
+	double time_batch(F& fn, uint64_t n) {
+		auto start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < n; i++)
+			fn();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+};
@@ -0,0 +1,330 @@
+#include "LatencyTrace.h"
+
+const string LatencyTrace::stage_names[LatencyTrace::NUM_STAGES] = {
+	"osc_receive", "target_set", "kinematics_update", "tick_start", "cmd_submit", "cmd_response", "tick_end"
+};
+
+std::atomic<bool> LatencyTrace::enabled{ false };
+std::atomic<uint32_t> LatencyTrace::next_id{ 1 };
+std::atomic<uint32_t> LatencyTrace::handed[LatencyTrace::NUM_STAGES];
+std::mutex LatencyTrace::mutex_rings;
+vector<unique_ptr<LatencyTrace::Ring>> LatencyTrace::rings;
+
+//--------------------------------------------------------------
+void LatencyHistogram::add(int64_t ns, uint64_t n)
+{
+	if (ns < 0)
+		ns = 0;
+	buckets[get_index(ns)] += n;
+	count += n;
+	max = MAX(max, ns);
+}
+
+void LatencyHistogram::reset()
+{
+	memset(buckets, 0, sizeof(buckets));
+	count = 0;
+	max = 0;
+}
+
+/**
+ * @brief Returns the recorded value at a percentile.
+ *
+ * @param (float)  p: percentile, in range [0, 100]
+ * @return (int64_t)  lower bound of the bucket holding the percentile (ns)
+ */
+int64_t LatencyHistogram::get_percentile(float p) const
+{
+	if (count == 0)
+		return 0;
+	uint64_t rank = MAX(1.0, ceil(ofClamp(p, 0, 100) / 100.0 * count));
+	uint64_t sum = 0;
+	for (int i = 0; i < NUM_BUCKETS; i++) {
+		sum += buckets[i];
+		if (sum >= rank)
+			return MIN(get_value(i), max);
+	}
+	return max;
+}
+
+int LatencyHistogram::get_index(uint64_t val)
+{
+	if (val < (1 << SUB_BITS))
+		return val;
+	int msb = 0;
+	while (val >> (msb + 1))
+		msb++;
+	int exp = msb - (SUB_BITS - 1);
+	return (exp << (SUB_BITS - 1)) + (val >> exp);
+}
+
+uint64_t LatencyHistogram::get_value(int index)
+{
+	if (index < (1 << SUB_BITS))
+		return index;
+	int exp = (index >> (SUB_BITS - 1)) - 1;
+	uint64_t mantissa = (index & ((1 << (SUB_BITS - 1)) - 1)) + (1 << (SUB_BITS - 1));
+	return mantissa << exp;
+}
+
+//--------------------------------------------------------------
+/**
+ * @brief Opens a new trace on this thread and records its first stage.
+ * Call where an external command enters the app.
+ */
+void LatencyTrace::begin(Stage stage)
+{
+	if (!is_enabled())
+		return;
+	auto ring = get_ring();
+	ring->open = next_id.fetch_add(1, std::memory_order_relaxed);
+	record(ring, stage);
+}
+
+/**
+ * @brief Picks up the trace last closed at an upstream stage, if this thread hasn't seen it yet.
+ *
+ * @param (Stage)  from: stage that handed the trace off
+ * @return (bool)  True if a new trace was opened on this thread.
+ */
+bool LatencyTrace::resume(Stage from)
+{
+	if (!is_enabled())
+		return false;
+	uint32_t id = handed[from].load(std::memory_order_acquire);
+	auto ring = get_ring();
+	if (id == 0 || id == ring->last_resumed)
+		return false;
+	ring->last_resumed = id;
+	ring->open = id;
+	return true;
+}
+
+/**
+ * @brief Records a stage against this thread's open trace. Does nothing if no trace is open.
+ */
+void LatencyTrace::mark(Stage stage)
+{
+	if (!is_enabled())
+		return;
+	auto ring = get_ring();
+	if (ring->open != 0)
+		record(ring, stage);
+}
+
+/**
+ * @brief Records a stage, hands the trace off to downstream threads, and closes it on this thread.
+ */
+void LatencyTrace::end(Stage stage)
+{
+	if (!is_enabled())
+		return;
+	auto ring = get_ring();
+	if (ring->open == 0)
+		return;
+	record(ring, stage);
+	handed[stage].store(ring->open, std::memory_order_release);
+	ring->open = 0;
+}
+
+/**
+ * @brief Names the calling thread in exported traces.
+ */
+void LatencyTrace::set_thread_name(string name)
+{
+	auto ring = get_ring();
+	std::lock_guard<std::mutex> lock(mutex_rings);
+	ring->name = name;
+}
+
+LatencyTrace::Ring* LatencyTrace::get_ring()
+{
+	thread_local Ring* ring = nullptr;
+	if (ring == nullptr) {
+		std::lock_guard<std::mutex> lock(mutex_rings);
+		rings.push_back(make_unique<Ring>());
+		ring = rings.back().get();
+		ring->index = rings.size() - 1;
+		ring->name = "thread_" + ofToString(ring->index);
+	}
+	return ring;
+}
+
+void LatencyTrace::record(Ring* ring, Stage stage)
+{
+	uint64_t head = ring->head.load(std::memory_order_relaxed);
+	if (head - ring->tail.load(std::memory_order_acquire) >= Ring::CAPACITY) {
+		ring->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	auto& e = ring->events[head % Ring::CAPACITY];
+	e.time = now();
+	e.id = ring->open;
+	e.stage = stage;
+	e.thread = ring->index;
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+int64_t LatencyTrace::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//--------------------------------------------------------------
+/**
+ * @brief Drains every thread's ring and scores the traces that have had time to complete.
+ * Call periodically from one thread (e.g. the GUI).
+ */
+void LatencyTrace::collect()
+{
+	vector<Ring*> snapshot;
+	{
+		std::lock_guard<std::mutex> lock(mutex_rings);
+		for (auto& ring : rings)
+			snapshot.push_back(ring.get());
+	}
+
+	for (auto ring : snapshot) {
+		uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+		uint64_t head = ring->head.load(std::memory_order_acquire);
+		for (; tail != head; tail++) {
+			auto& e = ring->events[tail % Ring::CAPACITY];
+			history.push_back(e);
+
+			// keep the first time each stage was reached
+			auto it = pending.find(e.id);
+			if (it == pending.end()) {
+				array<int64_t, NUM_STAGES> times;
+				times.fill(0);
+				it = pending.emplace(e.id, times).first;
+			}
+			auto& t = it->second[e.stage];
+			if (t == 0 || e.time < t)
+				t = e.time;
+		}
+		ring->tail.store(tail, std::memory_order_release);
+	}
+	while (history.size() > HISTORY_MAX)
+		history.pop_front();
+
+	int64_t t_now = now();
+	for (auto it = pending.begin(); it != pending.end();) {
+		int64_t t_first = 0;
+		for (auto t : it->second)
+			if (t != 0 && (t_first == 0 || t < t_first))
+				t_first = t;
+		if (t_now - t_first > TRACE_WINDOW) {
+			score(it->second);
+			it = pending.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+}
+
+void LatencyTrace::score(const array<int64_t, NUM_STAGES>& times)
+{
+	for (int i = 1; i < NUM_STAGES; i++) {
+		if (times[i] != 0 && times[i - 1] != 0)
+			histograms[i].add(times[i] - times[i - 1]);
+	}
+	if (times[OSC_RECEIVE] != 0 && times[CMD_SUBMIT] != 0)
+		end_to_end.add(times[CMD_SUBMIT] - times[OSC_RECEIVE]);
+}
+
+void LatencyTrace::reset()
+{
+	history.clear();
+	pending.clear();
+	for (auto& histogram : histograms)
+		histogram.reset();
+	end_to_end.reset();
+}
+
+/**
+ * @brief Returns one line per stage: p50 / p99 / max latency from the previous stage (ms).
+ */
+string LatencyTrace::get_summary() const
+{
+	auto ms = [](int64_t ns) { return ofToString(ns / 1000000.0, 2); };
+	auto line = [&ms](string name, const LatencyHistogram& h) {
+		return name + ": " + ms(h.get_percentile(50)) + " / " + ms(h.get_percentile(99)) + " / " + ms(h.get_max()) + " ms (n=" + ofToString(h.get_count()) + ")\n";
+	};
+
+	string summary;
+	for (int i = 1; i < NUM_STAGES; i++)
+		summary += line(stage_names[i - 1] + " -> " + stage_names[i], histograms[i]);
+	summary += line("end_to_end", end_to_end);
+	return summary;
+}
+
+uint64_t LatencyTrace::get_num_dropped() const
+{
+	std::lock_guard<std::mutex> lock(mutex_rings);
+	uint64_t dropped = 0;
+	for (auto& ring : rings)
+		dropped += ring->dropped.load(std::memory_order_relaxed);
+	return dropped;
+}
+
+/**
+ * @brief Writes the collected events as Chrome trace JSON.
+ * Control ticks and motor commands are duration events; the other stages are instants.
+ *
+ * @param (string)  filename: file saved to local /bin/data folder. Defaults to a timestamped name.
+ * @return (bool)  True if the file was written.
+ */
+bool LatencyTrace::export_chrome_trace(string filename)
+{
+	if (filename == "")
+		filename = "latency_trace_" + ofGetTimestampString("%Y%m%d_%H%M%S") + ".json";
+
+	ofFile file(filename, ofFile::WriteOnly, false);
+	if (!file.is_open()) {
+		ofLogError(__FUNCTION__) << "Could not open " << filename;
+		return false;
+	}
+
+	int64_t t_0 = history.empty() ? 0 : history.front().time;
+	for (auto& e : history)
+		t_0 = MIN(t_0, e.time);
+
+	file << "{\"traceEvents\":[\n";
+	{
+		std::lock_guard<std::mutex> lock(mutex_rings);
+		for (auto& ring : rings)
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << ring->index << ",\"args\":{\"name\":\"" << ring->name << "\"}},\n";
+	}
+	for (auto& e : history) {
+		string name = stage_names[e.stage];
+		string phase = "i";
+		if (e.stage == TICK_START || e.stage == TICK_END) {
+			name = "control_tick";
+			phase = e.stage == TICK_START ? "B" : "E";
+		}
+		else if (e.stage == CMD_SUBMIT || e.stage == CMD_RESPONSE) {
+			name = "MoveVelStart";
+			phase = e.stage == CMD_SUBMIT ? "B" : "E";
+		}
+		file << "{\"name\":\"" << name << "\",\"ph\":\"" << phase << "\",\"pid\":0,\"tid\":" << e.thread;
+		file << ",\"ts\":" << ofToString((e.time - t_0) / 1000.0, 3);
+		if (phase == "i")
+			file << ",\"s\":\"t\"";
+		file << ",\"args\":{\"id\":" << e.id << "}},\n";
+	}
+	// trace viewers ignore the trailing metadata event, which keeps the commas simple
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"cable_robots\"}}\n";
+	file << "],\n\"otherData\":{";
+	auto ms = [](int64_t ns) { return ofToString(ns / 1000000.0, 3); };
+	for (int i = 1; i < NUM_STAGES; i++) {
+		file << "\"" << stage_names[i] << "_p50_ms\":" << ms(histograms[i].get_percentile(50)) << ",";
+		file << "\"" << stage_names[i] << "_p99_ms\":" << ms(histograms[i].get_percentile(99)) << ",";
+	}
+	file << "\"end_to_end_p50_ms\":" << ms(end_to_end.get_percentile(50)) << ",";
+	file << "\"end_to_end_p99_ms\":" << ms(end_to_end.get_percentile(99)) << ",";
+	file << "\"dropped_events\":" << get_num_dropped() << "}}\n";
+
+	ofLogNotice(__FUNCTION__) << "Exported " << history.size() << " trace events to: " << filename;
+	return true;
+}
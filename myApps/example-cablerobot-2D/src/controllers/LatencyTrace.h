@@ -0,0 +1,126 @@
+#pragma once
+
+#include "ofMain.h"
+
+/**
+ * @brief Log-linear latency histogram (HDR-style).
+ * Each power of two is split into 16 linear sub-buckets, so any recorded
+ * value is reported to within ~6%, from nanoseconds up to minutes.
+ */
+class LatencyHistogram
+{
+public:
+	static const int SUB_BITS = 5;
+	static const int NUM_BUCKETS = 64 << (SUB_BITS - 1);
+
+	void add(int64_t ns, uint64_t n = 1);
+	void reset();
+
+	int64_t get_percentile(float p) const;	// ns, p in [0, 100]
+	int64_t get_max() const { return max; }
+	uint64_t get_count() const { return count; }
+
+	static int get_index(uint64_t val);
+	static uint64_t get_value(int index);
+
+private:
+	uint64_t buckets[NUM_BUCKETS] = { 0 };
+	uint64_t count = 0;
+	int64_t max = 0;
+};
+
+/**
+ * @brief End-to-end latency trace from an OSC message to the motor command it causes.
+ *
+ * Trace points are static calls that timestamp a stage into a lock-free ring
+ * owned by the calling thread, so recording never blocks the control loop.
+ * A trace id is opened where a message arrives, handed from thread to thread
+ * as the target moves through the pipeline, and closed at the end of each
+ * thread's stage:
+ *
+ *   OSC_RECEIVE -> TARGET_SET              (app thread)
+ *   -> KINEMATICS_UPDATE                   (RobotController thread)
+ *   -> TICK_START -> CMD_SUBMIT -> CMD_RESPONSE -> TICK_END  (CableRobot2D threads)
+ *
+ * An aggregator instance drains the rings, builds a histogram of the latency
+ * between consecutive stages, and exports the raw events as a Chrome trace
+ * (load it in chrome://tracing or ui.perfetto.dev).
+ */
+class LatencyTrace
+{
+public:
+	enum Stage {
+		OSC_RECEIVE = 0,
+		TARGET_SET,
+		KINEMATICS_UPDATE,
+		TICK_START,
+		CMD_SUBMIT,
+		CMD_RESPONSE,
+		TICK_END,
+		NUM_STAGES
+	};
+	static const string stage_names[NUM_STAGES];
+
+	// trace points (any thread)
+	static void begin(Stage stage);
+	static bool resume(Stage from);
+	static void mark(Stage stage);
+	static void end(Stage stage);
+
+	static void set_thread_name(string name);
+	static void set_enabled(bool val) { enabled.store(val, std::memory_order_relaxed); }
+	static bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+	// aggregator (one thread)
+	void collect();
+	void reset();
+	bool export_chrome_trace(string filename = "");
+
+	const LatencyHistogram& get_histogram(Stage stage) const { return histograms[stage]; }
+	const LatencyHistogram& get_end_to_end() const { return end_to_end; }
+	string get_summary() const;
+	uint64_t get_num_dropped() const;
+
+private:
+	struct Event {
+		int64_t time;		// ns, steady clock
+		uint32_t id;
+		uint16_t stage;
+		uint16_t thread;
+	};
+
+	/**
+	 * @brief Single-producer, single-consumer ring owned by one thread.
+	 * Events are dropped (and counted) rather than blocking when it is full.
+	 */
+	struct Ring {
+		static const uint64_t CAPACITY = 4096;
+		Event events[CAPACITY];
+		std::atomic<uint64_t> head{ 0 };
+		std::atomic<uint64_t> tail{ 0 };
+		std::atomic<uint64_t> dropped{ 0 };
+		uint32_t open = 0;			// id this thread is currently tracing
+		uint32_t last_resumed = 0;
+		uint16_t index = 0;
+		string name;
+	};
+
+	static std::atomic<bool> enabled;
+	static std::atomic<uint32_t> next_id;
+	static std::atomic<uint32_t> handed[NUM_STAGES];	// last id closed at each stage
+	static std::mutex mutex_rings;
+	static vector<unique_ptr<Ring>> rings;
+
+	static Ring* get_ring();
+	static void record(Ring* ring, Stage stage);
+	static int64_t now();
+
+	// aggregator state
+	static const int HISTORY_MAX = 200000;
+	static const int64_t TRACE_WINDOW = 1000000000;		// ns before a trace is scored
+	deque<Event> history;
+	unordered_map<uint32_t, array<int64_t, NUM_STAGES>> pending;
+	LatencyHistogram histograms[NUM_STAGES];	// [stage] = latency from the previous stage
+	LatencyHistogram end_to_end;				// OSC_RECEIVE -> CMD_SUBMIT
+	void score(const array<int64_t, NUM_STAGES>& times);
+};
@@ -14,12 +14,13 @@ PD_Controller::~PD_Controller()
 
 void PD_Controller::update(float setpoint)
 {
+	uint64_t now = ofGetElapsedTimeMicros();
 	if (last_time != 0) {
-		float diff = (ofGetElapsedTimef() - last_time);
+		float diff = (now - last_time) / 1000000.0;
 		//cout << diff << endl;
 		time_diff = MIN(diff, 1 / 15.); // <-- set a max time step so the PD controller doesn't explode
 	}
-	last_time = ofGetElapsedTimef();
+	last_time = now;
 	this->setpoint = setpoint;
 	pd_val += (kp * (setpoint - smoothed_val) + kd * (-1 * pd_val)) * time_diff;
 	smoothed_val += pd_val * steering_scalar;
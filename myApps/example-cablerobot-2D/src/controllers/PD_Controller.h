@@ -25,6 +25,6 @@ private:
 	float smoothed_val = 0;
 	float pd_val = 0;
 
-	float last_time = 0;
+	uint64_t last_time = 0;	// us
 
 };
\ No newline at end of file
@@ -35,10 +35,9 @@ void TimeSeriesPlot::draw()
 
 	// Draw Labels
 	ofDrawBitmapStringHighlight(name, 0, -15);
-	ofFill();
-	ofSetColor(255, 40);
-	ofDrawRectangle(0, 0, width, height);
-	ofDrawLine(0, height / 2, width, height / 2);
+	batch.begin();
+	batch.add_rectangle(glm::vec3(0), width, height, ofColor(255, 40));
+	batch.add_line(glm::vec3(0, height / 2, 0), glm::vec3(width, height / 2, 0), ofColor(255, 40));
 	float offset_y = 7;
 	ofDrawBitmapStringHighlight(ofToString(max), -20, 0 + offset_y);
 	ofDrawBitmapStringHighlight(ofToString((max + min) / 2), -23, height / 2 + offset_y);
@@ -46,25 +45,20 @@ void TimeSeriesPlot::draw()
 
 
 	// Draw Data
-	ofNoFill();
 	float step = width / resolution;
 	for (int i = 0; i < data.size(); i++) {
-		if (i % 2 == 0) {
-			ofSetLineWidth(7);
-			ofSetColor(colors[i], 120);
-		}
-		else {
-			ofSetLineWidth(2);
-			ofSetColor(colors[i]);
-		}
-		ofBeginShape();
+		points.clear();
 		for (int j = 0; j < data[i].size(); j++) {
 			float x = j * step;
 			float y = ofMap(data[i][j], min, max, 0, height);
-			ofVertex(x, y);
+			points.push_back(glm::vec3(x, y, 0));
 		}
-		ofEndShape();
+		if (i % 2 == 0)
+			batch.add_polyline(points.data(), points.size(), ofColor(colors[i], 120), 7);
+		else
+			batch.add_polyline(points.data(), points.size(), colors[i], 2);
 	}
+	batch.end();
 
 	ofPopStyle();
 }
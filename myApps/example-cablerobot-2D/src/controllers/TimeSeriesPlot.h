@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ofMain.h"
+#include "BatchRenderer.h"
 
 class TimeSeriesPlot
 {
@@ -28,4 +29,7 @@ public:
 private:
 	void setup();
 
+	BatchRenderer batch;
+	vector<glm::vec3> points;	// scratch for one channel
+
 };
\ No newline at end of file
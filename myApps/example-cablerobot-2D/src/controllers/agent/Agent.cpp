@@ -5,6 +5,8 @@
 void Agent::setup(int id) {
 	this->id = id;
     pose.setGlobalPosition(0, -2500, 0);
+    own_trail.setup(1, 200);
+    trail = own_trail.get(0);
 	setup_gui();
 }
 
@@ -12,40 +14,44 @@ void Agent::setup(int id) {
 void Agent::setup(int id, ofNode _pose) {
     this->id = id;
     this->pose = _pose;
+    own_trail.setup(1, 200);
+    trail = own_trail.get(0);
     
     setup_gui();
 }
 
+//--------------------------------------------------------------
+void Agent::set_trail(TrailArena::Trail _trail) {
+    trail = _trail;
+    own_trail.setup(0, 0);
+}
+
 //--------------------------------------------------------------
 void Agent::update() {
 
 
-    // update the agent's trail
+    // update the agent's trail (a full trail drops its oldest point)
+    auto pos = pose.getGlobalPosition();
     if (trail.size() == 0){//}&& pose.getGlobalPosition().y < -2500) {
-        trail.push_back(ofNode(pose));
+        trail.push(pos, ofGetElapsedTimef());
     }
     else {
-        auto pt = trail.begin()->getGlobalPosition();
-        auto dist_sq = glm::distance2(pt, pose.getGlobalPosition());
+        auto dist_sq = glm::distance2(trail.front(), pos);
         float dist_thresh = 50;
         if (dist_sq > dist_thresh * dist_thresh) {
-            trail.push_back(ofNode(pose));
+            trail.push(pos, ofGetElapsedTimef());
         }
     }
-
-    //trail.push_back(ofNode(pose));
-    if (trail.size() > 200)
-        trail.erase(trail.begin());
 }
 
 //--------------------------------------------------------------
-void Agent::draw() {
+void Agent::draw(BatchRenderer& batch) {
 
 	ofPushStyle();
 	ofSetColor(color);
     ofNoFill();
 
-    draw_body();
+    draw_body(batch);
     draw_radius();
     if (show_debug)
         draw_debugging();
@@ -55,7 +61,7 @@ void Agent::draw() {
 
 //--------------------------------------------------------------
 // move towards a given target using PD Controller
-void Agent::move(vector<Agent*> agents, ofNode target) {
+void Agent::move(const SpatialHash& neighbors, ofNode target) {
     
     // update current pos and desired pos
     ofVec3f pos = pose.getGlobalPosition();
@@ -63,7 +69,7 @@ void Agent::move(vector<Agent*> agents, ofNode target) {
     desired_pos.set(target.getGlobalPosition());
     
     // check if we need to separate the agent from its neighbors
-    curr_vel += separate(agents);
+    curr_vel += steer(neighbors);
     if (curr_pos.z > 0)
         curr_vel += gravity;
     
@@ -127,6 +133,22 @@ ofVec3f Agent::separate(vector<Agent*> agents){
     return ofVec3f();
 }
 
+//--------------------------------------------------------------
+// same as separate(agents), but only checks the agents in nearby cells
+ofVec3f Agent::separate(const SpatialHash& neighbors){
+    return ofVec3f(neighbors.separate(id));
+}
+
+//--------------------------------------------------------------
+ofVec3f Agent::steer(const SpatialHash& neighbors){
+    ofVec3f force = separate(neighbors);
+    if (cohesion > 0)
+        force += cohesion * ofVec3f(neighbors.cohere(id, 2 * radius));
+    if (alignment > 0)
+        force += alignment * ofVec3f(neighbors.align(id, 2 * radius));
+    return force;
+}
+
 void Agent::apply_forces(ofVec3f _gravity){
     gravity.set(_gravity);
 }
@@ -160,6 +182,8 @@ void Agent::setup_gui()
     params.add(kp.set("Proportional_Gains", 1, 0, 3));    // PD controller gains for Propotional Component
     params.add(kd.set("Derivative_Gains", 2.5, 0, 5));      // PD controller gains for Derivitive Component
     params.add(steering_scalar.set("Steering_Scalar", 1.0, 0,5));
+    params.add(cohesion.set("Cohesion", 0, 0, 1));
+    params.add(alignment.set("Alignment", 0, 0, 1));
     
     color = ofColor::aqua;
 }
@@ -173,22 +197,18 @@ void Agent::set_params(float _radius, float _kp, float _kd, float _steering){
 }
 
 //--------------------------------------------------------------
-void Agent::draw_body() {
-    // draw the trail
-    ofBeginShape();
-    for (auto &v: trail)
-        ofVertex(v.getGlobalPosition().x, v.getGlobalPosition().y, v.getGlobalPosition().z);
-    ofEndShape();
+void Agent::draw_body(BatchRenderer& batch) {
+    // draw the trail (the second span continues the first)
+    auto spans = trail.get_points();
+    batch.add_polyline(spans[0].data, spans[0].size, color);
+    if (!spans[1].empty()) {
+        batch.add_line(spans[0].data[spans[0].size - 1], spans[1].data[0], color);
+        batch.add_polyline(spans[1].data, spans[1].size, color);
+    }
     
     // draw the pose
-    ofEnableDepthTest();
-    ofFill();
-    ofSetColor(255);
-    ofDrawBox(pose.getGlobalPosition(), 35);
-    ofNoFill();
-    ofSetColor(color);
-    ofDrawBox(pose.getGlobalPosition(), 38);
-    ofDisableDepthTest();
+    batch.add_box(pose.getGlobalPosition(), 35, ofColor(255));
+    batch.add_box(pose.getGlobalPosition(), 38, color, false);
 
 //    pose.draw();
 }
@@ -234,7 +254,7 @@ void Agent::reset(ofBoxPrimitive bounds) {
 
 	pose.setGlobalPosition(random_pt);
 	pose.setGlobalOrientation(ofQuaternion(0, 0, 0, 1));
-	trail.push_back(ofNode(pose));
+	trail.push(random_pt, ofGetElapsedTimef());
 };
 
 //--------------------------------------------------------------
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "ofMain.h"
+#include "SpatialHash.h"
+#include "TrailArena.h"
+#include "../BatchRenderer.h"
 
 
 class Agent  {
@@ -11,14 +14,18 @@ class Agent  {
         void setup(int id);
         void setup(int id, ofNode _pose);
         void update();
-        void draw();
+        void draw(BatchRenderer& batch);
         void reset(ofBoxPrimitive bounds);
     
         int id = 0;
         ofNode pose = ofNode();
 
-        void move(vector<Agent*> agents, ofNode target);   // move towards a given target using PD Controller
-        ofVec3f separate(vector<Agent*> agents);
+        void move(const SpatialHash& neighbors, ofNode target);   // move towards a given target using PD Controller
+        ofVec3f separate(vector<Agent*> agents);                  // checks every agent; reference for the spatial hash
+        ofVec3f separate(const SpatialHash& neighbors);
+        ofVec3f steer(const SpatialHash& neighbors);              // separation, cohesion and alignment
+        ofVec3f get_velocity() { return curr_vel; }
+        void set_velocity(ofVec3f vel) { curr_vel = vel; }
         void apply_forces(ofVec3f _gravity);
     
         string toString();    
@@ -28,10 +35,12 @@ class Agent  {
         ofParameter<float> radius;
         ofParameter<float> kp, kd;
         ofParameter<float> steering_scalar;
+        ofParameter<float> cohesion, alignment;     // flocking weights, within 2x the radius
 
         void set_params(float _radius, float _kp, float _kd, float _steering);
 
-        vector<ofNode> trail;
+        TrailArena::Trail trail;
+        void set_trail(TrailArena::Trail _trail);   // share an arena with other agents
     
 private:
     
@@ -53,9 +62,11 @@ private:
     
         ofColor color;
     
-        void draw_body();
+        void draw_body(BatchRenderer& batch);
         void draw_radius();
         void draw_debugging();
 
         bool show_debug = false;
+
+        TrailArena own_trail;   // used until set_trail is called
 };
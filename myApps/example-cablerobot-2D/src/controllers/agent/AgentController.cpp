@@ -14,9 +14,18 @@ void AgentController::setup(int num_agents)
 	for (int i=0; i<NUM_AGENTS; i++){
         agents.push_back(new Agent());
         agents[i]->setup(i);
-        
-        targets.push_back(ofNode());
-        targets[i] = agents[i]->pose;
+    }
+
+    trails.setup(NUM_AGENTS, 200);
+    for (int i=0; i<NUM_AGENTS; i++){
+        agents[i]->set_trail(trails.get(i));
+    }
+
+    // the agents start on their targets
+    integrator.resize(NUM_AGENTS);
+    for (int i=0; i<NUM_AGENTS; i++){
+        integrator.set_position(i, agents[i]->pose.getGlobalPosition());
+        integrator.set_target(i, agents[i]->pose.getGlobalPosition());
     }
 	
     setup_gui();
@@ -25,26 +34,41 @@ void AgentController::setup(int num_agents)
 //--------------------------------------------------------------
 void AgentController::update()
 {
+    // snapshot every agent before any of them moves
+    neighbors.clear();
+    neighbors.reserve(NUM_AGENTS);
+    for (int i=0; i<NUM_AGENTS; i++){
+        neighbors.add(integrator.get_position(i), integrator.get_velocity(i), agents[i]->radius);
+    }
+    neighbors.build();
+
     for (int i=0; i<NUM_AGENTS; i++){
-        
-        agents[i]->apply_forces(gravity);
-        
-        agents[i]->move(agents, targets[i]);
-        
         // update the  agent params with agent 0
         if (match_all){
             agents[i]->set_params(agents[0]->radius, agents[0]->kp, agents[0]->kd, agents[0]->steering_scalar);
         }
+        integrator.set_velocity(i, integrator.get_velocity(i) + glm::vec3(agents[i]->steer(neighbors)));
+        integrator.set_gains(i, agents[i]->kp, agents[i]->kd, agents[i]->steering_scalar);
+    }
+
+    // move every agent at once
+    integrator.num_threads = num_threads;
+    integrator.step(dt, gravity.get());
 
+    for (int i=0; i<NUM_AGENTS; i++){
+        agents[i]->pose.setGlobalPosition(integrator.get_position(i));
+        agents[i]->set_velocity(integrator.get_velocity(i));
         agents[i]->update();
-    }    
+    }
 }
 
 void AgentController::update(vector<glm::vec3> curr_positions)
 {
     // check if we need to remove a trail target
     for (int i = 0; i < curr_positions.size(); i++) {
-        auto pt = agents[i]->trail.begin()->getGlobalPosition();
+        if (agents[i]->trail.empty())
+            continue;
+        auto pt = agents[i]->trail.front();
         glm::vec2 start = glm::vec2(pt.x, pt.y);
         glm::vec2 end = glm::vec2(curr_positions[i].x, curr_positions[i].y);
         auto dist_sq = glm::distance2(start, end);
@@ -58,10 +82,10 @@ void AgentController::update(vector<glm::vec3> curr_positions)
 }
 
 //--------------------------------------------------------------
-void AgentController::draw()
+void AgentController::draw(BatchRenderer& batch)
 {
     for (int i=0; i<NUM_AGENTS; i++){
-        agents[i]->draw();
+        agents[i]->draw(batch);
     }
 }
 
@@ -71,6 +95,7 @@ void AgentController::setup_gui()
     params.setName("Agent_Controller");
     params.add(gravity.set("Gravity", ofVec3f(0,0,0), ofVec3f(-20,-20,-20), ofVec3f()));
     params.add(match_all.set("Match_All_Params", false));
+    params.add(num_threads.set("Threads", 1, 1, 8));
     
     for (int i=0; i<NUM_AGENTS; i++){        
         params.add(agents[i]->params);
@@ -81,10 +106,7 @@ void AgentController::setup_gui()
 void AgentController::set_targets(vector<ofMatrix4x4*> tgts)
 {
     for (int i=0; i<NUM_AGENTS; i++){
-        ofNode tgt;
-        //    tgt.setGlobalOrientation(target->getRotate());
-        tgt.setGlobalPosition(tgts[i]->getTranslation());
-        targets[i] = tgt;
+        integrator.set_target(i, tgts[i]->getTranslation());
     }
 }
 
@@ -92,7 +114,7 @@ void AgentController::set_targets(vector<ofMatrix4x4*> tgts)
 void AgentController::set_targets(vector<ofNode*> tgts)
 {
     for (int i = 0; i < NUM_AGENTS; i++) {
-        targets[i] = *tgts[i];
+        integrator.set_target(i, tgts[i]->getGlobalPosition());
     }
 }
 
@@ -100,19 +122,14 @@ void AgentController::set_targets(vector<ofNode*> tgts)
 void AgentController::set_targets(vector<glm::vec3*> tgts)
 {
     for (int i = 0; i < NUM_AGENTS; i++) {
-        ofNode tgt;
-        tgt.setGlobalPosition(*tgts[i]);
-        targets[i] = tgt;
-
+        integrator.set_target(i, *tgts[i]);
     }
 }
 
 void AgentController::set_target(int i, glm::vec3* tgt)
 {
     if (i < NUM_AGENTS) {
-        ofNode node;
-        node.setGlobalPosition(*tgt);
-        targets[i] = node;
+        integrator.set_target(i, *tgt);
     }
 }
 
@@ -120,7 +137,7 @@ void AgentController::remove_trail_pt(int index)
 { 
 
     if (index < NUM_AGENTS && agents[index]->trail.size() > 0) {
-        agents[index]->trail.erase(agents[index]->trail.begin());
+        agents[index]->trail.pop_front();
     }
 }
 
@@ -130,7 +147,7 @@ vector<glm::vec3> AgentController::get_trail_targets()
     for (int i = 0; i < NUM_AGENTS; i++) {
         glm::vec3 pos;
         if (agents[i]->trail.size() > 0) {
-            pos = agents[i]->trail.begin()->getGlobalPosition();
+            pos = agents[i]->trail.front();
         }
         else {
             pos = agents[i]->pose.getGlobalPosition();
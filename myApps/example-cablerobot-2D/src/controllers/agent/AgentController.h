@@ -3,6 +3,7 @@
 #include "ofMain.h"
 #include "ofxGui.h"
 #include "Agent.h"
+#include "AgentIntegrator.h"
 
 class AgentController
 {
@@ -13,7 +14,7 @@ public:
 	void setup(int num_agents);
 	void update();
     void update(vector<glm::vec3> curr_positions);
-	void draw();
+	void draw(BatchRenderer& batch);
     
     void set_targets(vector<ofMatrix4x4*> tgts);
     void set_targets(vector<ofNode*> tgts);
@@ -31,11 +32,15 @@ private:
     int NUM_AGENTS;
     
     vector<Agent*> agents;
-    vector<ofNode> targets;
+    SpatialHash neighbors;      // agent positions, rebuilt each frame for the neighbor queries
+    AgentIntegrator integrator; // agent state and steering, in SoA arrays
+    TrailArena trails;          // every agent's trail, in one block
+    float dt = 1/60.;
 
     void setup_gui();
 
     ofParameter<ofVec3f> gravity;
     ofParameter<bool> match_all;
+    ofParameter<int> num_threads;
 };
 
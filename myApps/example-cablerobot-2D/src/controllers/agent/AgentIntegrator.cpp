@@ -0,0 +1,163 @@
+#include "AgentIntegrator.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+void AgentIntegrator::resize(int n)
+{
+	for (auto v : { &px, &py, &pz, &vx, &vy, &vz, &tx, &ty, &tz })
+		v->resize(n, 0);
+	kp.resize(n, 1);
+	kd.resize(n, 2.5);
+	steering.resize(n, 1);
+}
+
+void AgentIntegrator::set_position(int i, const glm::vec3& position)
+{
+	px[i] = position.x; py[i] = position.y; pz[i] = position.z;
+}
+
+void AgentIntegrator::set_velocity(int i, const glm::vec3& velocity)
+{
+	vx[i] = velocity.x; vy[i] = velocity.y; vz[i] = velocity.z;
+}
+
+void AgentIntegrator::set_target(int i, const glm::vec3& target)
+{
+	tx[i] = target.x; ty[i] = target.y; tz[i] = target.z;
+}
+
+void AgentIntegrator::set_gains(int i, float kp, float kd, float steering)
+{
+	this->kp[i] = kp;
+	this->kd[i] = kd;
+	this->steering[i] = steering;
+}
+
+/**
+ * @brief Returns true if the integrator was built with AVX2.
+ */
+bool AgentIntegrator::is_vectorized()
+{
+#ifdef __AVX2__
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * @brief Moves every agent one time step toward its target.
+ *
+ * @param (float)  dt: time step (s)
+ * @param (glm::vec3)  gravity: added to the velocity of agents above z = 0
+ */
+void AgentIntegrator::step(float dt, glm::vec3 gravity)
+{
+	int n = size();
+	int threads = MIN(num_threads, n / MAX(1, min_per_thread));
+	if (threads <= 1) {
+		step_range(0, n, dt, gravity);
+		return;
+	}
+
+	// chunks start on a multiple of 8, so every thread's SIMD loads stay aligned
+	int chunk = ((n + threads - 1) / threads + 7) & ~7;
+	vector<std::thread> workers;
+	for (int begin = chunk; begin < n; begin += chunk)
+		workers.emplace_back(&AgentIntegrator::step_range, this, begin, MIN(n, begin + chunk), dt, gravity);
+	step_range(0, MIN(n, chunk), dt, gravity);
+	for (auto& worker : workers)
+		worker.join();
+}
+
+/**
+ * @brief Integrates agents [begin, end). Same steering as Agent::update_desired_vel,
+ * Agent::update_current_vel and Agent::update_position.
+ */
+void AgentIntegrator::step_range(int begin, int end, float dt, glm::vec3 gravity)
+{
+	int i = begin;
+
+#ifdef __AVX2__
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1);
+	const __m256 minus_one = _mm256_set1_ps(-1);
+	const __m256 h = _mm256_set1_ps(dt);
+	const __m256 gx = _mm256_set1_ps(gravity.x), gy = _mm256_set1_ps(gravity.y), gz = _mm256_set1_ps(gravity.z);
+	for (; i + 8 <= end; i += 8) {
+		__m256 x = _mm256_load_ps(&px[i]), y = _mm256_load_ps(&py[i]), z = _mm256_load_ps(&pz[i]);
+		__m256 u = _mm256_load_ps(&vx[i]), v = _mm256_load_ps(&vy[i]), w = _mm256_load_ps(&vz[i]);
+
+		// gravity only pulls agents above the floor
+		__m256 above = _mm256_cmp_ps(z, zero, _CMP_GT_OQ);
+		u = _mm256_add_ps(u, _mm256_and_ps(above, gx));
+		v = _mm256_add_ps(v, _mm256_and_ps(above, gy));
+		w = _mm256_add_ps(w, _mm256_and_ps(above, gz));
+
+		// heading to the target, and the velocity projected onto it
+		__m256 hx = _mm256_sub_ps(_mm256_load_ps(&tx[i]), x);
+		__m256 hy = _mm256_sub_ps(_mm256_load_ps(&ty[i]), y);
+		__m256 hz = _mm256_sub_ps(_mm256_load_ps(&tz[i]), z);
+		__m256 len_sq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(hx, hx), _mm256_mul_ps(hy, hy)), _mm256_mul_ps(hz, hz));
+		__m256 nonzero = _mm256_cmp_ps(len_sq, zero, _CMP_GT_OQ);
+		__m256 inv_len = _mm256_div_ps(one, _mm256_sqrt_ps(len_sq));
+		__m256 nx = _mm256_and_ps(nonzero, _mm256_mul_ps(hx, inv_len));
+		__m256 ny = _mm256_and_ps(nonzero, _mm256_mul_ps(hy, inv_len));
+		__m256 nz = _mm256_and_ps(nonzero, _mm256_mul_ps(hz, inv_len));
+		__m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(u, nx), _mm256_mul_ps(v, ny)), _mm256_mul_ps(w, nz));
+		__m256 bx = _mm256_mul_ps(nx, s), by = _mm256_mul_ps(ny, s), bz = _mm256_mul_ps(nz, s);
+
+		// keep the projected velocity if it closes on the target, otherwise brake
+		__m256 ex = _mm256_sub_ps(bx, hx), ey = _mm256_sub_ps(by, hy), ez = _mm256_sub_ps(bz, hz);
+		__m256 projected_sq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey)), _mm256_mul_ps(ez, ez));
+		__m256 sign = _mm256_blendv_ps(minus_one, one, _mm256_cmp_ps(len_sq, projected_sq, _CMP_GT_OQ));
+
+		// PD acceleration
+		__m256 p = _mm256_load_ps(&kp[i]), d = _mm256_load_ps(&kd[i]);
+		__m256 ax = _mm256_add_ps(_mm256_mul_ps(p, hx), _mm256_mul_ps(d, _mm256_sub_ps(_mm256_mul_ps(bx, sign), u)));
+		__m256 ay = _mm256_add_ps(_mm256_mul_ps(p, hy), _mm256_mul_ps(d, _mm256_sub_ps(_mm256_mul_ps(by, sign), v)));
+		__m256 az = _mm256_add_ps(_mm256_mul_ps(p, hz), _mm256_mul_ps(d, _mm256_sub_ps(_mm256_mul_ps(bz, sign), w)));
+		u = _mm256_add_ps(u, _mm256_mul_ps(ax, h));
+		v = _mm256_add_ps(v, _mm256_mul_ps(ay, h));
+		w = _mm256_add_ps(w, _mm256_mul_ps(az, h));
+
+		__m256 scale = _mm256_mul_ps(h, _mm256_load_ps(&steering[i]));
+		_mm256_store_ps(&px[i], _mm256_add_ps(x, _mm256_mul_ps(u, scale)));
+		_mm256_store_ps(&py[i], _mm256_add_ps(y, _mm256_mul_ps(v, scale)));
+		_mm256_store_ps(&pz[i], _mm256_add_ps(z, _mm256_mul_ps(w, scale)));
+		_mm256_store_ps(&vx[i], u);
+		_mm256_store_ps(&vy[i], v);
+		_mm256_store_ps(&vz[i], w);
+	}
+#endif
+
+	for (; i < end; i++) {
+		float u = vx[i], v = vy[i], w = vz[i];
+		if (pz[i] > 0) {
+			u += gravity.x; v += gravity.y; w += gravity.z;
+		}
+
+		float hx = tx[i] - px[i], hy = ty[i] - py[i], hz = tz[i] - pz[i];
+		float len_sq = hx * hx + hy * hy + hz * hz;
+		float nx = 0, ny = 0, nz = 0;
+		if (len_sq > 0) {
+			float inv_len = 1 / sqrt(len_sq);
+			nx = hx * inv_len; ny = hy * inv_len; nz = hz * inv_len;
+		}
+		float s = u * nx + v * ny + w * nz;
+		float bx = nx * s, by = ny * s, bz = nz * s;
+
+		float ex = bx - hx, ey = by - hy, ez = bz - hz;
+		float sign = len_sq > ex * ex + ey * ey + ez * ez ? 1 : -1;
+
+		u += (kp[i] * hx + kd[i] * (bx * sign - u)) * dt;
+		v += (kp[i] * hy + kd[i] * (by * sign - v)) * dt;
+		w += (kp[i] * hz + kd[i] * (bz * sign - w)) * dt;
+
+		float scale = dt * steering[i];
+		px[i] += u * scale; py[i] += v * scale; pz[i] += w * scale;
+		vx[i] = u; vy[i] = v; vz[i] = w;
+	}
+}
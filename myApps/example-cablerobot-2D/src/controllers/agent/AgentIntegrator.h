@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ofMain.h"
+
+/**
+ * @brief Allocator for SIMD-aligned arrays.
+ */
+template<typename T, size_t Alignment = 32>
+struct AlignedAllocator {
+	typedef T value_type;
+	template<typename U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+	AlignedAllocator() {}
+	template<typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+	void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+	template<typename U> bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+	template<typename U> bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+template<typename T>
+using AlignedVector = vector<T, AlignedAllocator<T>>;
+
+/**
+ * @brief Data-oriented PD steering integrator for a crowd of agents.
+ *
+ * Runs the same steering as Agent::move (minus the neighbor forces, which the
+ * caller adds to the velocities beforehand), over one aligned array per
+ * component. With AVX2 enabled at compile time it integrates 8 agents per
+ * instruction, otherwise a scalar loop runs the same math. Large crowds can
+ * also be split across threads.
+ */
+class AgentIntegrator
+{
+public:
+	void resize(int n);
+	int size() const { return px.size(); }
+
+	void set_position(int i, const glm::vec3& position);
+	void set_velocity(int i, const glm::vec3& velocity);
+	void set_target(int i, const glm::vec3& target);
+	void set_gains(int i, float kp, float kd, float steering);
+	glm::vec3 get_position(int i) const { return glm::vec3(px[i], py[i], pz[i]); }
+	glm::vec3 get_velocity(int i) const { return glm::vec3(vx[i], vy[i], vz[i]); }
+
+	void step(float dt, glm::vec3 gravity);
+
+	static bool is_vectorized();
+
+	int num_threads = 1;			// threads to split a step across
+	int min_per_thread = 16384;		// agents; smaller crowds aren't worth starting a thread
+
+	// agent state, in agent order
+	AlignedVector<float> px, py, pz;	// position (mm)
+	AlignedVector<float> vx, vy, vz;	// velocity
+	AlignedVector<float> tx, ty, tz;	// target position (mm)
+	AlignedVector<float> kp, kd;		// PD gains
+	AlignedVector<float> steering;		// velocity scalar
+
+private:
+	void step_range(int begin, int end, float dt, glm::vec3 gravity);
+};
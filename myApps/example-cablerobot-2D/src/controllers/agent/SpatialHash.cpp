@@ -0,0 +1,134 @@
+#include "SpatialHash.h"
+
+void SpatialHash::clear()
+{
+	x.clear(); y.clear(); z.clear();
+	vx.clear(); vy.clear(); vz.clear();
+	radius.clear();
+}
+
+void SpatialHash::reserve(int n)
+{
+	x.reserve(n); y.reserve(n); z.reserve(n);
+	vx.reserve(n); vy.reserve(n); vz.reserve(n);
+	radius.reserve(n);
+}
+
+void SpatialHash::add(const glm::vec3& position, const glm::vec3& velocity, float radius)
+{
+	x.push_back(position.x); y.push_back(position.y); z.push_back(position.z);
+	vx.push_back(velocity.x); vy.push_back(velocity.y); vz.push_back(velocity.z);
+	this->radius.push_back(radius);
+}
+
+/**
+ * @brief Buckets the agents added since clear(). Call once per frame, after adding every agent.
+ *
+ * @param (float)  cell_size: grid spacing (mm). Defaults to the largest separation distance, so
+ * separation only has to look at the neighboring cells.
+ */
+void SpatialHash::build(float cell_size)
+{
+	int n = size();
+	radius_max = 0;
+	for (int i = 0; i < n; i++)
+		radius_max = MAX(radius_max, radius[i]);
+	this->cell_size = cell_size > 0 ? cell_size : MAX(1.0f, 2 * radius_max);
+
+	// about two buckets per agent keeps collisions rare
+	uint32_t table_size = 1;
+	while (table_size < 2 * uint32_t(n))
+		table_size <<= 1;
+	mask = table_size - 1;
+
+	// counting sort by bucket
+	cell_start.assign(table_size + 1, 0);
+	bucket.resize(n);
+	for (int i = 0; i < n; i++) {
+		bucket[i] = get_bucket(get_cell(x[i]), get_cell(y[i]), get_cell(z[i]));
+		cell_start[bucket[i] + 1]++;
+	}
+	for (uint32_t b = 0; b < table_size; b++)
+		cell_start[b + 1] += cell_start[b];
+
+	sorted_index.resize(n);
+	sx.resize(n); sy.resize(n); sz.resize(n);
+	svx.resize(n); svy.resize(n); svz.resize(n);
+	sradius.resize(n);
+	vector<uint32_t> next(cell_start.begin(), cell_start.end() - 1);
+	for (int i = 0; i < n; i++) {
+		uint32_t k = next[bucket[i]]++;
+		sorted_index[k] = i;
+		sx[k] = x[i]; sy[k] = y[i]; sz[k] = z[i];
+		svx[k] = vx[i]; svy[k] = vy[i]; svz[k] = vz[i];
+		sradius[k] = radius[i];
+	}
+}
+
+/**
+ * @brief Averages the directions away from every agent overlapping agent i (their radii intersect).
+ *
+ * @param (int)  i: agent index, in the order added
+ * @return (glm::vec3)  average offset from the overlapping agents, or zero if there are none.
+ */
+glm::vec3 SpatialHash::separate(int i) const
+{
+	glm::vec3 sum(0);
+	int count = 0;
+	for_each_candidate(i, radius[i] + radius_max, [&](uint32_t k) {
+		float dx = x[i] - sx[k], dy = y[i] - sy[k], dz = z[i] - sz[k];
+		float reach = radius[i] + sradius[k];
+		if (dx * dx + dy * dy + dz * dz < reach * reach) {
+			sum += glm::vec3(dx, dy, dz);
+			count++;
+		}
+	});
+	return count != 0 ? sum / float(count) : glm::vec3(0);
+}
+
+/**
+ * @brief Points agent i toward the center of its neighbors.
+ *
+ * @param (int)  i: agent index, in the order added
+ * @param (float)  range: neighbor distance (mm)
+ * @return (glm::vec3)  offset to the neighbors' average position, or zero if there are none.
+ */
+glm::vec3 SpatialHash::cohere(int i, float range) const
+{
+	glm::vec3 sum(0);
+	int count = 0;
+	for_each_candidate(i, range, [&](uint32_t k) {
+		float dx = sx[k] - x[i], dy = sy[k] - y[i], dz = sz[k] - z[i];
+		if (dx * dx + dy * dy + dz * dz < range * range) {
+			sum += glm::vec3(sx[k], sy[k], sz[k]);
+			count++;
+		}
+	});
+	return count != 0 ? sum / float(count) - glm::vec3(x[i], y[i], z[i]) : glm::vec3(0);
+}
+
+/**
+ * @brief Steers agent i toward its neighbors' heading.
+ *
+ * @param (int)  i: agent index, in the order added
+ * @param (float)  range: neighbor distance (mm)
+ * @return (glm::vec3)  difference to the neighbors' average velocity, or zero if there are none.
+ */
+glm::vec3 SpatialHash::align(int i, float range) const
+{
+	glm::vec3 sum(0);
+	int count = 0;
+	for_each_candidate(i, range, [&](uint32_t k) {
+		float dx = sx[k] - x[i], dy = sy[k] - y[i], dz = sz[k] - z[i];
+		if (dx * dx + dy * dy + dz * dz < range * range) {
+			sum += glm::vec3(svx[k], svy[k], svz[k]);
+			count++;
+		}
+	});
+	return count != 0 ? sum / float(count) - glm::vec3(vx[i], vy[i], vz[i]) : glm::vec3(0);
+}
+
+uint32_t SpatialHash::get_bucket(int cx, int cy, int cz) const
+{
+	return (uint32_t(cx) * 73856093u ^ uint32_t(cy) * 19349663u ^ uint32_t(cz) * 83492791u) & mask;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ofMain.h"
+
+/**
+ * @brief Uniform-grid spatial hash for agent neighbor queries.
+ *
+ * Positions, velocities and radii are kept in contiguous arrays (one per
+ * component), rebuilt once per frame. build() buckets the agents by grid cell
+ * with a counting sort, and copies them into cell order, so a query only
+ * scans the few cells around an agent and reads them front to back.
+ *
+ * A frame of separation queries is O(N) for a bounded density of agents,
+ * instead of O(N^2) for checking every pair.
+ */
+class SpatialHash
+{
+public:
+	void clear();
+	void reserve(int n);
+	void add(const glm::vec3& position, const glm::vec3& velocity, float radius);
+	void build(float cell_size = 0);
+
+	int size() const { return x.size(); }
+	float get_cell_size() const { return cell_size; }
+
+	glm::vec3 separate(int i) const;
+	glm::vec3 cohere(int i, float range) const;
+	glm::vec3 align(int i, float range) const;
+
+	// agent state, in the order added
+	vector<float> x, y, z;
+	vector<float> vx, vy, vz;
+	vector<float> radius;
+
+private:
+	float cell_size = 1;
+	float radius_max = 0;
+	uint32_t mask = 0;				// table size - 1 (a power of two)
+
+	vector<uint32_t> cell_start;	// per bucket, first entry in the sorted arrays (+1 sentinel)
+	vector<uint32_t> bucket;		// per agent, its bucket
+
+	// agent state copied into bucket order
+	vector<int> sorted_index;
+	vector<float> sx, sy, sz;
+	vector<float> svx, svy, svz;
+	vector<float> sradius;
+
+	uint32_t get_bucket(int cx, int cy, int cz) const;
+	int get_cell(float v) const { return int(floor(v / cell_size)); }
+
+	/**
+	 * @brief Calls fn(j) for every other agent in the cells within range of agent i.
+	 * Each bucket is visited once, even if several cells hash to it.
+	 */
+	template<typename F>
+	void for_each_candidate(int i, float range, F fn) const {
+		if (cell_start.empty())
+			return;
+		int rings = MAX(1, int(ceil(range / cell_size)));
+		int cx = get_cell(x[i]), cy = get_cell(y[i]), cz = get_cell(z[i]);
+
+		// a small ring fits on the stack; cells that collide into one bucket are skipped
+		uint32_t visited_local[27];
+		vector<uint32_t> visited_heap;
+		int num_cells = (2 * rings + 1) * (2 * rings + 1) * (2 * rings + 1);
+		uint32_t* visited = visited_local;
+		if (num_cells > 27) {
+			visited_heap.resize(num_cells);
+			visited = visited_heap.data();
+		}
+		int num_visited = 0;
+
+		for (int dz = -rings; dz <= rings; dz++) {
+			for (int dy = -rings; dy <= rings; dy++) {
+				for (int dx = -rings; dx <= rings; dx++) {
+					uint32_t b = get_bucket(cx + dx, cy + dy, cz + dz);
+					if (find(visited, visited + num_visited, b) != visited + num_visited)
+						continue;
+					visited[num_visited++] = b;
+					for (uint32_t k = cell_start[b]; k < cell_start[b + 1]; k++) {
+						if (sorted_index[k] != i)
+							fn(k);
+					}
+				}
+			}
+		}
+	}
+};
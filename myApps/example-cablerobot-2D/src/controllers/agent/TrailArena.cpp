@@ -0,0 +1,65 @@
+#include "TrailArena.h"
+
+/**
+ * @brief Allocates every trail's storage at once.
+ *
+ * @param (int)  num_trails: number of trails (one per agent)
+ * @param (int)  capacity: points kept per trail
+ */
+void TrailArena::setup(int num_trails, int capacity)
+{
+	this->num_trails = num_trails;
+	this->capacity = MAX(1, capacity);
+	points.assign(size_t(num_trails) * this->capacity, glm::vec3(0));
+	times.assign(size_t(num_trails) * this->capacity, 0);
+}
+
+/**
+ * @brief Returns an empty trail over slice i of the arena.
+ */
+TrailArena::Trail TrailArena::get(int i)
+{
+	Trail trail;
+	if (i < 0 || i >= num_trails)
+		return trail;
+	trail.points = &points[size_t(i) * capacity];
+	trail.times = &times[size_t(i) * capacity];
+	trail.capacity = capacity;
+	return trail;
+}
+
+void TrailArena::Trail::push(const glm::vec3& point, float time)
+{
+	if (capacity == 0)
+		return;
+	uint32_t tail = (head + count) % capacity;
+	points[tail] = point;
+	times[tail] = time;
+	if (count < capacity)
+		count++;
+	else
+		head = (head + 1) % capacity;
+}
+
+void TrailArena::Trail::pop_front()
+{
+	if (count == 0)
+		return;
+	head = (head + 1) % capacity;
+	count--;
+}
+
+/**
+ * @brief Returns the trail's points, oldest first: the second span continues the first.
+ */
+array<TrailSpan<glm::vec3>, 2> TrailArena::Trail::get_points() const
+{
+	uint32_t first = MIN(count, capacity - head);
+	return { TrailSpan<glm::vec3>{ points + head, first }, TrailSpan<glm::vec3>{ points, count - first } };
+}
+
+array<TrailSpan<float>, 2> TrailArena::Trail::get_times() const
+{
+	uint32_t first = MIN(count, capacity - head);
+	return { TrailSpan<float>{ times + head, first }, TrailSpan<float>{ times, count - first } };
+}
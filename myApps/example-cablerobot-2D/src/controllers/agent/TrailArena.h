@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofMain.h"
+
+/**
+ * @brief Read-only view of contiguous trail points, for range-for loops.
+ */
+template<typename T>
+struct TrailSpan {
+	const T* data = nullptr;
+	size_t size = 0;
+
+	const T* begin() const { return data; }
+	const T* end() const { return data + size; }
+	bool empty() const { return size == 0; }
+};
+
+/**
+ * @brief Fixed-size trail storage for every agent, in one contiguous block.
+ *
+ * Each Trail is a ring buffer over its own slice of the arena: appending
+ * and dropping the oldest point are O(1) and never allocate. A trail's
+ * points wrap around the end of its slice, so it is read as two spans
+ * (oldest first), without copying.
+ *
+ * The arena must outlive its trails, and is not resized once set up.
+ */
+class TrailArena
+{
+public:
+	class Trail
+	{
+	public:
+		void push(const glm::vec3& point, float time);		// drops the oldest point when full
+		void pop_front();
+		void clear() { head = 0; count = 0; }
+
+		const glm::vec3& front() const { return points[head]; }
+		const glm::vec3& back() const { return points[(head + count - 1) % capacity]; }
+		float get_time_front() const { return times[head]; }
+		float get_time_back() const { return times[(head + count - 1) % capacity]; }
+
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		size_t get_capacity() const { return capacity; }
+
+		array<TrailSpan<glm::vec3>, 2> get_points() const;
+		array<TrailSpan<float>, 2> get_times() const;
+
+	private:
+		friend class TrailArena;
+		glm::vec3* points = nullptr;
+		float* times = nullptr;		// s, when each point was added
+		uint32_t capacity = 0;
+		uint32_t head = 0;			// oldest point
+		uint32_t count = 0;
+	};
+
+	void setup(int num_trails, int capacity);
+	Trail get(int i);
+	int size() const { return num_trails; }
+
+private:
+	vector<glm::vec3> points;
+	vector<float> times;
+	int num_trails = 0;
+	int capacity = 0;
+};
@@ -0,0 +1,322 @@
+#include "Choreography.h"
+
+Choreography::Choreography()
+{
+	params.setName("Choreography");
+	params.add(filename.set("File", "choreography.csv"));
+	params.add(status.set("Status", "EMPTY"));
+	params.add(btn_load.set("Load"));
+	params.add(play_enable.set("Play", false));
+	params.add(loop.set("Loop", false));
+
+	btn_load.addListener(this, &Choreography::on_load);
+	play_enable.addListener(this, &Choreography::on_play);
+}
+
+/**
+ * @brief Returns the position at time t, linearly interpolated between frames.
+ *
+ * @param (float)  t: time since the start of the trajectory (in seconds)
+ * @return (glm::vec3)  position (in mm)
+ */
+glm::vec3 Choreography::Trajectory::get_position(float t)
+{
+	if (positions.size() == 0)
+		return glm::vec3();
+	float f = ofClamp(t * fps, 0, positions.size() - 1);
+	int i = floor(f);
+	if (i >= positions.size() - 1)
+		return positions.back();
+	return glm::mix(positions[i], positions[i + 1], f - i);
+}
+
+/**
+ * @brief Loads a baked animation from the /bin/data folder.
+ * Files ending in .json are read as JSON, anything else as CSV.
+ *
+ * @param (string)  filename: file in the local /bin/data folder
+ * @return (bool)  true if at least one trajectory was loaded
+ */
+bool Choreography::load(string filename)
+{
+	stop();
+	clear();
+
+	string path = ofToDataPath(filename);
+	if (!ofFile::doesFileExist(path)) {
+		ofLogWarning(__FUNCTION__) << "No choreography file found at: /bin/data/" << filename;
+		status.set("FILE NOT FOUND");
+		return false;
+	}
+
+	bool success = ofFilePath::getFileExt(path) == "json" ? load_json(path) : load_csv(path);
+	if (!success || trajectories.size() == 0) {
+		ofLogWarning(__FUNCTION__) << "Could not read any trajectories from: /bin/data/" << filename;
+		status.set("INVALID FILE");
+		trajectories.clear();
+		return false;
+	}
+
+	// assign trajectories to robots by object name
+	sort(trajectories.begin(), trajectories.end(), [](const Trajectory& a, const Trajectory& b) { return a.name < b.name; });
+
+	ofLogNotice(__FUNCTION__) << "Loaded " << trajectories.size() << " trajectories from: /bin/data/" << filename;
+	for (int i = 0; i < trajectories.size(); i++) {
+		ofLogNotice(__FUNCTION__) << "\tRobot " << i << ": " << trajectories[i].name << ", " << trajectories[i].positions.size() << " frames @ " << trajectories[i].fps << " fps";
+	}
+	status.set("LOADED: " + ofToString(get_duration(), 1) + "s");
+	return true;
+}
+
+/**
+ * @brief Reads a CSV with a header row and one row per object per frame:
+ * object,frame,time,x,y,z
+ */
+bool Choreography::load_csv(string path)
+{
+	ofBuffer buffer = ofBufferFromFile(path);
+	map<string, int> indices;
+	map<string, float> first_time;
+	bool is_header = true;
+
+	for (auto line : buffer.getLines()) {
+		if (is_header) {
+			is_header = false;
+			continue;
+		}
+		auto vals = ofSplitString(line, ",", true, true);
+		if (vals.size() < 6)
+			continue;
+
+		string name = vals[0];
+		float time = ofToFloat(vals[2]);
+		glm::vec3 pos = glm::vec3(ofToFloat(vals[3]), ofToFloat(vals[4]), ofToFloat(vals[5]));
+
+		if (indices.find(name) == indices.end()) {
+			indices[name] = trajectories.size();
+			first_time[name] = time;
+			Trajectory traj;
+			traj.name = name;
+			trajectories.push_back(traj);
+		}
+		auto& traj = trajectories[indices[name]];
+		// recover the frame rate from the first two samples
+		if (traj.positions.size() == 1 && time > first_time[name])
+			traj.fps = 1.0 / (time - first_time[name]);
+		traj.positions.push_back(pos);
+	}
+	return true;
+}
+
+/**
+ * @brief Reads a JSON export:
+ * { "fps": 24, "objects": { "name": [[x, y, z], ...], ... } }
+ */
+bool Choreography::load_json(string path)
+{
+	ofJson json = ofLoadJson(path);
+	if (json.is_null() || json.find("objects") == json.end())
+		return false;
+
+	float fps = json.value("fps", 24.0f);
+	for (auto& obj : json["objects"].items()) {
+		Trajectory traj;
+		traj.name = obj.key();
+		traj.fps = fps;
+		for (auto& pt : obj.value()) {
+			if (pt.size() >= 3)
+				traj.positions.push_back(glm::vec3(pt[0].get<float>(), pt[1].get<float>(), pt[2].get<float>()));
+		}
+		trajectories.push_back(traj);
+	}
+	return true;
+}
+
+/**
+ * @brief Checks a trajectory against a 2D robot's motor limits and workspace.
+ * Cable lengths are computed from each anchor (drum tangent point) to the
+ * trajectory at every frame, then differentiated to get the motor RPM
+ * and RPM/s. The move from the robot's current pose to frame 0 is checked as
+ * if it happened in one frame, and every frame must stay inside the robot's
+ * bounds. Every violation is logged and stored in the violations list.
+ *
+ * @param (int)  i: index of the trajectory / robot
+ * @param (vector<glm::vec3>)  anchors: cable anchor positions (in world coordinates)
+ * @param (ofRectangle)  bounds: the robot's workspace (in world coordinates)
+ * @param (glm::vec3)  pose: the robot's current end effector position (in world coordinates)
+ * @param (float)  mm_per_rev: cable travel per motor revolution
+ * @param (float)  vel_limit: velocity limit (in RPM)
+ * @param (float)  accel_limit: acceleration limit (in RPM/s)
+ * @return (int)  number of violations found
+ */
+int Choreography::validate(int i, vector<glm::vec3> anchors, ofRectangle bounds, glm::vec3 pose, float mm_per_rev, float vel_limit, float accel_limit)
+{
+	if (i >= trajectories.size() || mm_per_rev <= 0)
+		return 0;
+
+	auto& traj = trajectories[i];
+	int count = 0;
+
+	// frames outside the workspace, by how far (in mm)
+	bounds.standardize();
+	for (int f = 0; f < traj.positions.size(); f++) {
+		glm::vec2 p = glm::vec2(traj.positions[f]);
+		glm::vec2 nearest = glm::clamp(p, glm::vec2(bounds.getLeft(), bounds.getTop()), glm::vec2(bounds.getRight(), bounds.getBottom()));
+		float outside = glm::distance(p, nearest);
+		if (outside > 0) {
+			violations.push_back({ i, f, "OUT_OF_BOUNDS", outside, 0 });
+			count++;
+		}
+	}
+
+	// the jump from where the robot is now to the first frame
+	if (traj.positions.size() > 0) {
+		for (auto& anchor : anchors) {
+			float length_0 = glm::distance(glm::vec2(anchor), glm::vec2(pose));
+			float length_1 = glm::distance(glm::vec2(anchor), glm::vec2(traj.positions[0]));
+			float rpm = (length_1 - length_0) * traj.fps / mm_per_rev * 60;
+			if (abs(rpm) > vel_limit) {
+				violations.push_back({ i, 0, "START_JUMP", rpm, vel_limit });
+				count++;
+			}
+		}
+	}
+
+	for (auto& anchor : anchors) {
+		float rpm_prev = 0;
+		for (int f = 1; f < traj.positions.size(); f++) {
+			float length_0 = glm::distance(glm::vec2(anchor), glm::vec2(traj.positions[f - 1]));
+			float length_1 = glm::distance(glm::vec2(anchor), glm::vec2(traj.positions[f]));
+			float rpm = (length_1 - length_0) * traj.fps / mm_per_rev * 60;
+			float rpm_per_sec = (f > 1) ? (rpm - rpm_prev) * traj.fps : 0;
+			rpm_prev = rpm;
+
+			if (abs(rpm) > vel_limit) {
+				violations.push_back({ i, f, "VELOCITY", rpm, vel_limit });
+				count++;
+			}
+			if (abs(rpm_per_sec) > accel_limit) {
+				violations.push_back({ i, f, "ACCELERATION", rpm_per_sec, accel_limit });
+				count++;
+			}
+		}
+	}
+
+	if (count > 0) {
+		ofLogWarning(__FUNCTION__) << "Robot " << i << " (" << traj.name << ") has " << count << " limit violations:";
+		for (auto& v : violations) {
+			if (v.robot == i)
+				ofLogWarning(__FUNCTION__) << "\tFrame " << v.frame << ": " << v.type << " " << ofToString(v.value, 2) << " exceeds " << ofToString(v.limit, 2);
+		}
+		status.set("INVALID: " + ofToString(violations.size()) + " VIOLATIONS");
+	}
+	return count;
+}
+
+void Choreography::clear()
+{
+	trajectories.clear();
+	violations.clear();
+	status.set("EMPTY");
+}
+
+void Choreography::play()
+{
+	if (trajectories.size() == 0) {
+		ofLogWarning(__FUNCTION__) << "No choreography loaded.";
+		play_enable.set(false);
+		return;
+	}
+	if (violations.size() > 0) {
+		ofLogWarning(__FUNCTION__) << "Playing choreography with " << violations.size() << " limit violations.";
+	}
+	time_start = ofGetElapsedTimef();
+	playing = true;
+}
+
+void Choreography::stop()
+{
+	playing = false;
+}
+
+/**
+ * @brief Returns the playback time, wrapping or stopping at the end.
+ *
+ * @return (float)  seconds since playback started
+ */
+float Choreography::get_time()
+{
+	if (!playing)
+		return 0;
+	float t = ofGetElapsedTimef() - time_start;
+	float duration = get_duration();
+	if (t > duration) {
+		if (loop && duration > 0) {
+			t = fmod(t, duration);
+		}
+		else {
+			t = duration;
+			play_enable.set(false);
+		}
+	}
+	return t;
+}
+
+float Choreography::get_duration()
+{
+	float duration = 0;
+	for (auto& traj : trajectories)
+		duration = MAX(duration, traj.get_duration());
+	return duration;
+}
+
+/**
+ * @brief Samples every trajectory at the current playback time.
+ *
+ * @return (vector<glm::vec3>)  one target per robot (in world coordinates)
+ */
+vector<glm::vec3> Choreography::get_targets()
+{
+	float t = get_time();
+	vector<glm::vec3> targets;
+	for (auto& traj : trajectories)
+		targets.push_back(traj.get_position(t));
+	return targets;
+}
+
+void Choreography::draw()
+{
+	if (trajectories.size() == 0)
+		return;
+
+	ofPushStyle();
+	ofNoFill();
+	ofSetLineWidth(1);
+	ofSetColor(ofColor::lightSkyBlue, 120);
+	for (auto& traj : trajectories) {
+		ofBeginShape();
+		for (auto& pt : traj.positions)
+			ofVertex(pt);
+		ofEndShape();
+	}
+
+	// highlight frames that break the motor limits
+	ofFill();
+	ofSetColor(ofColor::red);
+	for (auto& v : violations)
+		ofDrawEllipse(trajectories[v.robot].positions[v.frame], 15, 15);
+	ofPopStyle();
+}
+
+void Choreography::on_load()
+{
+	load(filename.get());
+}
+
+void Choreography::on_play(bool& val)
+{
+	if (val)
+		play();
+	else
+		stop();
+}
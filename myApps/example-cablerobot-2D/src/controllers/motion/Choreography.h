@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGui.h"
+
+/**
+ * @brief Loads baked animation exports (see blender_projects/bake_trajectories.py)
+ * and plays them back from memory as robot targets.
+ *
+ * Each animated object becomes one Trajectory: positions sampled at a fixed
+ * frame rate, in mm, in the same world coordinates as the robot targets.
+ * Trajectories are assigned to robots in the order of their object names.
+ */
+class Choreography
+{
+public:
+	Choreography();
+
+	struct Trajectory {
+		string name;
+		float fps = 24;
+		vector<glm::vec3> positions;
+
+		float get_duration() { return positions.size() > 1 ? (positions.size() - 1) / fps : 0; }
+		glm::vec3 get_position(float t);
+	};
+
+	struct Violation {
+		int robot;
+		int frame;
+		string type;
+		float value;
+		float limit;
+	};
+
+	bool load(string filename);
+	int validate(int i, vector<glm::vec3> anchors, ofRectangle bounds, glm::vec3 pose, float mm_per_rev, float vel_limit, float accel_limit);
+	void clear();
+
+	void play();
+	void stop();
+	bool is_playing() { return playing; }
+	float get_time();
+	float get_duration();
+	vector<glm::vec3> get_targets();
+
+	void draw();
+
+	vector<Trajectory> trajectories;
+	vector<Violation> violations;
+
+	ofParameterGroup params;
+	ofParameter<string> filename;
+	ofParameter<string> status;
+	ofParameter<void> btn_load;
+	ofParameter<bool> play_enable;
+	ofParameter<bool> loop;
+
+	void on_load();
+	void on_play(bool& val);
+
+private:
+	bool playing = false;
+	float time_start = 0;
+
+	bool load_csv(string path);
+	bool load_json(string path);
+};
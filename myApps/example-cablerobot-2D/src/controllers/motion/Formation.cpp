@@ -0,0 +1,95 @@
+#include "Formation.h"
+
+Formation::Formation()
+{
+	params.setName("Formation");
+	params.add(type.set("Type_(Chain,Line,Arc)", Type::CHAIN, Type::CHAIN, Type::ARC));
+	params.add(arc_radius.set("Arc_Radius", 1000, 1, 2000));
+	params.add(arc_angle_start.set("Arc_Start_Angle", 0, 0, 360));
+	params.add(arc_angle_end.set("Arc_End_Angle", 180, 0, 360));
+}
+
+void Formation::resize(int count)
+{
+	x.resize(count);
+	y.resize(count);
+}
+
+/**
+ * @brief Computes the targets of every robot in the formation.
+ *
+ * @param (glm::vec3)  leader: new target for the leader (last robot)
+ * @param (vector<glm::vec3>)  actual: estimated positions of the robots (same order as the targets)
+ * @param (float)  offset: spacing between robots (in mm). Below 50mm all robots share the leader's target.
+ */
+void Formation::update(glm::vec3 leader, const vector<glm::vec3>& actual, float offset)
+{
+	int count = x.size();
+	if (count == 0)
+		return;
+
+	int last = count - 1;
+	x[last] = leader.x;
+	y[last] = leader.y;
+
+	// trail behind the leader's direction of travel
+	if (last < actual.size()) {
+		glm::vec2 d = glm::vec2(actual[last].x - leader.x, actual[last].y - leader.y);
+		float len = glm::length(d);
+		if (len > 0.001)
+			heading = d / len;
+	}
+
+	if (offset < 50 && type != Type::ARC) {
+		for (int i = 0; i < last; i++) {
+			x[i] = leader.x;
+			y[i] = leader.y;
+		}
+		return;
+	}
+
+	switch (type) {
+	case Type::CHAIN:
+		// each follower trails the actual position of the robot in front,
+		// away from where that robot is heading next (as ofApp::update_path did).
+		// Unlike update_path, a robot in front that's already on its target
+		// doesn't give a heading, so its follower holds where it is.
+		for (int i = last - 1; i >= 0; i--) {
+			if (i + 1 >= actual.size())
+				break;
+			float ax = actual[i + 1].x;
+			float ay = actual[i + 1].y;
+			float dx = ax - x[i + 1];
+			float dy = ay - y[i + 1];
+			float len = sqrt(dx * dx + dy * dy);
+			if (len < 0.001) {
+				x[i] = actual[i].x;
+				y[i] = actual[i].y;
+				continue;
+			}
+			x[i] = ax + dx / len * offset;
+			y[i] = ay + dy / len * offset;
+		}
+		break;
+	case Type::LINE:
+		for (int i = last - 1; i >= 0; i--) {
+			float dist = (last - i) * offset;
+			x[i] = leader.x + heading.x * dist;
+			y[i] = leader.y + heading.y * dist;
+		}
+		break;
+	case Type::ARC: {
+		float start = ofDegToRad(arc_angle_start.get());
+		float step = count > 1 ? ofDegToRad(arc_angle_end.get() - arc_angle_start.get()) / last : 0;
+		float r = arc_radius.get();
+		for (int i = 0; i < count; i++) {
+			float theta = start + step * i;
+			x[i] = leader.x + r * cos(theta);
+			y[i] = leader.y + r * sin(theta);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
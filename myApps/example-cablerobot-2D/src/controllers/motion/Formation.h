@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGui.h"
+
+/**
+ * @brief Computes follower targets for a group of robots from a single leader point.
+ *
+ * All targets are computed in one pass and stored as flat x / y arrays, so
+ * they can be handed to the RobotController as one command frame.
+ * The leader is always the last robot; followers are ordered back to robot 0.
+ */
+class Formation
+{
+public:
+	Formation();
+
+	enum Type {
+		CHAIN = 0,	// each robot trails the one in front of it by an offset
+		LINE,		// rigid line trailing the leader's heading
+		ARC			// spread over an arc centered on the leader
+	};
+
+	void resize(int count);
+	void update(glm::vec3 leader, const vector<glm::vec3>& actual, float offset);
+	int size() { return x.size(); }
+
+	vector<float> x;
+	vector<float> y;
+
+	ofParameterGroup params;
+	ofParameter<int> type;
+	ofParameter<float> arc_radius;
+	ofParameter<float> arc_angle_start;
+	ofParameter<float> arc_angle_end;
+
+private:
+	glm::vec2 heading = glm::vec2(0, 1);	// last valid trailing direction of the leader
+};
@@ -59,14 +59,14 @@ MotionController::MotionController(vector<glm::vec3> bases, ofNode* _origin, flo
 	//	targets.push_back(&path.target);
 	//}
 
-	// setup default targets
-	for (int i = 0; i < 4; i++) {
+	// setup default targets, one per 2D robot (at least 4)
+	for (int i = 0; i < MAX(4, int(bases.size() / 2)); i++) {
 		targets.push_back(new glm::vec3(0, -2750, (i * offset_z)));
 	}
 
 	setup_motion_line();
 	setup_motion_circle();
-	setup_paths();
+	setup_paths(targets.size());
 	//setup_agents();
 	setup_eyes();
 }
@@ -181,7 +181,7 @@ void MotionController::update()
 }
 
 //--------------------------------------------------------------
-void MotionController::draw()
+void MotionController::draw(BatchRenderer& batch)
 {
 	//for (int i = 0; i < paths.size(); i++) {
 	//	paths[i].draw();
@@ -198,7 +198,7 @@ void MotionController::draw()
 		//if (motion_agents_follow) {
 		//	agents->draw();
 		//}
-		draw_paths();
+		draw_paths(batch);
 	}
 	//else if (motion_agents_follow) {
 	//	agents->draw();
@@ -266,8 +266,10 @@ void MotionController::scale(float scalar)
 void MotionController::setup_paths(int count)
 {
 	for (int i = 0; i < count; i++) {
-		paths_drawing.push_back(new ofPolyline());
+		paths_drawing.push_back(new PathQueue());
+		smoothers.push_back(new PathSmoother());
 	}
+	targets_drawing.resize(count);
 }
 
 void MotionController::update_paths()
@@ -275,13 +277,13 @@ void MotionController::update_paths()
 	for (int i = 0; i < paths_drawing.size(); i++) {
 		auto path = paths_drawing[i];
 		// cap the length of the path
-		if (path->getVertices().size() > motion_drawing_length_max.get()) {
-			path->removeVertex(0);
+		while (path->size() > motion_drawing_length_max.get()) {
+			path->pop();
 		}
 	}
 }
 
-void MotionController::draw_paths()
+void MotionController::draw_paths(BatchRenderer& batch)
 {
 	ofColor color;
 	for (int i = 0; i < paths_drawing.size(); i++) {
@@ -304,21 +306,15 @@ void MotionController::draw_paths()
 			color = ofColor::magenta;
 		}
 
-		ofPushStyle();
-
 		// draw the path
-		ofSetLineWidth(5);
-		ofNoFill();
-		ofSetColor(color, 180);
-		paths_drawing[i]->draw();
+		paths_drawing[i]->draw(batch, ofColor(color, 180), 5);
 
 		// draw the target
-		ofFill();
-		ofSetColor(ofColor::orange);
-		if (paths_drawing[i]->getVertices().size() > 0)
-			ofDrawEllipse(paths_drawing[i]->getVertices()[0], 30, 30);
-
-		ofPopStyle();
+		if (motion_drawing_smooth) {
+			smoothers[i]->draw(batch);
+		}
+		else if (!paths_drawing[i]->empty())
+			batch.add_ellipse(paths_drawing[i]->front(), 30, 30, ofColor::orange);
 	}
 }
 
@@ -326,6 +322,7 @@ void MotionController::clear_paths()
 {
 	for (int i = 0; i < paths_drawing.size(); i++) {
 		paths_drawing[i]->clear();
+		smoothers[i]->clear();
 	}
 }
 
@@ -358,18 +355,19 @@ void MotionController::add_to_path(int i, glm::vec3 pt)
 		//else {
 
 			glm::vec3 p;
-			if (path->getVertices().size() == 0) {
+			if (path->empty()) {
 				p = *targets[i];	// use the current target for distance thresholding
 			}
 			else {
-				p = path->getVertices().back();
+				p = path->back();
 			}
 			// filter out small moves
 			float dist_thresh = 45;
 			//float dist_sq = glm::distance2(path->getVertices().back(), pt);
 			float dist_sq = glm::distance2(p, pt);
 			if (dist_sq > dist_thresh * dist_thresh) {
-				path->addVertex(pt);
+				path->push(pt);
+				smoothers[i]->add_point(pt);
 			}
 		//}
 	}
@@ -379,25 +377,53 @@ void MotionController::add_to_path(int i, glm::vec3 pt)
  * @brief Checks if the actual 2D positions are close to the target positions.
  * If close, removes and then updates the new target positions.
  *
+ * When smoothing is enabled, the targets are instead advanced continuously
+ * along a spline through the drawing points, so the robots never decelerate
+ * at intermediate points.
+ *
  * @param ()  actual: Estimated position of the robots
  */
 void MotionController::update_targets(vector<glm::vec3> actual)
 {
+	float dt = ofGetLastFrameTime();
 	for (int i = 0; i < paths_drawing.size(); i++) {
 		auto path = paths_drawing[i];
-		if (path->getVertices().size() > 2) {	// <--- POLYLINE MUST HAVE AT LEAST 3 POINTS, OTHERWISE SENDS TO (0,0,0)
+		if (motion_drawing_smooth) {
+			auto smoother = smoothers[i];
+			if (!smoother->is_empty()) {
+				apply_smoothing(smoother);
+				targets_drawing[i] = smoother->update(dt);
+				targets[i] = &targets_drawing[i];
+			}
+		}
+		else if (!path->empty()) {
 			float dist_thresh = motion_drawing_accuracy.get();
-			glm::vec2 pt_0 = glm::vec2(path->getVertices()[0].x, path->getVertices()[0].y);
+			glm::vec2 pt_0 = glm::vec2(path->front().x, path->front().y);
 			glm::vec2 pt_1 = glm::vec2(actual[i].x, actual[i].y);
 			float dist_sq = glm::distance2(pt_0, pt_1);
-			if (dist_sq < dist_thresh * dist_thresh) {
-				path->removeVertex(0);
+			// hold the last point until a new one arrives
+			if (dist_sq < dist_thresh * dist_thresh && path->size() > 1) {
+				path->pop();
 			}
-			targets[i] = &path->getVertices()[0];
+			// copy the target out of the queue, so it stays valid after the next pop
+			targets_drawing[i] = path->front();
+			targets[i] = &targets_drawing[i];
 		}
 	}
 }
 
+/**
+ * @brief Copies the drawing smoothing limits from the GUI into a PathSmoother.
+ *
+ * @param (PathSmoother*)  smoother: smoother to configure
+ */
+void MotionController::apply_smoothing(PathSmoother* smoother)
+{
+	smoother->velocity_max = motion_drawing_velocity_max.get();
+	smoother->accel_max = motion_drawing_accel_max.get();
+	smoother->accel_lateral_max = motion_drawing_accel_lateral_max.get();
+}
+
 MotionController::MotionPath MotionController::create_polygon(ofNode centroid, float radius, float resolution, float offset_theta)
 {
 	MotionPath mp;
@@ -864,6 +890,10 @@ void MotionController::setup_gui()
 	params_motion_drawing.add(motion_drawing_offset.set("Follow_Offset", 50, 0, 1000));
 	params_motion_drawing.add(motion_drawing_accuracy.set("Accuracy", 50, 10, 100));
 	params_motion_drawing.add(motion_drawing_length_max.set("Length_Max", 250, 0, 500));
+	params_motion_drawing.add(motion_drawing_smooth.set("Enable_Smoothing", true));
+	params_motion_drawing.add(motion_drawing_velocity_max.set("Smooth_Vel_Max", 500, 10, 1500));
+	params_motion_drawing.add(motion_drawing_accel_max.set("Smooth_Accel_Max", 1000, 10, 5000));
+	params_motion_drawing.add(motion_drawing_accel_lateral_max.set("Smooth_Lat_Accel_Max", 1500, 10, 5000));
 
 	params_motion_line.setName("Line");
 	params_motion_line.add(motion_line_length.set("Length", 2000, 2, 3000));
@@ -7,6 +7,8 @@
 
 
 #include "controllers/agent/AgentController.h"
+#include "PathSmoother.h"
+#include "PathQueue.h"
 
 class MotionController
 {
@@ -35,7 +37,7 @@ public:
 
 	void setup();
 	void update();
-	void draw();
+	void draw(BatchRenderer& batch);
 	void draw_gui();
     void keyPressed(int key);
 
@@ -47,13 +49,17 @@ public:
 	void scale(float scalar);
 	float scalar_percent = 1;
 
-	vector<ofPolyline*> paths_drawing;
+	vector<PathQueue*> paths_drawing;
 	void setup_paths(int count=4);
 	void update_paths();
-	void draw_paths();
+	void draw_paths(BatchRenderer& batch);
 	void add_to_path(int i, glm::vec3 pt);
 	void update_targets(vector<glm::vec3> actual);
 
+	vector<PathSmoother*> smoothers;
+	vector<glm::vec3> targets_drawing;		// owned storage for the drawing targets
+	void apply_smoothing(PathSmoother* smoother);
+
 	void update_path(ofPolyline* path, glm::vec3 pt);
 	void clear_paths();
 	void draw_path(ofPolyline* path);
@@ -92,6 +98,10 @@ public:
 	ofParameter<float> motion_drawing_offset = 150;
 	ofParameter<float> motion_drawing_accuracy = 50;
 	ofParameter<float> motion_drawing_length_max = 500;
+	ofParameter<bool> motion_drawing_smooth = true;
+	ofParameter<float> motion_drawing_velocity_max = 500;
+	ofParameter<float> motion_drawing_accel_max = 1000;
+	ofParameter<float> motion_drawing_accel_lateral_max = 1500;
 
 	ofParameterGroup params_motion_line;
 	float motion_line_rotation = 0;
@@ -0,0 +1,114 @@
+#include "OscReplay.h"
+
+/**
+ * @brief Loads a recorded OSC session.
+ *
+ * @param (string)  filename: CSV in the local /bin/data folder
+ * @return (bool)  true if any messages were loaded.
+ */
+bool OscReplay::load(string filename)
+{
+	messages.clear();
+	index = 0;
+
+	ofBuffer buffer = ofBufferFromFile(filename);
+	for (auto line : buffer.getLines()) {
+		auto vals = ofSplitString(line, ",", false, true);
+		if (vals.size() < 2 || vals[0].empty() || vals[0][0] == '#')
+			continue;
+
+		ofxOscMessage m;
+		m.setAddress(vals[1]);
+		for (int i = 2; i < vals.size(); i++) {
+			if (vals[i].empty())
+				continue;
+			string val = vals[i].substr(1);
+			switch (vals[i][0]) {
+			case 'f': m.addFloatArg(ofToFloat(val)); break;
+			case 'i': m.addIntArg(ofToInt(val)); break;
+			case 'T': m.addBoolArg(true); break;
+			case 'F': m.addBoolArg(false); break;
+			case 's': m.addStringArg(val); break;
+			}
+		}
+		messages.push_back(make_pair(ofToFloat(vals[0]), m));
+	}
+	// recordings are in order, but hand-edited files may not be
+	stable_sort(messages.begin(), messages.end(), [](const pair<float, ofxOscMessage>& a, const pair<float, ofxOscMessage>& b) { return a.first < b.first; });
+
+	if (messages.empty()) {
+		ofLogWarning("OscReplay::load") << "No OSC messages found in: /bin/data/" << filename;
+		return false;
+	}
+	ofLogNotice("OscReplay::load") << "Loaded " << messages.size() << " OSC messages (" << ofToString(get_duration(), 1) << "s) from: /bin/data/" << filename;
+	return true;
+}
+
+/**
+ * @brief Returns the next message that is due by the given time.
+ * Call repeatedly until it returns false to drain everything that is due.
+ *
+ * @param (float)  time: playback time (s)
+ * @param (ofxOscMessage&)  m: filled with the next due message
+ * @return (bool)  true if a message was due.
+ */
+bool OscReplay::get_next_message(float time, ofxOscMessage& m)
+{
+	if (is_done() || messages[index].first > time)
+		return false;
+	m = messages[index++].second;
+	return true;
+}
+
+/**
+ * @brief Starts recording incoming messages.
+ *
+ * @param (string)  filename: CSV saved to the local /bin/data folder. Defaults to a timestamped osc_session_*.csv
+ */
+void OscReplay::start_recording(string filename)
+{
+	if (filename == "")
+		filename = "osc_session_" + ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".csv";
+	if (!recording.open(filename, ofFile::WriteOnly, false)) {
+		ofLogError("OscReplay::start_recording") << "Could not open: /bin/data/" << filename;
+		return;
+	}
+	recording << "# time,address,args\n";
+	time_start = -1;
+	ofLogNotice("OscReplay::start_recording") << "Recording OSC to: /bin/data/" << filename;
+}
+
+/**
+ * @brief Appends a message to the recording.
+ *
+ * @param (ofxOscMessage&)  m: received message
+ * @param (float)  time: time it was received (s)
+ */
+void OscReplay::record(ofxOscMessage& m, float time)
+{
+	if (!recording.is_open())
+		return;
+	if (time_start < 0)
+		time_start = time;
+
+	recording << ofToString(time - time_start, 4) << "," << m.getAddress();
+	for (int i = 0; i < m.getNumArgs(); i++) {
+		switch (m.getArgType(i)) {
+		case OFXOSC_TYPE_FLOAT: recording << ",f" << m.getArgAsFloat(i); break;
+		case OFXOSC_TYPE_INT32: recording << ",i" << m.getArgAsInt32(i); break;
+		case OFXOSC_TYPE_TRUE: recording << ",T"; break;
+		case OFXOSC_TYPE_FALSE: recording << ",F"; break;
+		case OFXOSC_TYPE_STRING: recording << ",s" << m.getArgAsString(i); break;
+		default: break;
+		}
+	}
+	recording << "\n";
+}
+
+void OscReplay::stop_recording()
+{
+	if (!recording.is_open())
+		return;
+	recording.close();
+	ofLogNotice("OscReplay::stop_recording") << "Stopped recording OSC.";
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxOsc.h"
+
+/**
+ * @brief Records incoming OSC messages to a CSV, and plays them back on the app's clock.
+ *
+ * Each line is one message: time (s, from the start of the recording),
+ * address, then one cell per argument tagged with its type:
+ * f0.5 (float), i3 (int), T / F (bool), sHello (string).
+ */
+class OscReplay
+{
+public:
+	bool load(string filename);
+	bool get_next_message(float time, ofxOscMessage& m);
+	void rewind() { index = 0; }
+	bool is_done() { return index >= messages.size(); }
+	float get_duration() { return messages.empty() ? 0 : messages.back().first; }
+	int size() { return messages.size(); }
+
+	void start_recording(string filename = "");
+	void record(ofxOscMessage& m, float time);
+	void stop_recording();
+	bool is_recording() { return recording.is_open(); }
+
+private:
+	vector<pair<float, ofxOscMessage>> messages;
+	int index = 0;
+
+	ofFile recording;
+	float time_start = -1;
+};
@@ -0,0 +1,143 @@
+#include "PathQueue.h"
+
+PathQueue::PathQueue(int capacity)
+{
+	pts.resize(MAX(capacity, 1));
+	lengths.resize(pts.size());
+}
+
+/**
+ * @brief Appends a point to the back of the queue.
+ * If the queue is full, the oldest point is dropped first.
+ *
+ * @param (glm::vec3)  pt: point to add
+ * @return (Handle)  handle of the new point
+ */
+PathQueue::Handle PathQueue::push(glm::vec3 pt)
+{
+	if (count == pts.size())
+		pop();
+
+	double length = 0;
+	if (count > 0)
+		length = lengths[slot(count - 1)] + glm::distance(pts[slot(count - 1)], pt);
+
+	pts[slot(count)] = pt;
+	lengths[slot(count)] = length;
+	count++;
+
+	return get_back_handle();
+}
+
+/**
+ * @brief Removes the point at the front of the queue.
+ */
+void PathQueue::pop()
+{
+	if (count == 0)
+		return;
+	head = (head + 1) % pts.size();
+	count--;
+	seq_front++;
+}
+
+void PathQueue::clear()
+{
+	// handles of cleared points must not alias new ones, so keep counting
+	seq_front += count;
+	head = 0;
+	count = 0;
+}
+
+/**
+ * @brief Resizes the buffer, keeping the newest points that still fit.
+ *
+ * @param (int)  capacity: maximum number of points
+ */
+void PathQueue::set_capacity(int capacity)
+{
+	capacity = MAX(capacity, 1);
+	if (capacity == pts.size())
+		return;
+
+	while (count > capacity)
+		pop();
+
+	vector<glm::vec3> _pts(capacity);
+	vector<double> _lengths(capacity);
+	for (int i = 0; i < count; i++) {
+		_pts[i] = pts[slot(i)];
+		_lengths[i] = lengths[slot(i)];
+	}
+	pts = _pts;
+	lengths = _lengths;
+	head = 0;
+}
+
+/**
+ * @brief Returns the length of the path from front to back.
+ *
+ * @return (float)  length (in mm)
+ */
+float PathQueue::get_length()
+{
+	if (count < 2)
+		return 0;
+	return lengths[slot(count - 1)] - lengths[head];
+}
+
+/**
+ * @brief Returns the point at a normalized distance along the path.
+ *
+ * @param (float)  t: percent along the path [0, 1]
+ * @return (glm::vec3)  interpolated point
+ */
+glm::vec3 PathQueue::get_point_at_percent(float t)
+{
+	if (count == 0)
+		return glm::vec3();
+	if (count == 1 || t <= 0)
+		return front();
+	if (t >= 1)
+		return back();
+
+	double target = lengths[head] + t * get_length();
+
+	// find the first point past the target length
+	int lo = 1;
+	int hi = count - 1;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (lengths[slot(mid)] < target)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	double l0 = lengths[slot(lo - 1)];
+	double l1 = lengths[slot(lo)];
+	float u = (l1 - l0) > 0 ? (target - l0) / (l1 - l0) : 0;
+	return glm::mix(pts[slot(lo - 1)], pts[slot(lo)], u);
+}
+
+void PathQueue::draw()
+{
+	ofBeginShape();
+	for (int i = 0; i < count; i++)
+		ofVertex(pts[slot(i)]);
+	ofEndShape();
+}
+
+/**
+ * @brief Adds the path to a batch, straight from the ring: the part up to the end of
+ * the buffer, then the part that wrapped around to the start.
+ */
+void PathQueue::draw(BatchRenderer& batch, const ofColor& color, float width)
+{
+	int first = MIN(count, int(pts.size()) - head);
+	batch.add_polyline(&pts[head], first, color, width);
+	if (count > first) {
+		batch.add_line(pts.back(), pts[0], color, width);
+		batch.add_polyline(&pts[0], count - first, color, width);
+	}
+}
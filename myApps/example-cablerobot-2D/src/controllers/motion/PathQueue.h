@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ofMain.h"
+#include "../BatchRenderer.h"
+
+/**
+ * @brief Fixed-capacity ring buffer of path points, used as a FIFO for
+ * drawing and sensor paths.
+ *
+ * Pushing and popping are O(1) and never move the stored points. The
+ * cumulative length is kept per point as it is pushed, so the total length
+ * is also O(1) and a point at a given percent is a binary search.
+ * Every pushed point gets a sequence number (handle) that stays valid until
+ * that point is popped, so callers never hold pointers into the buffer.
+ */
+class PathQueue
+{
+public:
+	typedef uint64_t Handle;
+
+	PathQueue(int capacity = 512);
+
+	Handle push(glm::vec3 pt);
+	void pop();
+	void clear();
+	void set_capacity(int capacity);
+
+	int size() { return count; }
+	int get_capacity() { return pts.size(); }
+	bool empty() { return count == 0; }
+
+	glm::vec3 front() { return pts[head]; }
+	glm::vec3 back() { return pts[slot(count - 1)]; }
+	glm::vec3 get(int i) { return pts[slot(i)]; }
+
+	Handle get_front_handle() { return seq_front; }
+	Handle get_back_handle() { return seq_front + count - 1; }
+	bool contains(Handle h) { return h >= seq_front && h < seq_front + count; }
+	glm::vec3 get_by_handle(Handle h) { return pts[slot(h - seq_front)]; }
+
+	float get_length();
+	glm::vec3 get_point_at_percent(float t);
+
+	void draw();
+	void draw(BatchRenderer& batch, const ofColor& color, float width = 1);
+
+private:
+	vector<glm::vec3> pts;
+	vector<double> lengths;		// running length at each point, measured from an arbitrary origin
+	int head = 0;
+	int count = 0;
+	Handle seq_front = 0;
+
+	int slot(int i) { return (head + i) % pts.size(); }
+};
@@ -0,0 +1,254 @@
+#include "PathSmoother.h"
+
+PathSmoother::PathSmoother(int window_size, int samples_per_segment)
+{
+	this->window_size = MAX(window_size, 4);
+	this->samples_per_segment = MAX(samples_per_segment, 2);
+}
+
+/**
+ * @brief Appends an incoming point to the path. Points closer than dist_thresh
+ * to the previous point are ignored. Points beyond the look-ahead window are
+ * queued until the reference catches up to them.
+ *
+ * @param (glm::vec3)  pt: incoming point (in world coordinates)
+ */
+void PathSmoother::add_point(glm::vec3 pt)
+{
+	if (control_pts.size() == 0) {
+		control_pts.push_back(pt);
+		reference = pt;
+		s = 0;
+		velocity = 0;
+		resample();
+		return;
+	}
+
+	glm::vec3 last = pending.size() > 0 ? pending.back() : control_pts.back();
+	if (glm::distance2(last, pt) < dist_thresh * dist_thresh)
+		return;
+
+	if (control_pts.size() < window_size) {
+		control_pts.push_back(pt);
+		resample();
+	}
+	else {
+		pending_length += glm::distance(last, pt);
+		pending.push_back(pt);
+	}
+}
+
+/**
+ * @brief Advances the reference along the spline by one control step.
+ *
+ * The velocity is bounded by the lateral acceleration limit through upcoming
+ * curves, and by the distance left on the path so the reference only comes to
+ * rest at the end of the path (never at an intermediate point).
+ *
+ * @param (float)  dt: time step (in seconds)
+ * @return (glm::vec3)  reference point on the spline
+ */
+glm::vec3 PathSmoother::update(float dt)
+{
+	if (samples.size() < 2) {
+		velocity = 0;
+		return reference;
+	}
+
+	// find the fastest velocity that can still slow down for every upcoming curve
+	float v_allowed = velocity_max;
+	float braking_dist = (velocity_max * velocity_max) / (2 * accel_max);
+	int i = upper_bound(lengths.begin(), lengths.end(), s) - lengths.begin();
+	for (int j = MAX(i - 1, 0); j < lengths.size() && lengths[j] - s < braking_dist; j++) {
+		if (curvatures[j] > 0.000001) {
+			float v_curve = sqrt(accel_lateral_max / curvatures[j]);
+			float dist = MAX(lengths[j] - s, 0);
+			v_allowed = MIN(v_allowed, sqrt(v_curve * v_curve + 2 * accel_max * dist));
+		}
+	}
+
+	// come to rest at the end of the path
+	float v_stop = sqrt(2 * accel_max * get_remaining_length());
+	float v_target = MIN(v_allowed, v_stop);
+
+	// apply the tangential acceleration limit
+	float dv = ofClamp(v_target - velocity, -accel_max * dt, accel_max * dt);
+	velocity = MAX(velocity + dv, 0);
+
+	s = MIN(s + velocity * dt, lengths.back());
+	reference = get_point_at_length(s);
+
+	drop_consumed_segments();
+
+	return reference;
+}
+
+void PathSmoother::clear()
+{
+	control_pts.clear();
+	pending.clear();
+	pending_length = 0;
+	samples.clear();
+	lengths.clear();
+	curvatures.clear();
+	segment_ends.clear();
+	s = 0;
+	velocity = 0;
+}
+
+void PathSmoother::draw(BatchRenderer& batch)
+{
+	if (samples.size() > 0) {
+		batch.add_polyline(&samples[0], samples.size(), ofColor(ofColor::cyan, 180), 2);
+		batch.add_ellipse(reference, 20, 20, ofColor::cyan);
+	}
+}
+
+/**
+ * @brief Returns the path length left in front of the reference,
+ * including the straight-line length of any queued points.
+ *
+ * @return (float)  remaining length (in mm)
+ */
+float PathSmoother::get_remaining_length()
+{
+	if (lengths.size() == 0)
+		return 0;
+	return lengths.back() - s + pending_length;
+}
+
+/**
+ * @brief Rebuilds the arc-length samples for the current window.
+ * The reference is re-projected onto the new samples so it stays continuous
+ * when the tail of the spline changes shape.
+ */
+void PathSmoother::resample()
+{
+	bool has_reference = samples.size() > 1;
+
+	samples.clear();
+	lengths.clear();
+	curvatures.clear();
+	segment_ends.clear();
+
+	int n = control_pts.size();
+	if (n == 0)
+		return;
+
+	samples.push_back(control_pts[0]);
+	lengths.push_back(0);
+	for (int i = 0; i < n - 1; i++) {
+		glm::vec3 p1 = control_pts[i];
+		glm::vec3 p2 = control_pts[i + 1];
+		// reflect the end points so the spline passes through the first and last points
+		glm::vec3 p0 = (i > 0) ? control_pts[i - 1] : p1 * 2.f - p2;
+		glm::vec3 p3 = (i + 2 < n) ? control_pts[i + 2] : p2 * 2.f - p1;
+		for (int j = 1; j <= samples_per_segment; j++) {
+			float t = (j * 1.0) / samples_per_segment;
+			glm::vec3 pt = evaluate(p0, p1, p2, p3, t);
+			lengths.push_back(lengths.back() + glm::distance(samples.back(), pt));
+			samples.push_back(pt);
+		}
+		segment_ends.push_back(samples.size() - 1);
+	}
+
+	// discrete (Menger) curvature at each sample
+	curvatures.assign(samples.size(), 0);
+	for (int i = 1; i < samples.size() - 1; i++) {
+		glm::vec3 a = samples[i - 1];
+		glm::vec3 b = samples[i];
+		glm::vec3 c = samples[i + 1];
+		float denom = glm::distance(a, b) * glm::distance(b, c) * glm::distance(a, c);
+		if (denom > 0.000001)
+			curvatures[i] = 2 * glm::length(glm::cross(b - a, c - a)) / denom;
+	}
+
+	// re-project the reference onto the rebuilt spline (only search near its last position)
+	if (has_reference) {
+		float s_prev = s;
+		float search_radius = 4 * dist_thresh;
+		float dist_min = numeric_limits<float>::max();
+		for (int i = 1; i < samples.size(); i++) {
+			if (lengths[i] < s_prev - search_radius || lengths[i - 1] > s_prev + search_radius)
+				continue;
+			glm::vec3 a = samples[i - 1];
+			glm::vec3 ab = samples[i] - a;
+			float seg_sq = glm::length2(ab);
+			float t = seg_sq > 0 ? ofClamp(glm::dot(reference - a, ab) / seg_sq, 0, 1) : 0;
+			float dist_sq = glm::distance2(a + ab * t, reference);
+			if (dist_sq < dist_min) {
+				dist_min = dist_sq;
+				s = ofLerp(lengths[i - 1], lengths[i], t);
+			}
+		}
+	}
+	else {
+		s = 0;
+	}
+}
+
+/**
+ * @brief Drops control points the reference has moved past. One segment is
+ * kept behind the reference so the current segment keeps its real neighbor.
+ * Queued points are pulled into the window as space frees up.
+ */
+void PathSmoother::drop_consumed_segments()
+{
+	// lengths aren't rebuilt until resample, so compare against them in the old window's frame
+	bool changed = false;
+	float dropped = 0;
+	while (segment_ends.size() > 1 && s + dropped > lengths[segment_ends[1]]) {
+		s -= lengths[segment_ends[0]] - dropped;
+		dropped = lengths[segment_ends[0]];
+		control_pts.pop_front();
+		segment_ends.erase(segment_ends.begin());
+		changed = true;
+	}
+	while (control_pts.size() < window_size && pending.size() > 0) {
+		pending_length -= glm::distance(control_pts.back(), pending.front());
+		control_pts.push_back(pending.front());
+		pending.pop_front();
+		changed = true;
+	}
+	if (changed) {
+		pending_length = MAX(pending_length, 0);
+		resample();
+	}
+}
+
+/**
+ * @brief Evaluates a centripetal (alpha = 0.5) Catmull-Rom segment between p1 and p2.
+ *
+ * @param (float)  t: normalized parameter along the segment [0, 1]
+ */
+glm::vec3 PathSmoother::evaluate(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, float t)
+{
+	float epsilon = 0.0001;
+	float t0 = 0;
+	float t1 = t0 + MAX(sqrt(glm::distance(p0, p1)), epsilon);
+	float t2 = t1 + MAX(sqrt(glm::distance(p1, p2)), epsilon);
+	float t3 = t2 + MAX(sqrt(glm::distance(p2, p3)), epsilon);
+	float u = ofLerp(t1, t2, t);
+
+	glm::vec3 a1 = p0 * ((t1 - u) / (t1 - t0)) + p1 * ((u - t0) / (t1 - t0));
+	glm::vec3 a2 = p1 * ((t2 - u) / (t2 - t1)) + p2 * ((u - t1) / (t2 - t1));
+	glm::vec3 a3 = p2 * ((t3 - u) / (t3 - t2)) + p3 * ((u - t2) / (t3 - t2));
+	glm::vec3 b1 = a1 * ((t2 - u) / (t2 - t0)) + a2 * ((u - t0) / (t2 - t0));
+	glm::vec3 b2 = a2 * ((t3 - u) / (t3 - t1)) + a3 * ((u - t1) / (t3 - t1));
+	return b1 * ((t2 - u) / (t2 - t1)) + b2 * ((u - t1) / (t2 - t1));
+}
+
+glm::vec3 PathSmoother::get_point_at_length(float length)
+{
+	if (samples.size() == 0)
+		return reference;
+	if (length <= 0 || samples.size() == 1)
+		return samples.front();
+	if (length >= lengths.back())
+		return samples.back();
+
+	int i = upper_bound(lengths.begin(), lengths.end(), length) - lengths.begin();
+	float seg = lengths[i] - lengths[i - 1];
+	float t = seg > 0 ? (length - lengths[i - 1]) / seg : 0;
+	return glm::mix(samples[i - 1], samples[i], t);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ofMain.h"
+#include "../BatchRenderer.h"
+
+/**
+ * @brief Streaming centripetal Catmull-Rom smoother for sparse drawing points.
+ *
+ * Incoming points are appended to a small look-ahead window of control points.
+ * The spline through that window is resampled by arc length, and a reference
+ * point is advanced along it every update at a velocity that is limited by
+ * the local curvature and by the distance left to the end of the path.
+ * The reference never stops at an intermediate control point.
+ */
+class PathSmoother
+{
+public:
+	PathSmoother(int window_size = 8, int samples_per_segment = 16);
+
+	void add_point(glm::vec3 pt);
+	glm::vec3 update(float dt);
+	void clear();
+	void draw(BatchRenderer& batch);
+
+	glm::vec3 get_reference() { return reference; }
+	float get_velocity() { return velocity; }
+	float get_remaining_length();
+	bool is_empty() { return control_pts.size() == 0; }
+
+	float dist_thresh = 20;			// mm: ignore points closer than this to the last control point
+	float velocity_max = 500;		// mm/s: tangential velocity limit
+	float accel_max = 1000;			// mm/s/s: tangential acceleration limit
+	float accel_lateral_max = 1500;	// mm/s/s: bounds velocity through curves (v^2 * curvature)
+
+private:
+	int window_size;
+	int samples_per_segment;
+
+	deque<glm::vec3> control_pts;	// look-ahead window of control points
+	deque<glm::vec3> pending;		// points waiting to enter the window
+	float pending_length = 0;
+
+	vector<glm::vec3> samples;		// arc-length samples of the spline through the window
+	vector<float> lengths;			// cumulative length at each sample
+	vector<float> curvatures;		// discrete curvature at each sample
+	vector<int> segment_ends;		// sample index where each control segment ends
+
+	float s = 0;					// arc-length position of the reference in the window
+	float velocity = 0;
+	glm::vec3 reference;
+
+	void resample();
+	void drop_consumed_segments();
+	glm::vec3 evaluate(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, float t);
+	glm::vec3 get_point_at_length(float length);
+};
@@ -17,12 +17,15 @@ public:
     float length = 30.0;
     int turns = 40;
     glm::vec3 tangent_pt = glm::vec3(0,0,0);
+    float guide_distance = 0;   // to the cable's first fixed guide, 0 if it runs straight to the end effector
+    float guide_offset = 0;     // along the drum axis, from the guide to where the cable leaves the drum at home
     CableDrum(){ direction = Groove::LEFT_HANDED; };
     void initialize(Groove direction, float diameter_drum = 99.95, float length = 30, int turns = 30);
     void draw();
     Groove direction = Groove::NONE;
     float get_diameter() { return diameter_drum; };
-    void set_diameter(float val) { diameter_drum = val; }
+    void set_diameter(float val) { diameter_drum = val; circumference = PI * val; }
+    float get_pitch() { return turns > 0 ? length / turns : 0; }
 
     glm::vec3 get_tangent() { return tangent_pt; };
     void set_tangent(glm::vec3 tangent) {
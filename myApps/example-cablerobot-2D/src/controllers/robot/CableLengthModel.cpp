@@ -0,0 +1,200 @@
+#include "CableLengthModel.h"
+
+/**
+ * @brief Reads a table at x, interpolating between its entries and extrapolating past its ends.
+ */
+static double lookup(const float* table, int size, double x, double step)
+{
+	double pos = x / step;
+	int i = ofClamp(floor(pos), 0, size - 1);
+	double t = pos - i;
+	return table[i] + (table[i + 1] - table[i]) * t;
+}
+
+/**
+ * @brief Precomputes the drum's tables.
+ *
+ * @param (Geometry)  geometry: drum, cable and guide dimensions
+ * @param (Correction)  correction: calibrated corrections (see fit)
+ * @return (bool)  false if the geometry doesn't pay out cable monotonically; the model is left unbuilt
+ */
+bool CableLengthModel::build(const Geometry& geometry, const Correction& correction)
+{
+	this->geometry = geometry;
+	this->correction = correction;
+	counts_step = 0;
+	payout_step = 0;
+
+	double circumference = PI * (geometry.diameter_drum + geometry.diameter_cable);
+	mm_per_rev = sqrt(circumference * circumference + geometry.pitch * geometry.pitch);
+	if (mm_per_rev <= 0 || geometry.counts_per_rev <= 0 || geometry.range <= 0)
+		return false;
+
+	// payout at uniform counts
+	double step = geometry.range / mm_per_rev * geometry.counts_per_rev / TABLE_SIZE;
+	for (int i = 0; i <= TABLE_SIZE; i++) {
+		payout[i] = compute_payout(i * step / geometry.counts_per_rev);
+		if (i > 0 && payout[i] <= payout[i - 1]) {
+			ofLogError("CableLengthModel::build") << "Cable length doesn't increase with payout past " << payout[i - 1] << " mm. Check the guide distance and offset.";
+			return false;
+		}
+	}
+
+	// invert it: counts at uniform payout
+	payout_step = payout[TABLE_SIZE] / TABLE_SIZE;
+	int i = 0;
+	for (int j = 0; j <= TABLE_SIZE; j++) {
+		double target = j * payout_step;
+		while (i < TABLE_SIZE - 1 && payout[i + 1] < target)
+			i++;
+		double t = (target - payout[i]) / (payout[i + 1] - payout[i]);
+		counts[j] = (i + t) * step;
+	}
+
+	counts_step = step;
+	return true;
+}
+
+/**
+ * @brief Returns the free cable length for a motor position.
+ *
+ * @param (int64_t)  counts: motor position
+ * @param (float)  torque: measured motor torque (% of max), for the stretch. The sign is ignored.
+ * @return (double)  length (mm), relative to home
+ */
+double CableLengthModel::to_mm(int64_t counts, float torque) const
+{
+	if (!is_built())
+		return 0;
+	double g = lookup(payout.data(), TABLE_SIZE, counts < 0 ? -counts : counts, counts_step);
+	double t = fabs(torque);
+	double length = correction.scale * g + t * (correction.compliance * g + correction.stretch_home);
+	return counts < 0 ? -length : length;
+}
+
+/**
+ * @brief Returns the motor position for a free cable length, rounded to the nearest count.
+ *
+ * @param (double)  mm: length (mm), relative to home
+ * @param (float)  torque: expected motor torque (% of max), for the stretch. The sign is ignored.
+ * @return (int64_t)  motor position
+ */
+int64_t CableLengthModel::to_counts(double mm, float torque) const
+{
+	if (!is_built())
+		return 0;
+	double t = fabs(torque);
+	double g = (fabs(mm) - t * correction.stretch_home) / (correction.scale + t * correction.compliance);
+	int64_t c = llround(lookup(counts.data(), TABLE_SIZE, g, payout_step));
+	return mm < 0 ? -c : c;
+}
+
+/**
+ * @brief Returns the geometric cable length for a motor position, without the calibrated corrections.
+ */
+double CableLengthModel::get_payout(int64_t counts) const
+{
+	if (!is_built())
+		return 0;
+	double g = lookup(payout.data(), TABLE_SIZE, counts < 0 ? -counts : counts, counts_step);
+	return counts < 0 ? -g : g;
+}
+
+/**
+ * @brief Fits the corrections to measured cable lengths, by linear least squares.
+ *
+ * Lengths are measured from home, for example with a tape at a few jog stops
+ * or by an external tracker, with the cable under its working load. The stretch
+ * terms are only fit if the samples' torques vary; otherwise just the scale is.
+ *
+ * @param (vector<Sample>)  samples: logged counts, torques and measured lengths
+ * @param (Correction&)  result: the fit corrections
+ * @param (double&)  rms: rms error of the fit (mm)
+ * @return (bool)  false if the samples can't constrain the fit
+ */
+bool CableLengthModel::fit(const vector<Sample>& samples, Correction& result, double& rms) const
+{
+	if (!is_built() || samples.empty())
+		return false;
+
+	// length = scale * g + compliance * |t| * g + stretch_home * |t|
+	glm::dmat3 ata(0);
+	glm::dvec3 atb(0);
+	for (auto& sample : samples) {
+		double g = fabs(get_payout(sample.counts));
+		double t = fabs(sample.torque);
+		glm::dvec3 row(g, t * g, t);
+		ata += glm::outerProduct(row, row);
+		atb += row * double(fabs(sample.length));
+	}
+
+	result = Correction();
+	double det = glm::determinant(ata);
+	if (samples.size() >= 3 && abs(det) > 1e-9 * ata[0][0] * ata[1][1] * ata[2][2] && ata[1][1] > 0 && ata[2][2] > 0) {
+		glm::dvec3 x = glm::inverse(ata) * atb;
+		result.scale = x[0];
+		result.compliance = x[1];
+		result.stretch_home = x[2];
+	}
+	else if (ata[0][0] > 0) {
+		result.scale = atb[0] / ata[0][0];
+	}
+	if (result.scale <= 0)
+		return false;
+
+	double sum = 0;
+	for (auto& sample : samples) {
+		double g = fabs(get_payout(sample.counts));
+		double t = fabs(sample.torque);
+		double r = result.scale * g + t * (result.compliance * g + result.stretch_home) - fabs(sample.length);
+		sum += r * r;
+	}
+	rms = sqrt(sum / samples.size());
+	return true;
+}
+
+/**
+ * @brief Reads logged samples from a CSV file with one "counts, torque, length" row per sample.
+ * Comment lines (#) and a header row are skipped.
+ *
+ * @param (string)  filename: file in the local /bin/data folder
+ * @param (vector<Sample>&)  samples: filled with the file's samples
+ * @return (bool)  True if any samples were read.
+ */
+bool CableLengthModel::load_samples(string filename, vector<Sample>& samples)
+{
+	ofBuffer buffer = ofBufferFromFile(filename);
+	if (buffer.size() == 0) {
+		ofLogError("CableLengthModel::load_samples") << "No samples found at: /bin/data/" << filename;
+		return false;
+	}
+
+	samples.clear();
+	for (auto line : buffer.getLines()) {
+		line = ofTrim(line);
+		if (line.empty() || line[0] == '#' || !(isdigit(line[0]) || line[0] == '-'))
+			continue;
+		auto vals = ofSplitString(line, ",", true, true);
+		if (vals.size() < 3)
+			continue;
+		samples.push_back({ ofToInt64(vals[0]), ofToFloat(vals[1]), ofToFloat(vals[2]) });
+	}
+	return !samples.empty();
+}
+
+/**
+ * @brief Returns the geometric length past the guide after paying out some revolutions.
+ */
+double CableLengthModel::compute_payout(double revs) const
+{
+	double length = revs * mm_per_rev;
+
+	// cable taken up by the segment between the drum and the guide as the departure point walks
+	if (geometry.guide_distance > 0) {
+		double d = geometry.guide_distance;
+		double a0 = geometry.guide_offset;
+		double a = geometry.guide_offset + geometry.pitch * revs;
+		length -= sqrt(d * d + a * a) - sqrt(d * d + a0 * a0);
+	}
+	return length;
+}
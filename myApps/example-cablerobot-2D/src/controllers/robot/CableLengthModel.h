@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ofMain.h"
+
+/**
+ * @brief Maps a drum's motor counts to the free cable length it has paid out.
+ *
+ * The linear scale (PI * drum diameter per revolution) misses three effects that
+ * grow with payout:
+ * - the cable's centerline wraps at the drum diameter plus the cable diameter,
+ *   along a helix with the groove's pitch;
+ * - the point where the cable leaves the drum walks along the drum axis by one
+ *   pitch per turn, changing the length of the segment up to the cable's first
+ *   fixed guide (if there is one);
+ * - the cable stretches under load.
+ *
+ * The geometry is precomputed into a lookup table in each direction, so a
+ * conversion is one interpolated table read. The stretch is estimated from the
+ * motor torque, and calibrated from logged samples (see fit).
+ *
+ * Lengths are relative to home (0 counts), and negative counts map to negative
+ * lengths, like the linear scale.
+ */
+class CableLengthModel
+{
+public:
+	static const int TABLE_SIZE = 256;
+
+	struct Geometry {
+		double diameter_drum = 99.95;	// mm
+		double diameter_cable = 0.3048;	// mm
+		double pitch = 1;				// mm of drum axis per turn
+		double guide_distance = 0;		// mm from the drum to the first fixed guide, 0 if the cable runs straight to the end effector
+		double guide_offset = 0;		// mm along the drum axis from the guide to where the cable leaves the drum at home
+		int counts_per_rev = 0;
+		double range = 2500;			// mm of payout covered by the tables, extrapolated past it
+	};
+
+	// length = scale * payout + |torque| * (compliance * payout + stretch_home)
+	struct Correction {
+		double scale = 1;				// calibrated correction to the geometric payout
+		double compliance = 0;			// stretch per mm of payout per % of max torque
+		double stretch_home = 0;		// mm per % of max torque, of the cable already out at home
+	};
+
+	struct Sample {
+		int64_t counts;
+		float torque;		// % of max
+		float length;		// mm, measured
+	};
+
+	bool build(const Geometry& geometry, const Correction& correction);
+	bool is_built() const { return counts_step > 0; }
+
+	double to_mm(int64_t counts, float torque = 0) const;
+	int64_t to_counts(double mm, float torque = 0) const;
+	double get_payout(int64_t counts) const;		// geometric length only
+
+	double get_mm_per_rev() const { return mm_per_rev; }
+	const Geometry& get_geometry() const { return geometry; }
+	const Correction& get_correction() const { return correction; }
+
+	bool fit(const vector<Sample>& samples, Correction& result, double& rms) const;
+	static bool load_samples(string filename, vector<Sample>& samples);
+
+private:
+	Geometry geometry;
+	Correction correction;
+	double mm_per_rev = 0;		// along the helix
+
+	// payout at uniform steps of counts, and counts at uniform steps of payout
+	std::array<float, TABLE_SIZE + 1> payout;
+	std::array<float, TABLE_SIZE + 1> counts;
+	double counts_step = 0;
+	double payout_step = 0;
+
+	double compute_payout(double revs) const;
+};
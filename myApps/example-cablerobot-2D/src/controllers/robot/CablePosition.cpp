@@ -0,0 +1,79 @@
+#include "CablePosition.h"
+
+/**
+ * @brief Returns the scale for a drum.
+ *
+ * @param (double)  mm_per_rev: cable paid out per drum revolution (mm)
+ * @param (int)  counts_per_rev: motor resolution
+ */
+CountScale CountScale::from_drum(double mm_per_rev, int counts_per_rev)
+{
+	CountScale scale;
+	if (mm_per_rev <= 0 || counts_per_rev <= 0)
+		return scale;
+	scale.mm_per_count = mm_per_rev / counts_per_rev;
+	scale.counts_per_mm = counts_per_rev / mm_per_rev;
+	return scale;
+}
+
+/**
+ * @brief Returns the scale for a drum with a length model. The linear scale is kept at the model's nominal pitch.
+ *
+ * @param (shared_ptr<const CableLengthModel>)  model: a built model
+ */
+CountScale CountScale::from_model(std::shared_ptr<const CableLengthModel> model)
+{
+	CountScale scale = from_drum(model->get_mm_per_rev(), model->get_geometry().counts_per_rev);
+	scale.model = model;
+	return scale;
+}
+
+/**
+ * @brief Converts the positions of several motors at once.
+ *
+ * @param (int64_t*)  counts: motor positions
+ * @param (CountScale*)  scales: each motor's drum scale
+ * @param (float*)  mm: cable positions out
+ * @param (size_t)  n: number of motors
+ * @param (bool)  use_unsigned: converts abs(counts) if true
+ * @param (float*)  torques: each motor's measured torque (% of max), for the cables' stretch. Optional.
+ */
+void CountScale::to_mm(const int64_t* counts, const CountScale* scales, float* mm, size_t n, bool use_unsigned, const float* torques)
+{
+	for (size_t i = 0; i < n; i++) {
+		int64_t val = use_unsigned && counts[i] < 0 ? -counts[i] : counts[i];
+		mm[i] = float(scales[i].to_mm(val, torques ? torques[i] : 0));
+	}
+}
+
+/**
+ * @brief Converts the cable positions of several motors at once, rounding to the nearest count.
+ */
+void CountScale::to_counts(const float* mm, const CountScale* scales, int64_t* counts, size_t n, bool use_unsigned, const float* torques)
+{
+	for (size_t i = 0; i < n; i++) {
+		double val = use_unsigned ? fabs(mm[i]) : mm[i];
+		counts[i] = scales[i].to_counts(val, torques ? torques[i] : 0);
+	}
+}
+
+/**
+ * @brief Returns the 64-bit position for a new read of the register.
+ *
+ * @param (double)  raw: register value, as sFoundation reports it
+ * @return (int64_t)  position (in counts)
+ */
+int64_t PositionUnwrap::update(double raw)
+{
+	uint32_t bits = uint32_t(int64_t(llround(raw)));
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!started) {
+		started = true;
+		position = int32_t(bits);
+	}
+	else {
+		position += int32_t(bits - last);
+	}
+	last = bits;
+	return position;
+}
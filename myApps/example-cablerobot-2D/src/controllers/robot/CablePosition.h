@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ofMain.h"
+#include "CableLengthModel.h"
+
+/**
+ * @brief Scale between a cable drum's motor counts and cable length.
+ *
+ * Cable positions are kept in int64 motor counts, the drum's native fixed-point
+ * unit, and only converted to mm where they are used. Both directions of the
+ * scale are computed once per drum configuration, so a conversion is a single
+ * multiply; mm are rounded to the nearest count instead of truncated.
+ *
+ * A drum with a length model converts through it instead, which adds the
+ * drum's geometry and, given the motors' torques, the cable's stretch.
+ */
+struct CountScale {
+	double mm_per_count = 0;
+	double counts_per_mm = 0;
+	std::shared_ptr<const CableLengthModel> model;	// null for the linear scale
+
+	static CountScale from_drum(double mm_per_rev, int counts_per_rev);
+	static CountScale from_model(std::shared_ptr<const CableLengthModel> model);
+
+	double to_mm(int64_t counts, float torque = 0) const { return model ? model->to_mm(counts, torque) : counts * mm_per_count; }
+	int64_t to_counts(double mm, float torque = 0) const { return model ? model->to_counts(mm, torque) : llround(mm * counts_per_mm); }
+
+	static void to_mm(const int64_t* counts, const CountScale* scales, float* mm, size_t n, bool use_unsigned = false, const float* torques = nullptr);
+	static void to_counts(const float* mm, const CountScale* scales, int64_t* counts, size_t n, bool use_unsigned = false, const float* torques = nullptr);
+};
+
+/**
+ * @brief Extends a node's 32-bit position register to 64 bits.
+ *
+ * Each read adds the signed distance from the previous read, so the position
+ * carries on past the register's wraparound instead of jumping by 2^32 counts.
+ * It only has to be read once per 2^31 counts of travel.
+ */
+class PositionUnwrap
+{
+public:
+	int64_t update(double raw);
+
+private:
+	std::mutex mutex;
+	bool started = false;
+	uint32_t last = 0;		// register bits at the previous read
+	int64_t position = 0;	// counts
+};
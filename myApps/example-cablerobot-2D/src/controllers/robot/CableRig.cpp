@@ -0,0 +1,77 @@
+#include "CableRig.h"
+
+static const int num_cables_linear[] = { 8, 4, 2, 1 };
+static const int num_cables_planar[] = { 8, 4, 2 };
+static const int num_cables_spatial[] = { 8, 6, 4 };
+
+/**
+ * @brief Returns the largest supported cable count that fits, or 0 if none do.
+ */
+template<size_t N>
+static int fit(const int (&supported)[N], int num_cables)
+{
+	for (int n : supported) {
+		if (n <= num_cables)
+			return n;
+	}
+	return 0;
+}
+
+/**
+ * @brief Builds the rig for a configuration from the supported set of cable counts.
+ * If there are more cables than the largest rig that fits, the extra cables are left out.
+ *
+ * @param (int)  configuration: RobotController::Configuration
+ * @param (vector<CableRobot*>)  robots: one per cable
+ * @param (KinematicGraph*)  kinematics: the robots' shared frames
+ * @param (int)  node_origin: world reference frame
+ * @param (vector<glm::vec3>)  bases: one per cable
+ * @param (bool)  run_threaded: 2D and 3D robots tick on their own threads if true, or from Rig::tick
+ * @return (Rig*)  nullptr if no supported rig fits
+ */
+Rig* Rig::create(int configuration, const vector<CableRobot*>& robots, KinematicGraph* kinematics, int node_origin, const vector<glm::vec3>& bases, bool run_threaded)
+{
+	int num_cables = MIN(robots.size(), bases.size());
+	Rig* rig = nullptr;
+
+	if (configuration == 0) {
+		switch (fit(num_cables_linear, num_cables)) {
+		case 8: rig = new CableRig<Linear, 8>(robots, kinematics, node_origin, bases); break;
+		case 4: rig = new CableRig<Linear, 4>(robots, kinematics, node_origin, bases); break;
+		case 2: rig = new CableRig<Linear, 2>(robots, kinematics, node_origin, bases); break;
+		case 1: rig = new CableRig<Linear, 1>(robots, kinematics, node_origin, bases); break;
+		}
+	}
+	else if (configuration == 1) {
+		// a swapped or mismatched pair of bases would give a 2D robot a negative width
+		for (int i = 0; i + 1 < num_cables; i += 2) {
+			float span = bases[i + 1].x - bases[i].x;
+			if (span <= 0) {
+				ofLogError("Rig::create") << "Bases " << i << " and " << i + 1 << " span " << span << " mm. Each 2D robot needs its left base before its right one.";
+				return nullptr;
+			}
+		}
+		switch (fit(num_cables_planar, num_cables)) {
+		case 8: rig = new CableRig<Planar, 8>(robots, kinematics, node_origin, bases, run_threaded); break;
+		case 4: rig = new CableRig<Planar, 4>(robots, kinematics, node_origin, bases, run_threaded); break;
+		case 2: rig = new CableRig<Planar, 2>(robots, kinematics, node_origin, bases, run_threaded); break;
+		}
+	}
+	else if (configuration == 2) {
+		switch (fit(num_cables_spatial, num_cables)) {
+		case 8: rig = new CableRig<Spatial, 8>(robots, kinematics, node_origin, bases, run_threaded); break;
+		case 6: rig = new CableRig<Spatial, 6>(robots, kinematics, node_origin, bases, run_threaded); break;
+		case 4: rig = new CableRig<Spatial, 4>(robots, kinematics, node_origin, bases, run_threaded); break;
+		}
+	}
+	else {
+		ofLogError("Rig::create") << "Configuration " << configuration << " is not supported.";
+		return nullptr;
+	}
+
+	if (rig == nullptr)
+		ofLogError("Rig::create") << "No supported rig for " << num_cables << " cables in configuration " << configuration << ".";
+	else if (rig->get_num_cables() < num_cables)
+		ofLogWarning("Rig::create") << "Using " << rig->get_num_cables() << " of " << num_cables << " cables (" << rig->get_name() << ").";
+	return rig;
+}
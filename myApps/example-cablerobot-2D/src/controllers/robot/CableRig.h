@@ -0,0 +1,338 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGui.h"
+#include "ofxGizmo.h"
+#include "CableRobot.h"
+#include "CableRobot2D.h"
+#include "CableRobot3D.h"
+#include "KinematicGraph.h"
+#include "../BatchRenderer.h"
+
+// Cable topologies; each one specializes CableRig
+struct Linear {};	// 1D: each cable moves its own end effector up and down
+struct Planar {};	// 2D: pairs of cables share an end effector in a vertical plane
+struct Spatial {};	// 3D: all the cables share one end effector
+
+/**
+ * @brief The robots a RobotController drives, in one of the supported cable topologies.
+ *
+ * RobotController calls the rig once per operation; the rig's loops over its
+ * cables are fixed-size and specialized per topology (see CableRig), so there
+ * is no per-call branching on the configuration.
+ */
+class Rig
+{
+public:
+	virtual ~Rig() {}
+
+	virtual void setup_gui(ofxPanel* panel) = 0;
+	virtual void update() = 0;					// on the controller thread, every loop
+	virtual void update_gui() = 0;				// on the GUI thread, once per frame
+	virtual void tick() = 0;					// for offline rigs, in lockstep with the app
+	virtual void draw(BatchRenderer& batch) = 0;
+	virtual void draw_gui(ofxPanel* panel) = 0;
+	virtual void update_gizmos(bool override_gizmo) = 0;
+	virtual void key_pressed(int key) = 0;
+
+	virtual void stop() = 0;
+	virtual void set_e_stop(bool val) = 0;
+	virtual void set_move_to_vel(bool val) = 0;
+
+	virtual int get_num_cables() const = 0;
+	virtual string get_name() const = 0;
+	vector<ofxGizmo*> get_gizmos() { return gizmos; }
+	vector<CableRobot2D*> get_robots_2D() { return robots_2D; }
+	vector<CableRobot3D*> get_robots_3D() { return robots_3D; }
+
+	static Rig* create(int configuration, const vector<CableRobot*>& robots, KinematicGraph* kinematics, int node_origin, const vector<glm::vec3>& bases, bool run_threaded);
+
+protected:
+	vector<ofxGizmo*> gizmos;			// end effector gizmos
+	vector<CableRobot2D*> robots_2D;	// empty unless the rig is planar
+	vector<CableRobot3D*> robots_3D;	// empty unless the rig is spatial
+};
+
+template<typename Topology, int NumCables>
+class CableRig;
+
+/**
+ * @brief NumCables independent 1D cable robots.
+ */
+template<int NumCables>
+class CableRig<Linear, NumCables> : public Rig
+{
+public:
+	CableRig(const vector<CableRobot*>& robots, KinematicGraph* kinematics, int node_origin, const vector<glm::vec3>& bases)
+	{
+		for (int i = 0; i < NumCables; i++) {
+			cables[i] = robots[i];
+			cables[i]->configure(kinematics, node_origin, bases[i]);
+			gizmos.push_back(cables[i]->get_gizmo());
+		}
+	}
+
+	void setup_gui(ofxPanel* panel)
+	{
+		int x = panel->getPosition().x;
+		int y = panel->getPosition().y;
+		int w = panel->getWidth();
+		int padding = 5;
+		for (auto cable : cables) {
+			cable->panel.setPosition(x + w + padding, y);
+			x = cable->panel.getPosition().x;
+			w = cable->panel.getWidth();
+			cable->panel.setParent(panel);
+		}
+	}
+
+	void update()
+	{
+		// read every cable's position, then convert them in one pass
+		for (int i = 0; i < NumCables; i++) {
+			counts[i] = cables[i]->get_position_counts();
+			cables[i]->cache_scale(scales[i], scale_sources[i]);
+			torques[i] = cables[i]->get_torque_measured();
+		}
+		CountScale::to_mm(counts.data(), scales.data(), positions.data(), NumCables, true, torques.data());
+		for (int i = 0; i < NumCables; i++) {
+			cables[i]->position_actual = positions[i];
+			cables[i]->update();
+		}
+	}
+
+	void update_gui()
+	{
+		for (auto cable : cables)
+			cable->update_gui();
+	}
+
+	void tick() {}		// 1D robots move from update
+
+	void draw(BatchRenderer& batch)
+	{
+		for (auto cable : cables)
+			cable->draw(batch);
+	}
+
+	void draw_gui(ofxPanel* panel)
+	{
+		for (auto cable : cables)
+			cable->panel.draw();
+	}
+
+	void update_gizmos(bool override_gizmo)
+	{
+		for (auto cable : cables) {
+			cable->override_gizmo = override_gizmo;
+			cable->update_gizmo();
+		}
+	}
+
+	void key_pressed(int key)
+	{
+		for (auto cable : cables)
+			cable->key_pressed(key);
+	}
+
+	void stop()
+	{
+		for (auto cable : cables)
+			cable->stop();
+	}
+
+	void set_e_stop(bool val)
+	{
+		for (auto cable : cables)
+			cable->set_e_stop(val);
+	}
+
+	void set_move_to_vel(bool val)
+	{
+		for (auto cable : cables)
+			cable->move_to_vel.set(val);
+	}
+
+	int get_num_cables() const { return NumCables; }
+	string get_name() const { return "1D x " + ofToString(NumCables); }
+
+private:
+	std::array<CableRobot*, NumCables> cables;
+	std::array<int64_t, NumCables> counts;
+	std::array<CountScale, NumCables> scales;				// copied only when a reload replaces them
+	std::array<const CountScale*, NumCables> scale_sources{};
+	std::array<float, NumCables> torques;		// % of max
+	std::array<float, NumCables> positions;		// mm
+};
+
+/**
+ * @brief NumCables / 2 2D cable robots. The first half of the cables are paired with the second
+ * half (the motors' wiring), and each pair hangs from a left/right pair of bases, which are laid
+ * out [L0, R0, L1, R1, ...] (as in ofApp::setup and MotionController).
+ */
+template<int NumCables>
+class CableRig<Planar, NumCables> : public Rig
+{
+	static_assert(NumCables % 2 == 0, "A planar rig pairs its cables.");
+	static const int NumPairs = NumCables / 2;
+
+public:
+	CableRig(const vector<CableRobot*>& robots, KinematicGraph* kinematics, int node_origin, const vector<glm::vec3>& bases, bool run_threaded)
+	{
+		for (int i = 0; i < NumCables; i++)
+			cables[i] = robots[i];
+		for (int i = 0; i < NumPairs; i++) {
+			pairs[i] = make_unique<CableRobot2D>(cables[i], cables[i + NumPairs], kinematics, node_origin, bases[2 * i], bases[2 * i + 1], i, run_threaded);
+			robots_2D.push_back(pairs[i].get());
+			gizmos.push_back(pairs[i]->get_gizmo());
+		}
+	}
+
+	void setup_gui(ofxPanel* panel)
+	{
+		for (auto& pair : pairs) {
+			pair->update_gui(panel);
+			pair->plot.name = "Bot 1 RPM: Motor 1 (RED), Motor 2 (BLUE)";
+		}
+	}
+
+	void update()
+	{
+		for (auto& pair : pairs)
+			pair->update();
+	}
+
+	void update_gui()
+	{
+		// show the states and plots the control threads published since the last frame
+		for (auto& pair : pairs)
+			pair->update_gui();
+		for (auto cable : cables)
+			cable->update_gui();
+	}
+
+	void tick()
+	{
+		for (auto& pair : pairs)
+			pair->tick();
+	}
+
+	void draw(BatchRenderer& batch)
+	{
+		for (auto& pair : pairs)
+			pair->draw(batch);
+	}
+
+	void draw_gui(ofxPanel* panel)
+	{
+		int padding = 20;
+		for (int i = 0; i < NumPairs; i++) {
+			int x = panel->getPosition().x + (i * panel->getWidth()) + (i * padding);
+			int y = panel->getPosition().y + panel->getHeight() + padding;
+			pairs[i]->panel.setPosition(x, y);
+			pairs[i]->draw_gui();
+
+			if (pairs[i]->debugging) {
+				ofPushMatrix();
+				ofTranslate(ofGetWidth() - 550, i * 150 + 60);
+				pairs[i]->plot.draw();
+				ofPopMatrix();
+			}
+		}
+	}
+
+	void update_gizmos(bool override_gizmo)
+	{
+		for (auto& pair : pairs) {
+			pair->override_gizmo = override_gizmo;
+			pair->update_gizmo();
+		}
+	}
+
+	void key_pressed(int key)
+	{
+		for (auto& pair : pairs)
+			pair->key_pressed(key);
+	}
+
+	void stop()
+	{
+		for (auto& pair : pairs)
+			pair->stop();
+	}
+
+	void set_e_stop(bool val)
+	{
+		for (auto& pair : pairs)
+			pair->set_e_stop(val);
+	}
+
+	void set_move_to_vel(bool val)
+	{
+		for (auto& pair : pairs)
+			pair->move_to_vel.set(val);
+	}
+
+	int get_num_cables() const { return NumCables; }
+	string get_name() const { return "2D x " + ofToString(NumPairs); }
+
+private:
+	std::array<CableRobot*, NumCables> cables;
+	std::array<unique_ptr<CableRobot2D>, NumPairs> pairs;	// owned; the cables belong to the RobotController
+};
+
+/**
+ * @brief One 3D cable robot with NumCables cables.
+ */
+template<int NumCables>
+class CableRig<Spatial, NumCables> : public Rig
+{
+	static_assert(NumCables >= 4 && NumCables <= CableSolver3D::MAX_CABLES, "A spatial rig needs 4 to 8 cables.");
+
+public:
+	CableRig(const vector<CableRobot*>& robots, KinematicGraph* kinematics, int node_origin, const vector<glm::vec3>& bases, bool run_threaded)
+	{
+		for (int i = 0; i < NumCables; i++)
+			cables[i] = robots[i];
+		robot = make_unique<CableRobot3D>(vector<CableRobot*>(cables.begin(), cables.end()), kinematics, node_origin, bases, 0, run_threaded);
+		robots_3D.push_back(robot.get());
+		gizmos.push_back(robot->get_gizmo());
+	}
+
+	void setup_gui(ofxPanel* panel) { robot->update_gui(panel); }
+
+	void update()
+	{
+		robot->update();
+	}
+
+	void update_gui()
+	{
+		// show the states and solver info the control threads published since the last frame
+		robot->update_gui();
+		for (auto cable : cables)
+			cable->update_gui();
+	}
+
+	void tick() { robot->tick(); }
+	void draw(BatchRenderer& batch) { robot->draw(batch); }
+	void draw_gui(ofxPanel* panel) { robot->draw_gui(); }
+
+	void update_gizmos(bool override_gizmo)
+	{
+		robot->override_gizmo = override_gizmo;
+		robot->update_gizmo();
+	}
+
+	void key_pressed(int key) { robot->key_pressed(key); }
+	void stop() { robot->stop(); }
+	void set_e_stop(bool val) { robot->set_e_stop(val); }
+	void set_move_to_vel(bool val) { robot->move_to_vel.set(val); }
+
+	int get_num_cables() const { return NumCables; }
+	string get_name() const { return "3D x 1 (" + ofToString(NumCables) + " cables)"; }
+
+private:
+	std::array<CableRobot*, NumCables> cables;
+	unique_ptr<CableRobot3D> robot;		// owned; the cables belong to the RobotController
+};
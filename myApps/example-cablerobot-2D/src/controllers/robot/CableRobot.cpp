@@ -1,17 +1,25 @@
 #include "CableRobot.h"
 
-CableRobot::CableRobot(SysManager& SysMgr, INode* node, bool load_config_file)
+CableRobot::CableRobot(SysManager& SysMgr, INode* node, bool load_config_file) :
+	CableRobot(SysMgr, node, NodeInventory::read_node(-1, *node), load_config_file)
 {
-	motor_controller = new MotorController(SysMgr, node);
+}
+
+CableRobot::CableRobot(SysManager& SysMgr, INode* node, NodeInfo info, bool load_config_file) :
+	CableRobot(new MotorController(SysMgr, node, info), load_config_file)
+{
+}
+
+CableRobot::CableRobot(MotorController* motor_controller, bool load_config_file)
+{
+	this->motor_controller = motor_controller;
 	setup_gui();
 	motor_controller->get_motor()->set_motion_params(vel_limit.get(), accel_limit.get());
 
 	check_for_system_ready();
 
+	// the robot's config is handed over by the RobotController (see set_config)
 	this->load_config_file = load_config_file;
-	if (load_config_file) {
-		load_config_from_file();
-	}
 
 	setup_plots();
 }
@@ -20,15 +28,15 @@ CableRobot::CableRobot(glm::vec3 base)
 {
 }
 
-void CableRobot::configure(ofNode* _origin, ofNode* _ee, glm::vec3 base, Groove direction, float diameter_drum, float length, int turns)
+void CableRobot::configure(KinematicGraph* _kinematics, int _origin, int _ee, glm::vec3 base, Groove direction, float diameter_drum, float length, int turns)
 {
-	this->origin = _origin;
-	this->ee = _ee;
-	this->base.setParent(*origin);
-	this->base.setPosition(base);
+	this->kinematics = _kinematics;
+	this->node_origin = _origin;
+	this->node_ee = _ee;
+	node_base = kinematics->add(node_origin, base);
 	drum.initialize(direction, diameter_drum, length, turns);
 
-	// HARD CODED
+	// HARD CODED defaults (a stored config overrides these)
 	if (motor_controller->get_motor_id() == 0) {
 		int x = drum.get_tangent().x + 5;
 		int y = drum.get_tangent().y - 80;
@@ -41,24 +49,18 @@ void CableRobot::configure(ofNode* _origin, ofNode* _ee, glm::vec3 base, Groove
 	}
 
 	// define the linear length per motor step
-	float step_resolution = motor_controller->get_motor()->get_resolution();
-	mm_per_count = drum.circumference / step_resolution;
+	update_mm_per_count();
 
 	// setup the kinematic chain
-	tangent.setParent(this->base);
-	tangent.setPosition(drum.get_tangent());
-	target.setPosition(0, 0, 0);
-	actual.setParent(tangent);
-	actual.setPosition(0, 0, 0);
-
-	// if the external ee node is empty, create a new one that is internal and add a gizmo
-	if (ee->getGlobalPosition() == glm::vec3() && ee->getGlobalOrientation() == glm::quat()) {
-		ee = new ofNode();
-		ee->setParent(tangent);
-		ee->setPosition(0, -1 * (bounds_max.get() - bounds_min.get()) / 2, 0);
-		target.setParent(*ee);
-
-		gizmo_ee.setNode(*ee);
+	node_tangent = kinematics->add(node_base, drum.get_tangent());
+	node_actual = kinematics->add(node_tangent);
+
+	// if there is no external ee frame, create a new one that is internal and add a gizmo
+	ee_internal = node_ee < 0;
+	if (ee_internal) {
+		node_ee = kinematics->add(node_tangent, glm::vec3(0, -1 * (bounds_max.get() - bounds_min.get()) / 2, 0));
+		node_target = kinematics->add(node_ee);
+
 		gizmo_ee.setDisplayScale(.5);
 		gizmo_ee.setTranslationAxisMask(IGizmo::AXIS_Y);
 		gizmo_ee.setRotationAxisMask(IGizmo::AXIS_Z);
@@ -67,26 +69,30 @@ void CableRobot::configure(ofNode* _origin, ofNode* _ee, glm::vec3 base, Groove
 	else {
 		// set the target position to the actual position
 		float dist_actual = get_position_actual();
-		actual.setPosition(0, -1 * dist_actual, 0);
-		target.setParent(*ee);
-		float x = this->base.getPosition().x + tangent.getPosition().x - ee->getPosition().x;
-		target.setPosition(x, 0, ee->getPosition().z);
+		kinematics->set_position(node_actual, glm::vec3(0, -1 * dist_actual, 0));
+		glm::vec3 ee_pos = kinematics->get_position(node_ee);
+		float x = base.x + drum.get_tangent().x - ee_pos.x;
+		node_target = kinematics->add(node_ee, glm::vec3(x, 0, ee_pos.z));
 	}
 
-	if (load_config_file) {
-		load_config_from_file();
+	if (load_config_file && has_config) {
+		apply_config();
 	}
+
+	// resolve the new frames, so they can be read right away
+	kinematics->update();
+	gizmo_ee.setNode(kinematics->get_node(node_ee));
 }
 
-void CableRobot::configure(ofNode* _origin, glm::vec3 base, ofNode* _ee)
+void CableRobot::configure(KinematicGraph* _kinematics, int _origin, glm::vec3 base, int _ee)
 {
-	this->origin = _origin;
-	this->ee = _ee;
-	this->base.setParent(*origin);
-	this->base.setPosition(base);
+	this->kinematics = _kinematics;
+	this->node_origin = _origin;
+	this->node_ee = _ee;
+	node_base = kinematics->add(node_origin, base);
 	drum.initialize(drum.direction, drum.diameter_drum, drum.length, drum.turns);
 
-	// HARD CODED
+	// HARD CODED defaults (a stored config overrides these)
 	if (motor_controller->get_motor_id() == 0) {
 		int x = drum.get_tangent().x + 5;
 		int y = drum.get_tangent().y - 80;
@@ -99,51 +105,56 @@ void CableRobot::configure(ofNode* _origin, glm::vec3 base, ofNode* _ee)
 	}
 
 	// define the linear length per motor step
-	float step_resolution = motor_controller->get_motor()->get_resolution();
-	mm_per_count = drum.circumference / step_resolution;
+	update_mm_per_count();
 
 	// setup the kinematic chain
-	tangent.setParent(this->base);
-	tangent.setPosition(drum.get_tangent());
-	target.setPosition(0, 0, 0);
-	actual.setParent(tangent);
-	actual.setPosition(0, 0, 0);
-
-	// if the external ee node is empty, create a new one that is internal and add a gizmo
-	if (ee->getGlobalPosition() == glm::vec3() && ee->getGlobalOrientation() == glm::quat()) {
-		ee = new ofNode();
-		ee->setParent(tangent);
-		ee->setPosition(0, -1 * (bounds_max.get() - bounds_min.get()) / 2, tangent.getGlobalPosition().z);
-		target.setParent(*ee);
-
-		gizmo_ee.setNode(*ee);
+	node_tangent = kinematics->add(node_base, drum.get_tangent());
+	node_actual = kinematics->add(node_tangent);
+
+	// if there is no external ee frame, create a new one that is internal and add a gizmo
+	ee_internal = node_ee < 0;
+	if (ee_internal) {
+		node_ee = kinematics->add(node_tangent, glm::vec3(0, -1 * (bounds_max.get() - bounds_min.get()) / 2, kinematics->get_global_position(node_tangent).z));
+		node_target = kinematics->add(node_ee);
+
 		gizmo_ee.setDisplayScale(.5);
 		gizmo_ee.setTranslationAxisMask(IGizmo::AXIS_Y);
 		gizmo_ee.setRotationAxisMask(IGizmo::AXIS_Z);
 	}
 	// otherwise, parent the target to the external ee and offset by ee_offset value
 	else {
-		target.setParent(*ee);
-		target.setGlobalPosition(ee->getGlobalPosition());
 		if (motor_controller->get_motor_id() % 2 == 0)		
-			target.setPosition(-40, 0, 0);				// <-- ee_offset value hard coded offset at the moment : (
+			node_target = kinematics->add(node_ee, glm::vec3(-40, 0, 0));	// <-- ee_offset value hard coded offset at the moment : (
 		else
-			target.setPosition(40, 0, 0);
-
+			node_target = kinematics->add(node_ee, glm::vec3(40, 0, 0));
 
-		gizmo_ee.setNode(*ee);
 		gizmo_ee.setDisplayScale(.5);
 		gizmo_ee.setRotationAxisMask(IGizmo::AXIS_Z);
 	}
 
-	if (load_config_file) {
-		load_config_from_file();
+	if (load_config_file && has_config) {
+		apply_config();
 	}
+
+	// resolve the new frames, so they can be read right away
+	kinematics->update();
+	gizmo_ee.setNode(kinematics->get_node(node_ee));
 }
 
+/**
+ * @brief Reads the motor position and returns the cable length paid out (in mm, (+) only).
+ */
 float CableRobot::get_position_actual()
 {
-	return count_to_mm(motor_controller->get_motor()->get_position(false), true);
+	return count_to_mm(get_position_counts(), true);
+}
+
+/**
+ * @brief Reads the motor position (in counts), for converting several robots at once with CountScale::to_mm.
+ */
+int64_t CableRobot::get_position_counts()
+{
+	return motor_controller->get_motor()->get_position(false);
 }
 
 /**
@@ -220,9 +231,37 @@ void CableRobot::set_bounds(float min, float max)
 	bounds_max.set(max);
 }
 
+/**
+ * @brief Programs the robot's bounds and torque limits into its node, and arms the port's group shutdown.
+ * The node then stops on its own at the bounds, and takes the other cables on its port with it;
+ * the host-side bounds checks stay on as a second layer.
+ */
+void CableRobot::apply_hardware_limits()
+{
+	int dir = get_rotation_direction();
+	int count_min = int(mm_to_count(bounds_min.get(), true)) * dir;
+	int count_max = int(mm_to_count(bounds_max.get(), true)) * dir;
+	try {
+		motor_controller->get_motor()->set_hardware_limits(MIN(count_min, count_max), MAX(count_min, count_max), torque_min.get(), torque_max.get());
+		motor_controller->get_motor()->arm_group_shutdown();
+	}
+	catch (mnErr& theErr) {
+		ofLogWarning(__FUNCTION__) << "Robot " << ofToString(get_id()) << " could not program its hardware limits: " << theErr.ErrorMsg;
+	}
+}
+
+/**
+ * @brief Hands the robot its safety monitor channel, and publishes its limits into it.
+ */
+void CableRobot::set_safety_channel(SafetyMonitor::Channel* channel)
+{
+	safety = channel;
+	safety->set_limits(bounds_min.get(), bounds_max.get(), torque_min.get(), torque_max.get());
+}
+
 bool CableRobot::is_torque_in_limits()
 {
-	auto torque_measured = motor_controller->get_motor()->get()->Motion.TrqMeasured.Value();
+	auto torque_measured = motor_controller->get_motor()->get_torque();
 	//info_torque_actual.set(ofToString(torque_measured));
 	if (torque_measured > torque_max.get() || torque_measured < torque_min.get()) {
 		ofLogWarning(__FUNCTION__) << "\tRobot " << ofToString(motor_controller->get_motor_id()) << " is OUT OF TORQUE RANGE with value of " << ofToString(torque_measured) << endl;
@@ -231,191 +270,234 @@ bool CableRobot::is_torque_in_limits()
 	return true;
 }
 
-void CableRobot::load_config_from_file(string filename)
+/**
+ * @brief Stores a config from the RigConfig store and applies it.
+ * The kinematic offsets are applied again once the robot is configured.
+ * Safe to call on a running robot (hot reload): the motor stays enabled and homed.
+ *
+ * @param (RobotConfig)  config: this robot's config (serial numbers must match)
+ */
+void CableRobot::set_config(const RobotConfig& config)
 {
-	//motor_controller->get_motor()->get()->Status.RT.Refresh();
-	//while (!motor_controller->get_motor()->get()->Status.IsReady() && !is_setup) {
-	//	motor_controller->get_motor()->get()->Status.RT.Refresh();
-	//	cout << "waiting..." << endl;
-	//}
+	int serial_number = get_serial_number();
+	if (config.serial_number != serial_number) {
+		ofLogWarning(__FUNCTION__) << "Cannot load config: Wrong serial number. Loaded " << ofToString(config.serial_number) << ", but should be " << ofToString(serial_number);
+		return;
+	}
+	this->config = config;
+	has_config = true;
+	apply_config();
+}
 
-	int serial_number = int(motor_controller->get_motor()->get()->Info.SerialNumber.Value());
-	if (filename == "")
-		filename = "robot_config_" + ofToString(serial_number) + ".xml";
-	ofLogNotice(__FUNCTION__) << "Loading config file: " << filename;
-	try
-	{
-		bool val = config.loadFile(filename);
-		if (val) {
-			// Check that the serial numbers match
-			int sn = config.getValue("config:serial_number", 0);
-			if (sn != serial_number) {
-				ofLogWarning(__FUNCTION__) << "Cannot load config file: Wrong serial number. Loaded " << ofToString(sn) << ", but should be " << ofToString(serial_number);
-				return;
-			}
+void CableRobot::apply_config()
+{
+	auto_home = config.auto_home;
+
+	// kinematics (the frames only exist once the robot is configured)
+	glm::vec3 pos_base = glm::vec3(config.base[0], config.base[1], config.base[2]);
+	glm::vec3 pos_tangent = glm::vec3(config.tangent[0], config.tangent[1], config.tangent[2]);
+	glm::vec3 pos_target = glm::vec3(config.target[0], config.target[1], config.target[2]);
+	if (kinematics != nullptr) {
+		kinematics->set_position(node_base, pos_base);
+		kinematics->set_position(node_tangent, pos_tangent);
+		kinematics->set_position(node_target, pos_target);
+	}
 
-			auto_home = config.getValue("config:auto_home", 0);
-
-			ofLogNotice(__FUNCTION__) << "\tSettings: " ;
-			ofLogNotice(__FUNCTION__) << "\t\tSerial Number: " << sn;
-			ofLogNotice(__FUNCTION__) << "\t\tAuto Homing: " << (auto_home ? "TRUE" : "FALSE");
-
-			// kinematics
-			float x = config.getValue("config:kinematics:base:X", 0);
-			float y = config.getValue("config:kinematics:base:Y", 0);
-			float z = config.getValue("config:kinematics:base:Z", 0);
-			base.setPosition(x, y, z);
-
-			x = config.getValue("config:kinematics:tangent:X", 0);
-			y = config.getValue("config:kinematics:tangent:Y", 0);
-			z = config.getValue("config:kinematics:tangent:Z", 0);
-			tangent.setPosition(x, y, z);
-
-			x = config.getValue("config:kinematics:target:X", 0);
-			y = config.getValue("config:kinematics:target:Y", 0);
-			z = config.getValue("config:kinematics:target:Z", 0);
-			target.setPosition(x, y, z);
-
-			ofLogNotice(__FUNCTION__) << "\Kinematics: ";
-			ofLogNotice(__FUNCTION__) << "\t\tBase Local Pos: " << ofToString(base.getPosition());
-			ofLogNotice(__FUNCTION__) << "\t\tTangent Local Pos: " << ofToString(tangent.getPosition());
-			ofLogNotice(__FUNCTION__) << "\t\tTarget Local Pos: " << ofToString(target.getPosition());
-			ofLogNotice(__FUNCTION__) << "\t\tTarget Global Pos: " << ofToString(target.getGlobalPosition());
-
-			// limits
-			vel_limit.set(config.getValue("config:limits:vel_limit", 0));
-			accel_limit.set(config.getValue("config:limits:accel_limit", 0));
-			bounds_min.set(config.getValue("config:limits:bounds_min", 0));
-			bounds_max.set(config.getValue("config:limits:bounds_max", 0));
-			position_shutdown = config.getValue("config:limits:bounds_shutdown", 0);
-			torque_min.set(config.getValue("config:limits:torque_min", 0));
-			torque_max.set(config.getValue("config:limits:torque_max", 0));
-
-			ofLogNotice(__FUNCTION__) << "\tLimits: ";
-			ofLogNotice(__FUNCTION__) << "\t\tVel Limit: " << ofToString(vel_limit.get());
-			ofLogNotice(__FUNCTION__) << "\t\tAccel Limit: " << ofToString(accel_limit.get());
-			ofLogNotice(__FUNCTION__) << "\t\tBounds Min: " << ofToString(bounds_min.get());
-			ofLogNotice(__FUNCTION__) << "\t\tBounds Max: " << ofToString(bounds_max.get());
-			ofLogNotice(__FUNCTION__) << "\t\tBounds Shutdown: " << ofToString(position_shutdown);
-			ofLogNotice(__FUNCTION__) << "\t\tTorque Min: " << ofToString(torque_min.get());
-			ofLogNotice(__FUNCTION__) << "\t\tTorque Max: " << ofToString(torque_max.get());
-
-			// jogging
-			jog_vel.set(config.getValue("config:jogging:jog_vel", 0));
-			jog_accel.set(config.getValue("config:jogging:jog_accel", 0));
-
-			ofLogNotice(__FUNCTION__) << "\tJogging: ";
-			ofLogNotice(__FUNCTION__) << "\t\tJog Vel: " << ofToString(jog_vel.get());
-			ofLogNotice(__FUNCTION__) << "\t\tJog Accel: " << ofToString(jog_accel.get());
-
-			// cable drum
-			drum.direction = Groove(config.getValue("config:cable_drum:direction", 0));
-			drum.set_diameter(config.getValue("config:cable_drum:diameter_drum", 0));
-			x = config.getValue("config:cable_drum:tangent:X", 0);
-			y = config.getValue("config:kinematics:tangent:Y", 0);
-			z = config.getValue("config:kinematics:tangent:Z", 0);
-			drum.set_tangent(glm::vec3(x, y, z));
-
-			ofLogNotice(__FUNCTION__) << "\tCable Drum: ";
-			ofLogNotice(__FUNCTION__) << "\t\tDirection: " << (drum.direction == Groove::LEFT_HANDED ? "LEFT_HANDED" : "RIGHT_HANDED");
-			ofLogNotice(__FUNCTION__) << "\t\tDrum Diameter: " << ofToString(drum.get_diameter());
-			ofLogNotice(__FUNCTION__) << "\t\tDrum Tangent: " << ofToString(drum.get_tangent()) << endl;
+	// limits and jogging: set without notifying the listeners, which would reprogram the
+	// hardware limits once per value (and with a half-updated min and max in between)
+	vel_limit.setWithoutEventNotifications(config.vel_limit);
+	accel_limit.setWithoutEventNotifications(config.accel_limit);
+	bounds_min.setWithoutEventNotifications(config.bounds_min);
+	bounds_max.setWithoutEventNotifications(config.bounds_max);
+	position_shutdown = config.bounds_shutdown;
+	torque_min.setWithoutEventNotifications(config.torque_min);
+	torque_max.setWithoutEventNotifications(config.torque_max);
+	jog_vel.setWithoutEventNotifications(config.jog_vel);
+	jog_accel.setWithoutEventNotifications(config.jog_accel);
 
-		}
-		else {
-			ofLogWarning(__FUNCTION__) << "No config file found at: /bin/data/" << filename;
-		}
-	}
-	catch (const std::exception& e)
-	{
-		ofLogError(__FUNCTION__) << e.what();
-	}
-	
-	
+	// cable drum
+	drum.direction = Groove(config.drum_direction);
+	drum.set_diameter(config.drum_diameter);
+	drum.set_tangent(glm::vec3(config.drum_tangent[0], config.drum_tangent[1], config.drum_tangent[2]));
+	drum.length = config.drum_length;
+	drum.turns = config.drum_turns;
+	drum.diameter_cable = config.cable_diameter;
+	drum.guide_distance = config.guide_distance;
+	drum.guide_offset = config.guide_offset;
+	length_correction.scale = config.cable_scale;
+	length_correction.compliance = config.cable_compliance;
+	length_correction.stretch_home = config.cable_stretch_home;
+
+	// the drum geometry sets the cable length per motor step
+	if (kinematics != nullptr)
+		update_mm_per_count();
+
+	// program the motor once, with the new scale
+	motor_controller->get_motor()->set_velocity(config.vel_limit);
+	motor_controller->get_motor()->set_acceleration(config.accel_limit);
+	if (state == RobotState::ENABLED)
+		apply_hardware_limits();
+	config_published = true;
+
+	ofLogNotice(__FUNCTION__) << "Robot " << config.serial_number << ": drum " << drum.get_diameter() << " mm"
+		<< ", bounds " << config.bounds_min << " to " << config.bounds_max << " mm (shutdown " << position_shutdown << ")"
+		<< ", vel " << config.vel_limit << " RPM, accel " << config.accel_limit << " RPM/s"
+		<< ", torque " << config.torque_min << " to " << config.torque_max << " %"
+		<< ", auto home " << (auto_home ? "on" : "off");
+	ofLogVerbose(__FUNCTION__) << "Robot " << config.serial_number << ": base " << ofToString(pos_base) << ", tangent " << ofToString(pos_tangent) << ", target " << ofToString(pos_target)
+		<< ", pitch " << drum.get_pitch() << ", cable " << drum.diameter_cable << ", guide " << drum.guide_distance << " / " << drum.guide_offset
+		<< ", scale " << length_correction.scale << ", compliance " << length_correction.compliance << ", stretch at home " << length_correction.stretch_home;
 }
 
-bool CableRobot::save_config_to_file(string filename)
+/**
+ * @brief Rebuilds the drum's length model, and falls back to the linear scale if the geometry is invalid.
+ */
+void CableRobot::update_mm_per_count()
 {
-	ofxXmlSettings config;
-	int serial_number = int(motor_controller->get_motor()->get()->Info.SerialNumber.Value());
+	CableLengthModel::Geometry geometry;
+	geometry.diameter_drum = drum.get_diameter();
+	geometry.diameter_cable = drum.diameter_cable;
+	geometry.pitch = drum.get_pitch();
+	geometry.guide_distance = drum.guide_distance;
+	geometry.guide_offset = drum.guide_offset;
+	geometry.counts_per_rev = motor_controller->get_motor()->get_resolution();
+	geometry.range = MAX(position_shutdown, bounds_max.get()) * 1.25;
+
+	auto model = std::make_shared<CableLengthModel>();
+	CountScale next = model->build(geometry, length_correction) ?
+		CountScale::from_model(model) :
+		CountScale::from_drum(drum.circumference, geometry.counts_per_rev);
+
+	std::lock_guard<std::mutex> lock(mutex_scale);
+	scales_published.push_back(make_unique<const CountScale>(next));
+	scale.store(scales_published.back().get(), std::memory_order_release);
+}
 
-	// robot
-	config.addTag("config");
-	config.pushTag("config");
+/**
+ * @brief Returns the drum's current scale. Lock-free; safe to call from the control threads.
+ */
+const CountScale& CableRobot::get_scale()
+{
+	static const CountScale none;	// until the robot is configured
+	const CountScale* current = scale.load(std::memory_order_acquire);
+	return current != nullptr ? *current : none;
+}
 
-	config.addValue("timestamp", ofGetTimestampString());
-	config.addValue("serial_number", serial_number);
-	config.addValue("motor_id", motor_controller->get_motor_id());
-	config.addValue("auto_home", auto_home);
+/**
+ * @brief Keeps a control tick's copy of the drum's scale current, copying it only when a
+ * reload has published a new one (a copy also copies the length model's shared_ptr).
+ *
+ * @param (CountScale&)  cached: the tick's copy
+ * @param (const CountScale*&)  cached_from: the scale it was copied from, nullptr at first
+ */
+void CableRobot::cache_scale(CountScale& cached, const CountScale*& cached_from)
+{
+	const CountScale* current = &get_scale();
+	if (current != cached_from) {
+		cached = *current;
+		cached_from = current;
+	}
+}
 
-	// kinematics
-	config.addTag("kinematics");
-	config.pushTag("kinematics");
+/**
+ * @brief Returns the motor's measured torque, as last polled by the safety monitor (so it
+ * doesn't cost a read on the serial link).
+ *
+ * @return (float)  torque (% of max), or 0 without a safety monitor
+ */
+float CableRobot::get_torque_measured()
+{
+	return safety != nullptr ? safety->torque.load(std::memory_order_relaxed) : 0;
+}
 
-	config.addTag("base");
-	config.pushTag("base");	// store the local coordinates
-	config.addValue("X", base.getPosition().x);	
-	config.addValue("Y", base.getPosition().y);
-	config.addValue("Z", base.getPosition().z);
-	config.popTag();
+/**
+ * @brief Calibrates the drum's length model from logged samples (see CableLengthModel::fit),
+ * and rebuilds it. The result is saved with the robot's config.
+ *
+ * @param (string)  filename: samples CSV in the local /bin/data folder. Defaults to "cable_length_<serial>.csv"
+ * @return (bool)  True if the model was fit.
+ */
+bool CableRobot::fit_length_model(string filename)
+{
+	if (filename == "")
+		filename = "cable_length_" + ofToString(get_serial_number()) + ".csv";
 
-	config.addTag("tangent");
-	config.pushTag("tangent");	// store the local coordinates
-	config.addValue("X", tangent.getPosition().x);
-	config.addValue("Y", tangent.getPosition().y);
-	config.addValue("Z", tangent.getPosition().z);
-	config.popTag();
+	vector<CableLengthModel::Sample> samples;
+	if (!CableLengthModel::load_samples(filename, samples))
+		return false;
 
-	config.addTag("target");
-	config.pushTag("target");	// store the local coordinates
-	config.addValue("X", target.getPosition().x);
-	config.addValue("Y", target.getPosition().y);
-	config.addValue("Z", target.getPosition().z);
-	config.popTag();
+	auto model = get_scale().model;
+	CableLengthModel::Correction correction;
+	double rms;
+	if (!model || !model->fit(samples, correction, rms)) {
+		ofLogError(__FUNCTION__) << "Robot " << get_id() << ": could not fit the length model to " << samples.size() << " samples from " << filename;
+		return false;
+	}
 
-	config.popTag();
+	length_correction = correction;
+	update_mm_per_count();
+	ofLogNotice(__FUNCTION__) << "Robot " << get_id() << ": fit " << samples.size() << " samples with an rms error of " << ofToString(rms, 3) << " mm. Scale: " << correction.scale << ", Compliance: " << correction.compliance << ", Stretch at Home: " << correction.stretch_home;
+	return true;
+}
+
+/**
+ * @brief Returns the robot's current config, for saving to the RigConfig store.
+ */
+RobotConfig CableRobot::get_config()
+{
+	RobotConfig config;
+	config.serial_number = get_serial_number();
+	config.motor_id = motor_controller->get_motor_id();
+	config.auto_home = auto_home;
+
+	// kinematics (local coordinates)
+	if (kinematics != nullptr) {
+		glm::vec3 pos_base = kinematics->get_position(node_base);
+		glm::vec3 pos_tangent = kinematics->get_position(node_tangent);
+		glm::vec3 pos_target = kinematics->get_position(node_target);
+		for (int i = 0; i < 3; i++) {
+			config.base[i] = pos_base[i];
+			config.tangent[i] = pos_tangent[i];
+			config.target[i] = pos_target[i];
+		}
+	}
+	else if (has_config) {
+		memcpy(config.base, this->config.base, sizeof(config.base));
+		memcpy(config.tangent, this->config.tangent, sizeof(config.tangent));
+		memcpy(config.target, this->config.target, sizeof(config.target));
+	}
 
 	// limits
-	config.addTag("limits");
-	config.pushTag("limits");
-	config.addValue("vel_limit", vel_limit.get());
-	config.addValue("accel_limit", accel_limit.get());
-	config.addValue("bounds_min", bounds_min.get());
-	config.addValue("bounds_max", bounds_max.get());
-	config.addValue("bounds_shutdown", position_shutdown);
-	config.addValue("torque_min", torque_min.get());
-	config.addValue("torque_max", torque_max.get());
-	config.popTag();
+	config.vel_limit = vel_limit.get();
+	config.accel_limit = accel_limit.get();
+	config.bounds_min = bounds_min.get();
+	config.bounds_max = bounds_max.get();
+	config.bounds_shutdown = position_shutdown;
+	config.torque_min = torque_min.get();
+	config.torque_max = torque_max.get();
 
 	// jogging
-	config.addTag("jogging");
-	config.pushTag("jogging");
-	config.addValue("jog_vel", jog_vel.get());
-	config.addValue("jog_accel", jog_accel.get());
-	config.popTag();
+	config.jog_vel = jog_vel.get();
+	config.jog_accel = jog_accel.get();
 
 	// cable drum
-	config.addTag("cable_drum");
-	config.pushTag("cable_drum");
-	config.addValue("direction", drum.direction);
-	config.addValue("diameter_drum", drum.get_diameter());
-	config.addValue("diameter_cable", 0.3048);
-	config.addValue("length", 30);
-	config.addValue("turns", 40);
-	config.addTag("tangent");
-	config.pushTag("tangent");
-	config.addValue("X", drum.get_tangent().x);
-	config.addValue("Y", drum.get_tangent().y);
-	config.addValue("Z", drum.get_tangent().z);
-	config.popTag();
-	config.popTag();
-
-	config.popTag();
-
-	if (filename == "")
-		filename = "robot_config_" + ofToString(serial_number) + ".xml";
-	
-	return config.saveFile(filename);
+	config.drum_direction = drum.direction;
+	config.drum_diameter = drum.get_diameter();
+	glm::vec3 pos_drum = drum.get_tangent();
+	for (int i = 0; i < 3; i++)
+		config.drum_tangent[i] = pos_drum[i];
+	config.drum_length = drum.length;
+	config.drum_turns = drum.turns;
+	config.cable_diameter = drum.diameter_cable;
+	config.guide_distance = drum.guide_distance;
+	config.guide_offset = drum.guide_offset;
+
+	// cable length compensation
+	config.cable_scale = length_correction.scale;
+	config.cable_compliance = length_correction.compliance;
+	config.cable_stretch_home = length_correction.stretch_home;
+
+	return config;
 }
 
 void CableRobot::update()
@@ -426,9 +508,9 @@ void CableRobot::update()
 		if (run_homing_routine(60)) {
 			bool _is_enabled = is_enabled();
 			state = _is_enabled ? RobotState::ENABLED : RobotState::DISABLED;
-			status.set(state_names[state]);
-			auto color = _is_enabled ? mode_color_enabled : mode_color_disabled;
-			panel.setBorderColor(color);
+			// the soft limits only apply in the homed number space
+			if (_is_enabled)
+				apply_hardware_limits();
 		}
 		else {
 			//state = RobotState::NOT_HOMED;
@@ -440,7 +522,7 @@ void CableRobot::update()
 	if (move_type == MoveType::VEL) {
 
 		if (state != RobotState::E_STOP) {
-			if (is_in_bounds(abs(actual.getPosition().y), true)){	
+			if (is_in_bounds(abs(kinematics->get_position(node_actual).y), true)){	
 				// @FIXME: do move
 				
 			}
@@ -457,61 +539,59 @@ void CableRobot::update()
 		//ofLogNotice(__FUNCTION__) << motor_controller->get_motor_id() << " gizmo_ee global position: " << ofToString(gizmo_ee.getTranslation()) << endl;
 	}
 
-	// update the actual positions
-	position_actual = get_position_actual();
-	actual.setPosition(0, -1 * position_actual, 0);
+	// update the actual positions (read for all the robots at once by RobotController)
+	kinematics->set_position(node_actual, glm::vec3(0, -1 * position_actual, 0));
 
 	// update the gui
 	//info_velocity_actual.set(ofToString(motor_controller->get_motor()->get()->Motion.VelMeasured.Value()));
 }
 
-void CableRobot::draw()
+void CableRobot::draw(BatchRenderer& batch)
 {
 	ofPushStyle();
 
-	ofSetLineWidth(2);
-	ofSetColor(255);
-	ofNoFill();
+	glm::vec3 base = kinematics->get_global_position(node_base);
+	glm::vec3 tangent = kinematics->get_global_position(node_tangent);
+	glm::vec3 target = kinematics->get_global_position(node_target);
+	glm::vec3 actual = kinematics->get_global_position(node_actual);
+	glm::vec3 ee = kinematics->get_global_position(node_ee);
+	float ee_y = kinematics->get_position(node_ee).y;
 
 	// draw base and tangent nodes
-	ofDrawEllipse(base.getGlobalPosition(), drum.get_diameter(), drum.get_diameter());
-	ofDrawLine(base.getGlobalPosition(), tangent.getGlobalPosition());
-	base.draw();
-	tangent.draw();
+	batch.add_ellipse(base, drum.get_diameter(), drum.get_diameter(), ofColor(255), false, 2);
+	batch.add_line(base, tangent, ofColor(255), 2);
+	kinematics->get_node(node_base).draw();
+	kinematics->get_node(node_tangent).draw();
 
 
 	// draw current ee
 
 	// draw ghosted line between tangent and target & ee and target
 	// show RED if the target is out of bounds
-	if (-1 * ee->getPosition().y > bounds_min.get() && 
-		-1 * ee->getPosition().y < bounds_max.get()) {
-		ofSetLineWidth(1);
-		ofSetColor(120);
+	if (-1 * ee_y > bounds_min.get() && 
+		-1 * ee_y < bounds_max.get()) {
+		batch.add_line(tangent, target, ofColor(120), 1);
+		batch.add_line(ee, target, ofColor(120), 1);
 	}
 	else {
-		ofSetLineWidth(5);
-		ofSetColor(ofColor::red, 30);
+		batch.add_line(tangent, target, ofColor(ofColor::red, 30), 5);
+		batch.add_line(ee, target, ofColor(ofColor::red, 30), 5);
 	}
-	ofDrawLine(tangent.getGlobalPosition(), target.getGlobalPosition());
-	ofDrawLine(ee->getGlobalPosition(), target.getGlobalPosition());
 	
 
 	// draw the target
-	ofFill();
-	ofSetColor(ofColor::red, 200);
-	ofDrawEllipse(target.getGlobalPosition(), 50, 50);
+	batch.add_ellipse(target, 50, 50, ofColor(ofColor::red, 200));
 	
 
 
 	if (debugging) {
 		// draw the 1D trajectory and actual position
-		draw_cable(tangent.getGlobalPosition(), actual.getGlobalPosition());
+		draw_cable(batch, tangent, actual);
 
 		// draw distance to target
 		ofSetColor(60);
-		string msg = ofToString(glm::distance(tangent.getGlobalPosition(), target.getGlobalPosition())) + " (mm)";
-		auto pt = target.getGlobalPosition();
+		string msg = ofToString(glm::distance(tangent, target)) + " (mm)";
+		auto pt = target;
 		int offset = 50;
 		if (motor_controller->get_motor_id() % 2 == 0) {
 			offset *= -5.5;
@@ -519,26 +599,24 @@ void CableRobot::draw()
 		ofDrawBitmapString(msg, pt.x + offset, pt.y - 10, pt.z);
 
 		// draw distance to actual
-		msg = ofToString(glm::distance(tangent.getGlobalPosition(), actual.getGlobalPosition())) + " (mm)";
-		pt = (tangent.getGlobalPosition() + actual.getGlobalPosition()) / 2.0;
+		msg = ofToString(glm::distance(tangent, actual)) + " (mm)";
+		pt = (tangent + actual) / 2.0;
 		ofDrawBitmapString(msg, pt.x + offset, pt.y - 10, pt.z);
 	}
 
 	// draw the trajectory and actual position in (simulated) world coordinates
 	if (trajectory_world_coords.getVertices().size() > 0) {
-		ofSetLineWidth(5);
-		ofSetColor(255, 0, 255, 100);
-		trajectory_world_coords.draw();
-
-		float dist = actual.getPosition().y;
-		glm::vec3 heading = glm::normalize(tangent.getGlobalPosition() - trajectory_world_coords.getVertices()[0]) * dist ;
-		actual_world_pos = tangent.getGlobalPosition() + heading;
-		draw_cable(tangent.getGlobalPosition(), actual_world_pos);
+		batch.add_polyline(trajectory_world_coords, ofColor(255, 0, 255, 100), 5);
+
+		float dist = kinematics->get_position(node_actual).y;
+		glm::vec3 heading = glm::normalize(tangent - trajectory_world_coords.getVertices()[0]) * dist ;
+		actual_world_pos = tangent + heading;
+		draw_cable(batch, tangent, actual_world_pos);
 	}
 
 	//// draw distance to actual in (simulated) world coordinates
-	//msg = ofToString(glm::distance(tangent.getGlobalPosition(), actual.getGlobalPosition())) + " (mm)";
-	//pt = (tangent.getGlobalPosition() + actual.getGlobalPosition()) / 2.0;
+	//msg = ofToString(glm::distance(tangent, actual)) + " (mm)";
+	//pt = (tangent + actual) / 2.0;
 	//ofDrawBitmapString(msg, pt.x + offset, pt.y - 10, pt.z);
 
 	ofPopStyle();
@@ -552,12 +630,11 @@ void CableRobot::draw()
 void CableRobot::update_gizmo()
 {
 	if (override_gizmo) {
-		gizmo_ee.setNode(*ee);
+		gizmo_ee.setNode(kinematics->get_node(node_ee));
 	}
-	else if (gizmo_ee.getTranslation() != ee->getGlobalPosition() ||
-		gizmo_ee.getRotation() != ee->getGlobalOrientation()) {
-		ee->setGlobalPosition(gizmo_ee.getTranslation());
-		ee->setGlobalOrientation(gizmo_ee.getRotation());
+	else if (gizmo_ee.getTranslation() != kinematics->get_global_position(node_ee) ||
+		gizmo_ee.getRotation() != kinematics->get_global_orientation(node_ee)) {
+		kinematics->set_global_transform(node_ee, gizmo_ee.getTranslation(), gizmo_ee.getRotation());
 		
 		if (gizmo_ee.isInteracting()) {
 			// update the gui
@@ -568,7 +645,7 @@ void CableRobot::update_gizmo()
 }
 
 void CableRobot::update_move_to() {
-	float dist = glm::distance(tangent.getGlobalPosition(), target.getGlobalPosition());
+	float dist = glm::distance(get_tangent(), get_target());
 	// don't go past the min bounds
 	if (dist < bounds_min.get())
 		dist = bounds_min.get();
@@ -670,7 +747,7 @@ bool CableRobot::is_in_bounds_absolute(float target_pos_absolute)
  */
 bool CableRobot::is_in_bounds_relative(float target_pos_relative)
 {
-	int curr_pos = count_to_mm(motor_controller->get_motor()->get_position(), true);
+	float curr_pos = count_to_mm(motor_controller->get_motor()->get_position(), true);
 	// (-) relative move is UP
 	if (target_pos_relative < 0) {
 		return curr_pos - abs(target_pos_relative) >= bounds_min.get();
@@ -695,7 +772,7 @@ bool CableRobot::is_in_bounds(float target_pos, bool is_absolute)
 		return target_pos >= bounds_min.get() && target_pos <= bounds_max.get();
 	}
 	else {
-		int curr_pos = count_to_mm(motor_controller->get_motor()->get_position(), true);
+		float curr_pos = count_to_mm(motor_controller->get_motor()->get_position(), true);
 		// (-) relative move is UP
 		if (target_pos < 0) {
 			return curr_pos - abs(target_pos) >= bounds_min.get();
@@ -719,38 +796,85 @@ int CableRobot::get_rotation_direction()
 }
 
 /**
- * @brief Checks if the robot is homed, updates the state,
- * and updates the GUI.
+ * @brief Checks if the robot is homed, and updates the state.
+ * The GUI thread shows it on its next frame (see update_gui).
  */
 void CableRobot::check_for_system_ready()
 {
 	RobotState _state;
-	ofColor color;
 
 	// check for ESTOP first
 	if (is_estopped())
 	{
 		_state = RobotState::E_STOP;
-		color = mode_color_estopped;
 		e_stop.set(true);
 	}
 	else if (!is_homed()) {
 
 		_state = RobotState::NOT_HOMED;
-		color = mode_color_not_homed;
 	}
 	else {
-		bool _is_enabled = is_enabled();
+		bool _is_enabled = motor_controller->get_motor()->is_enabled();
 		_state = _is_enabled ? RobotState::ENABLED : RobotState::DISABLED;
-		color = _is_enabled ? mode_color_enabled : mode_color_disabled;
 
 		// check that the gui matched the current state
 		if (enable.get() != _is_enabled)
 			enable.set(_is_enabled);
 	}
 	state = _state;
-	status.set(state_names[state]);
-	panel.setBorderColor(color);
+}
+
+/**
+ * @brief Shows the latest state and velocity plot in the GUI. Call from the GUI thread only:
+ * the control threads just publish into atomics, so they never run the GUI listeners.
+ */
+void CableRobot::update_gui()
+{
+	RobotState s = state.load();
+	if (s != state_shown || status.get() != state_names[s]) {
+		state_shown = s;
+		status.set(state_names[s]);
+		panel.setBorderColor(get_state_color(s));
+	}
+	uint64_t published = plot_published.load(std::memory_order_acquire);
+	if (published != plot_shown) {
+		plot_shown = published;
+		plot_data_gui[0] = plot_rpm.load(std::memory_order_relaxed);
+		plot_data_gui[1] = plot_rpm_smoothed.load(std::memory_order_relaxed);
+		plot_vel.update(plot_data_gui);
+	}
+	float rpm = velocity_target.load(std::memory_order_relaxed);
+	if (rpm != velocity_target_shown) {
+		velocity_target_shown = rpm;
+		info_velocity_target.set(ofToString(rpm, 1));
+	}
+	if (config_published.exchange(false)) {
+		// already applied to the motor by apply_config; re-set so the sliders and info redraw
+		refreshing_gui = true;
+		vel_limit.set(vel_limit.get());
+		accel_limit.set(accel_limit.get());
+		bounds_min.set(bounds_min.get());
+		bounds_max.set(bounds_max.get());
+		torque_min.set(torque_min.get());
+		torque_max.set(torque_max.get());
+		jog_vel.set(jog_vel.get());
+		jog_accel.set(jog_accel.get());
+		refreshing_gui = false;
+	}
+}
+
+ofColor CableRobot::get_state_color(RobotState s)
+{
+	switch (s) {
+	case RobotState::E_STOP:
+		return mode_color_estopped;
+	case RobotState::ENABLED:
+		return mode_color_enabled;
+	case RobotState::DISABLED:
+		return mode_color_disabled;
+	default:
+		return mode_color_not_homed;
+	}
 }
 
 /**
@@ -793,6 +917,7 @@ void CableRobot::setup_gui()
 	params_control.add(e_stop.set("E_Stop", false));
 	params_control.add(btn_run_homing.set("Run_Homing"));
 	params_control.add(btn_run_shutdown.set("Run_Shutdown"));
+	params_control.add(btn_fit_length_model.set("Fit_Length_Model"));
 
 	params_info.setName("Info");
 	params_info.add(info_position_mm.set("Position_(mm)", ""));
@@ -831,6 +956,7 @@ void CableRobot::setup_gui()
 	enable.addListener(this, &CableRobot::on_enable);
 	btn_run_homing.addListener(this, &CableRobot::on_run_homing);
 	btn_run_shutdown.addListener(this, &CableRobot::on_run_shutdown);
+	btn_fit_length_model.addListener(this, &CableRobot::on_fit_length_model);
 	move_to_pos.addListener(this, &CableRobot::on_move_to_pos);
 	move_to.addListener(this, &CableRobot::on_move_to_changed);
 	move_to_vel.addListener(this, &CableRobot::on_move_to_vel);
@@ -868,16 +994,16 @@ void CableRobot::setup_gui()
 /**
  * @brief Converts from motor position (count) to linear distance (mm).
  *
- * @param (int)  val: motor position (in step counts)
+ * @param (int64_t)  val: motor position (in step counts)
  * @param (bool) use_unsigned: returns abs(val) if true. False by default.
  * 
  * @return (float)  linear distance (in mm)
  */
-float CableRobot::count_to_mm(int val, bool use_unsigned)
+float CableRobot::count_to_mm(int64_t val, bool use_unsigned)
 {
-	if(use_unsigned)
-		return abs(val) * mm_per_count;
-	return val * mm_per_count;
+	float mm;
+	CountScale::to_mm(&val, &get_scale(), &mm, 1, use_unsigned);
+	return mm;
 }
 
 /**
@@ -886,25 +1012,26 @@ float CableRobot::count_to_mm(int val, bool use_unsigned)
  * @param (float)  val:  linear distance (in mm)
  * @param (bool) use_unsigned: returns abs(val) if true. False by default.
  * 
- * @return (int) motor position (in step counts)
+ * @return (int64_t) motor position (in step counts), rounded to the nearest count
  */
-int CableRobot::mm_to_count(float val, bool use_unsigned)
+int64_t CableRobot::mm_to_count(float val, bool use_unsigned)
 {
-	if (use_unsigned)
-		return abs(val) / mm_per_count;
-	return val / mm_per_count;
+	int64_t count;
+	CountScale::to_counts(&val, &get_scale(), &count, 1, use_unsigned);
+	return count;
 }
 
+/**
+ * @brief Safe to call from the control threads: only the atomic state is updated, the GUI
+ * picks it up in update_gui.
+ */
 bool CableRobot::is_enabled()
 {
 	bool val = motor_controller->get_motor()->is_enabled();
 
-	if (is_homed()) {
-		if (val)
-			panel.setBorderColor(mode_color_enabled);
-		else
-			panel.setBorderColor(mode_color_disabled);
-	}
+	// a homed robot follows its motor between ENABLED and DISABLED
+	RobotState expected = val ? RobotState::DISABLED : RobotState::ENABLED;
+	state.compare_exchange_strong(expected, val ? RobotState::ENABLED : RobotState::DISABLED);
 	return val;
 }
 
@@ -916,22 +1043,16 @@ bool CableRobot::is_moving()
 bool CableRobot::is_estopped()
 {
 	bool val = motor_controller->get_motor()->is_estopped();
-	if (val) {
-		panel.setBorderColor(mode_color_estopped);
+	if (val)
 		state = RobotState::E_STOP;
-		status.set(state_names[state]);
-	}
 	return val;
 }
 
 bool CableRobot::is_homed()
 {
 	bool val = motor_controller->get_motor()->is_homed();
-	if (!val) {
-		panel.setBorderColor(mode_color_not_homed);
+	if (!val && state != RobotState::HOMING)
 		state = RobotState::NOT_HOMED;
-		status.set(state_names[state]);
-	}
 	return val;
 }
 
@@ -944,7 +1065,6 @@ bool CableRobot::is_homed()
 bool CableRobot::run_homing_routine(int timeout)
 {
 	state = RobotState::HOMING;
-	status.set(state_names[state]);
 	return motor_controller->get_motor()->run_homing_routine(timeout);
 }
 /**
@@ -966,10 +1086,11 @@ void CableRobot::move_position(float target_pos, bool is_absolute)
 		if (is_absolute) {
 			// convert from mm to motor counts and flip sign based on cable drum groove direction
 			if (is_in_bounds(target_pos, true)) {
-				glm::vec3 pos = glm::vec3(0, -1 * target_pos, 0);
-				ee->setPosition(pos);
+				// only drive the ee when it belongs to this robot (1D), not a shared 2D ee
+				if (ee_internal)
+					kinematics->set_position(node_ee, glm::vec3(0, -1 * target_pos, 0));
 				//target.setPosition(glm::vec3(0, -1 * target_pos, 0));
-				int count = mm_to_count(abs(target_pos)) * get_rotation_direction();
+				int count = int(mm_to_count(abs(target_pos))) * get_rotation_direction();
 				motor_controller->get_motor()->move_position(count, true);
 			}
 			else
@@ -993,16 +1114,10 @@ void CableRobot::move_position(float target_pos, bool is_absolute)
 }
 
 
-void CableRobot::draw_cable(glm::vec3 start, glm::vec3 end)
+void CableRobot::draw_cable(BatchRenderer& batch, glm::vec3 start, glm::vec3 end)
 {
-	ofPushStyle();
-	ofSetColor(255);
-	ofSetLineWidth(2);
-	ofDrawLine(start, end);
-	ofFill();
-	ofSetColor(ofColor::orange, 200);
-	ofDrawEllipse(end, 40, 40);
-	ofPopStyle();
+	batch.add_line(start, end, ofColor(255), 2);
+	batch.add_ellipse(end, 40, 40, ofColor(ofColor::orange, 200));
 }
 
 void CableRobot::move_velocity_rpm(float rpm)
@@ -1023,8 +1138,8 @@ void CableRobot::move_velocity_rpm(float rpm)
 		// send velocity command to motor
 		motor_controller->get_motor()->move_velocity(rpm);
 
-		// update the gui
-		//info_velocity_target.set(ofToString(rpm));
+		// published for the gui (see update_gui)
+		velocity_target.store(rpm, std::memory_order_relaxed);
 	}
 	else {
 		string msg = "";
@@ -1039,12 +1154,27 @@ void CableRobot::move_velocity_rpm(float rpm)
 }
 
 float CableRobot::compute_velocity()
+{
+	return compute_velocity(get_position_actual());
+}
+
+/**
+ * @brief Computes the RPM toward the target from an already read cable position.
+ *
+ * @param (float)  position_actual: cable length paid out (in mm, (+) only)
+ * @return (float)  RPM
+ */
+float CableRobot::compute_velocity(float position_actual)
 {
 	// Get distance from actual to desired position
-	position_actual = get_position_actual();
-	float pos_desired = glm::distance(tangent.getGlobalPosition(), target.getGlobalPosition());
+	this->position_actual = position_actual;
+	float pos_desired = glm::distance(get_tangent(), get_target());
 	float dist = abs(pos_desired - position_actual);
 	actual_to_desired_distance = dist;
+	if (safety != nullptr) {
+		safety->set_limits(bounds_min.get(), bounds_max.get(), torque_min.get(), torque_max.get());
+		safety->publish(position_actual, pos_desired);
+	}
 	float heading = (pos_desired > position_actual) ? -1 : 1;
 
 	// Scale velocity to sync with external motors (scalar = 1.0 for 1D configurations)
@@ -1078,7 +1208,9 @@ float CableRobot::compute_velocity()
 	if (debugging) {
 		plot_data_vel[0] = rpm;
 		plot_data_vel[1] = smoothed_val;// velocity_controller.get_smoothed_val();
-		plot_vel.update(plot_data_vel);
+		plot_rpm.store(rpm, std::memory_order_relaxed);
+		plot_rpm_smoothed.store(smoothed_val, std::memory_order_relaxed);
+		plot_published.fetch_add(1, std::memory_order_release);
 	}
 
 
@@ -1091,8 +1223,8 @@ void CableRobot::stop()
 	move_type = MoveType::POS;
 	motor_controller->get_motor()->stop();
 
-	// upadate the gui
-	info_velocity_target.set("0");
+	// published for the gui (see update_gui); stop() runs on the control and safety threads
+	velocity_target.store(0, std::memory_order_relaxed);
 	velocity_controller.reset();
 }
 
@@ -1113,16 +1245,10 @@ void CableRobot::set_enabled(bool val)
 void CableRobot::on_enable(bool& val)
 {
 	set_enabled(val);
+	if (val && is_homed())
+		apply_hardware_limits();
 	if (is_homed()) {
-		if (val) {
-			panel.setBorderColor(mode_color_enabled);
-			state = RobotState::ENABLED;
-		}
-		else {
-			panel.setBorderColor(mode_color_disabled);
-			state = RobotState::DISABLED;
-		}
-		status.set(state_names[state]);
+		state = val ? RobotState::ENABLED : RobotState::DISABLED;
 	}
 }
 
@@ -1134,18 +1260,13 @@ void CableRobot::on_enable(bool& val)
 void CableRobot::on_e_stop(bool& val)
 {
 	set_e_stop(val);
-	ofColor color;
 	if (val) {
-		color = mode_color_estopped;
 		state = RobotState::E_STOP;
 	}
 	else {
-		bool _is_enabled = is_enabled();
+		bool _is_enabled = motor_controller->get_motor()->is_enabled();
 		state = _is_enabled ? RobotState::ENABLED : RobotState::DISABLED;
-		color = _is_enabled ? mode_color_enabled : mode_color_disabled;;
 	}
-	panel.setBorderColor(color);
-	status.set(state_names[state]);
 }
 
 /**
@@ -1155,7 +1276,6 @@ void CableRobot::on_e_stop(bool& val)
 void CableRobot::on_run_homing()
 {
 	state = RobotState::HOMING;
-	status.set(state_names[state]);
 }
 
 /**
@@ -1170,6 +1290,14 @@ void CableRobot::on_run_shutdown()
 	shutdown(timeout);
 }
 
+/**
+ * @brief Fits the length model to this robot's logged samples. Save the settings to keep the result.
+ */
+void CableRobot::on_fit_length_model()
+{
+	fit_length_model();
+}
+
 /**
  * @brief Jogs the robot up relative to its current postion.
  * Compensates for sign based on RIGHT- or LEFT-HANDED cable drum.
@@ -1245,7 +1373,7 @@ void CableRobot::jog_down(bool override) {
 		}
 		// override bounds_max for shutdown routine; send the move directly to the motor
 		else {
-			int count = mm_to_count(jog_dist.get()) * get_rotation_direction();	
+			int count = int(mm_to_count(jog_dist.get())) * get_rotation_direction();	
 			motor_controller->get_motor()->move_position(count, false);
 		}
 	}
@@ -1272,9 +1400,14 @@ void CableRobot::on_jog_down()
 
 void CableRobot::on_move_to_changed(float& val)
 {
+	if (!ee_internal || kinematics == nullptr)
+		return;
 	glm::vec3 pos = glm::vec3(0, -1 * val, 0);
-	ee->setPosition(pos);
-	gizmo_ee.setNode(*ee);
+	kinematics->set_position(node_ee, pos);
+	ofNode node;
+	node.setGlobalPosition(kinematics->get_global_position(node_tangent) + kinematics->get_global_orientation(node_tangent) * pos);
+	node.setGlobalOrientation(kinematics->get_global_orientation(node_ee));
+	gizmo_ee.setNode(node);
 }
 
 /**
@@ -1284,12 +1417,14 @@ void CableRobot::on_move_to_pos()
 {
 	move_to_vel.set(false);
 	move_type = MoveType::POS;
-	float dist = glm::distance(tangent.getGlobalPosition(), target.getGlobalPosition());;
+	float dist = glm::distance(get_tangent(), get_target());
 	move_position(dist, true);// move_to.get(), true);
 }
 
 void CableRobot::on_move_to_vel(bool &val)
 {
+	if (safety != nullptr)
+		safety->streaming.store(val);
 	if (val)
 		// velocity moves are handled in update()
 		move_type = MoveType::VEL;
@@ -1303,6 +1438,8 @@ void CableRobot::on_bounds_changed(float& val)
 {
 	move_to.setMin(bounds_min.get());
 	move_to.setMax(bounds_max.get());
+	if (state == RobotState::ENABLED && !refreshing_gui)
+		apply_hardware_limits();
 }
 
 /**
@@ -1312,7 +1449,8 @@ void CableRobot::on_bounds_changed(float& val)
  */
 void CableRobot::on_vel_limit_changed(float& val)
 {
-	motor_controller->get_motor()->set_velocity(val);	
+	if (!refreshing_gui)
+		motor_controller->get_motor()->set_velocity(val);
 	// update the gui
 	info_vel_limit.set(ofToString(val));
 }
@@ -1324,7 +1462,8 @@ void CableRobot::on_vel_limit_changed(float& val)
  */
 void CableRobot::on_accel_limit_changed(float& val)
 {
-	motor_controller->get_motor()->set_acceleration(val);
+	if (!refreshing_gui)
+		motor_controller->get_motor()->set_acceleration(val);
 	// update the gui
 	info_accel_limit.set(ofToString(val));
 }
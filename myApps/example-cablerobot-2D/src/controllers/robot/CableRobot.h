@@ -2,12 +2,16 @@
 
 #include "ofMain.h"
 #include "ofxGui.h"
-#include "ofxXmlSettings.h"
 #include "ofxGizmo.h"
 #include "CableDrum.h"
+#include "CablePosition.h"
+#include "KinematicGraph.h"
 #include "MotorController.h"
+#include "RigConfig.h"
+#include "SafetyMonitor.h"
 
 #include "../TimeSeriesPlot.h"
+#include "../BatchRenderer.h"
 #include "../PD_Controller.h"
 
 #include "pubSysCls.h"
@@ -17,7 +21,8 @@ using namespace sFnd;
 class CableRobot
 {
 private:
-    ofxXmlSettings config;
+    RobotConfig config;         // last config loaded from the RigConfig store
+    bool has_config = false;
 
     // Motion Parameters
     float velocity_max = 300;   // RPM
@@ -34,18 +39,21 @@ private:
 
     float desired_velocity = 0.0;
 
-    // Kinematics
-    ofNode* origin = new ofNode();     // external parent node (in world coordinates)
-    ofNode* ee = new ofNode();         // external parent ee node
-    ofNode base = ofNode();        // center of cable drum
-    ofNode tangent = ofNode();     // tangent point on the cable drum
-    ofNode target = ofNode();      // desired ee position
-    ofNode actual = ofNode();      // actual ee position
+    // Kinematics (frame indices into the shared KinematicGraph)
+    KinematicGraph* kinematics = nullptr;
+    int node_origin = -1;   // external parent frame (in world coordinates)
+    int node_ee = -1;       // external (or internal) parent ee frame
+    int node_base = -1;     // center of cable drum
+    int node_tangent = -1;  // tangent point on the cable drum
+    int node_target = -1;   // desired ee position
+    int node_actual = -1;   // actual ee position
+    bool ee_internal = false;
    
     void setup_plots();
 
 
     MotorController* motor_controller;
+    SafetyMonitor::Channel* safety = nullptr;     // status published for the safety monitor
     CableDrum drum = CableDrum();
 
     void setup_gui();
@@ -53,11 +61,16 @@ private:
 
     bool shutdown(int timeout=20);
 
-    float mm_per_count;
-    float count_to_mm(int val, bool use_unsigned = false);
-    int mm_to_count(float val, bool use_unsigned = false);
+    // drum scale and length model, rebuilt on config reload and published by pointer swap, so the
+    // control ticks read it without a lock. Replaced scales are kept until the robot is freed,
+    // since a tick may still be converting with one.
+    std::mutex mutex_scale;                                 // serializes rebuilds
+    std::atomic<const CountScale*> scale{ nullptr };
+    vector<unique_ptr<const CountScale>> scales_published;
+    CableLengthModel::Correction length_correction;
+    void update_mm_per_count();
 
-    void draw_cable(glm::vec3 _anchor, glm::vec3 _target);
+    void draw_cable(BatchRenderer& batch, glm::vec3 _anchor, glm::vec3 _target);
 
     enum RobotState {
         NOT_HOMED,
@@ -66,7 +79,10 @@ private:
         DISABLED,
         E_STOP
     };
-    RobotState state = RobotState::NOT_HOMED;
+    // set from any thread; the GUI thread shows it once per frame (see update_gui)
+    std::atomic<RobotState> state{ RobotState::NOT_HOMED };
+    RobotState state_shown = RobotState::NOT_HOMED;
+    ofColor get_state_color(RobotState s);
     string state_names[5] = { "NOT_HOMED", "HOMING", "ENABLED", "DISABLED", "E_STOP"};
 
     bool auto_home = false;
@@ -77,14 +93,22 @@ private:
         VEL
     };
     MoveType move_type = MoveType::POS;
-    void load_config_from_file(string filename=""); // <-- crashes if called externally for some reason
+    void apply_config();
+    // apply_config runs on the controller thread and sets the limits without notifying the GUI;
+    // update_gui then re-sets them so the sliders redraw, with the listeners' hardware writes skipped
+    std::atomic<bool> config_published{ false };
+    bool refreshing_gui = false;
 public:
     CableRobot();
     CableRobot(SysManager& SysMgr, INode* node, bool load_config_file = true);
+    CableRobot(SysManager& SysMgr, INode* node, NodeInfo info, bool load_config_file = true);
+    CableRobot(MotorController* motor_controller, bool load_config_file = true);
     CableRobot(glm::vec3 base);
 
     bool load_config_file = true;
-    bool save_config_to_file(string filename="");
+    void set_config(const RobotConfig& config);
+    RobotConfig get_config();
+    int get_serial_number() { return motor_controller->get_motor()->get_serial_number(); }
 
     ofxGizmo* get_gizmo() { return &gizmo_ee; }
     bool override_gizmo = false;
@@ -92,19 +116,21 @@ public:
     void update_move_to();
 
     void update();
-    void draw();
+    void update_gui();
+    void draw(BatchRenderer& batch);
     void key_pressed(int key);
     int get_id();
 
-    void configure(ofNode* _origin,
-        ofNode* _ee,
+    void configure(KinematicGraph* _kinematics,
+        int _origin,
+        int _ee,
         glm::vec3 base,
         Groove direction = Groove::LEFT_HANDED,
         float diameter_drum = 99.95,
         float length = 30 ,
         int turns = 30
     );
-    void configure(ofNode* _origin, glm::vec3 base, ofNode* _ee = new ofNode());
+    void configure(KinematicGraph* _kinematics, int _origin, glm::vec3 base, int _ee = -1);
     void check_for_system_ready();
     bool is_ready();
 
@@ -112,6 +138,7 @@ public:
 
     float position_actual = 0; // in mm (+) val only
     float get_position_actual();
+    int64_t get_position_counts();
     vector<float> get_motion_parameters();
     void set_motion_parameters(float velocity_max, float accel_max, float position_min, float position_max);
    
@@ -122,18 +149,33 @@ public:
     void set_accel_limit(float accel_max);
     void set_bounds(float min, float max);
 
-    ofNode get_tangent() { return tangent; }
-    ofNode* get_tangent_ptr() { return &tangent; }
-    ofNode* get_target() { return &target; }
-    void set_ee(ofNode* _ee) { this->ee = _ee; }
+    glm::vec3 get_tangent() { return kinematics->get_global_position(node_tangent); }
+    glm::vec3 get_target() { return kinematics->get_global_position(node_target); }
+    void set_target_position(glm::vec3 pos) { kinematics->set_position(node_target, pos); }
     ofPolyline trajectory_world_coords;
     glm::vec3 actual_world_pos;
 
     MotorController* get_motor_controller() { return motor_controller; }
 
-    ofNode get_base() { return base; }
-    void set_base_position(glm::vec3 pos) { base.setPosition(pos); }
-
+    glm::vec3 get_base() { return kinematics->get_global_position(node_base); }
+    glm::quat get_base_orientation() { return kinematics->get_global_orientation(node_base); }
+    glm::vec3 get_base_position() { return kinematics->get_position(node_base); }
+    float get_mm_per_rev() { return drum.circumference; }
+    float get_drum_diameter() { return drum.get_diameter(); }
+    float get_cable_diameter() { return drum.diameter_cable; }
+    const CountScale& get_scale();
+    void cache_scale(CountScale& cached, const CountScale*& cached_from);
+    float get_torque_measured();
+    bool fit_length_model(string filename = "");
+    float count_to_mm(int64_t val, bool use_unsigned = false);
+    int64_t mm_to_count(float val, bool use_unsigned = false);
+    void set_base_position(glm::vec3 pos) { kinematics->set_position(node_base, pos); }
+
+    void set_safety_channel(SafetyMonitor::Channel* channel);
+    void apply_hardware_limits();
+    SafetyMonitor::Channel* get_safety_channel() { return safety; }
+
+    string get_state_name() { return state_names[state.load()]; }
     bool is_estopped();
     bool is_homed();
     bool is_enabled();
@@ -146,12 +188,20 @@ public:
     void move_velocity_rpm(float rpm);
     void set_desired_velocity(float rpm);
     float compute_velocity();
+    float compute_velocity(float position_actual);
     float velocity_scalar = 1.0;
     float actual_to_desired_distance = 0;
     PD_Controller velocity_controller;
 
     TimeSeriesPlot plot_vel = TimeSeriesPlot(2);
-    vector<float> plot_data_vel = { 0, 0 };
+    vector<float> plot_data_vel = { 0, 0 };         // control thread
+    std::atomic<float> plot_rpm{ 0 };               // published for the GUI thread's plot
+    std::atomic<float> plot_rpm_smoothed{ 0 };
+    std::atomic<uint64_t> plot_published{ 0 };
+    uint64_t plot_shown = 0;
+    vector<float> plot_data_gui = { 0, 0 };
+    std::atomic<float> velocity_target{ 0 };        // RPM, published for the GUI thread's info
+    float velocity_target_shown = 0;
 
     void stop();
     void set_e_stop(bool val);
@@ -166,6 +216,7 @@ public:
     void on_e_stop(bool& val);
     void on_run_homing();
     void on_run_shutdown();
+    void on_fit_length_model();
     void on_jog_up();
     void on_jog_down();
     void on_move_to_changed(float& val);
@@ -182,6 +233,7 @@ public:
     ofParameter<bool> e_stop = false;
     ofParameter<void> btn_run_homing;
     ofParameter<void> btn_run_shutdown;
+    ofParameter<void> btn_fit_length_model;
 
     ofParameterGroup params_info;
     ofParameter<string> info_position_mm;
@@ -1,6 +1,6 @@
 #include "CableRobot2D.h"
 
-CableRobot2D::CableRobot2D(CableRobot* top_left, CableRobot* top_right, ofNode* _origin, glm::vec3 base_top_left, glm::vec3 base_top_right, int id)
+CableRobot2D::CableRobot2D(CableRobot* top_left, CableRobot* top_right, KinematicGraph* _kinematics, int _origin, glm::vec3 base_top_left, glm::vec3 base_top_right, int id, bool run_threaded)
 {
 	robots.push_back(top_left);
 	robots.push_back(top_right);
@@ -9,36 +9,32 @@ CableRobot2D::CableRobot2D(CableRobot* top_left, CableRobot* top_right, ofNode*
 	this->base_top_left = base_top_left;
 	this->base_top_right = base_top_right;
 
+	this->kinematics = _kinematics;
 	this->origin = _origin;
 	this->id = id;
 
 	setup_gui();
 
 	
-	// Setup the end effector
-	this->ee = new ofNode();
-	this->ee->setParent(top_left->get_base());
+	// Setup the end effector (a world frame, so it is added before the robots' targets)
+	this->ee = kinematics->add();
 	float h = robots[0]->bounds_max - robots[0]->bounds_min;
-	float width = glm::distance(top_left->get_base().getGlobalPosition(), top_right->get_base().getGlobalPosition());
-	glm::vec3 pos = glm::vec3((width / 2.0), - h / 2, top_left->get_base().getGlobalPosition().z);
-	this->ee->setGlobalPosition(pos);
 
 	// setup the end effector control gizmo
-	gizmo_ee.setNode(*ee);
 	gizmo_ee.setDisplayScale(.5);
 
 	gizmo_ee.setRotationAxisMask(IGizmo::AXIS_Z);
 	gizmo_ee.setScaleAxisMask(IGizmo::AXIS_X);
 
 	// Configure the robots with one end effector
-	robots[0]->configure(_origin, base_top_left, this->ee);
-	robots[1]->configure(_origin, base_top_right, this->ee);
+	robots[0]->configure(kinematics, origin, base_top_left, this->ee);
+	robots[1]->configure(kinematics, origin, base_top_right, this->ee);
 
 	// Setup the 2D bounds
 	bounds.setHeight(-1 * h);
-	float w = robots[1]->get_tangent().getGlobalPosition().x - robots[0]->get_tangent().getGlobalPosition().x;
+	float w = robots[1]->get_tangent().x - robots[0]->get_tangent().x;
 	bounds.setWidth(w);
-	pos = robots[0]->get_tangent().getGlobalPosition();
+	glm::vec3 pos = robots[0]->get_tangent();
 	pos.y -= robots[0]->bounds_min.get();
 	bounds.setPosition(pos);
 
@@ -51,8 +47,9 @@ CableRobot2D::CableRobot2D(CableRobot* top_left, CableRobot* top_right, ofNode*
 	accel_limit.set(120);
 	bounds_max.set(4000);
 
-	this->ee->setGlobalPosition(bounds.getCenter().x, bounds.getCenter().y, top_left->get_base().getGlobalPosition().z);
-	gizmo_ee.setNode(*ee);
+	kinematics->set_global_position(ee, glm::vec3(bounds.getCenter().x, bounds.getCenter().y, top_left->get_base().z));
+	kinematics->update();
+	gizmo_ee.setNode(kinematics->get_node(ee));
 
 	get_status();
 
@@ -66,13 +63,39 @@ CableRobot2D::CableRobot2D(CableRobot* top_left, CableRobot* top_right, ofNode*
 	plot.colors[2] = ofColor(ofColor::blue);
 	plot.colors[3] = ofColor::cyan;
 
-	startThread();
+	// offline, the RobotController steps every tick itself
+	if (run_threaded)
+		startThread();
+}
+
+CableRobot2D::~CableRobot2D()
+{
+	// stop the control tick before the rig frees this robot
+	waitForThread(true);
+}
+
+/**
+ * @brief Plots the latest tick published by the control thread, and shows reloaded bounds.
+ * Call from the GUI thread only.
+ */
+void CableRobot2D::update_gui()
+{
+	if (bounds_published.exchange(false))
+		move_to.setMax(glm::vec2(bounds.getWidth(), -1 * bounds.getHeight()));
+
+	uint64_t published = plot_published.load(std::memory_order_acquire);
+	if (published != plot_shown) {
+		plot_shown = published;
+		for (int i = 0; i < 4; i++)
+			plot_data[i] = plot_latest[i].load(std::memory_order_relaxed);
+		plot.update(plot_data);
+	}
 }
 
 void CableRobot2D::update()
 {
 	update_gizmo();
-	
+
 
 	////for (int i = 0; i < robots.size(); i++) {
 	////	// monitor the torque and stop all motors if unexpected value
@@ -127,43 +150,67 @@ void CableRobot2D::update()
 }
 
 void CableRobot2D::threadedFunction() {
+	LatencyTrace::set_thread_name("robot_2D_" + ofToString(id));
 	while (isThreadRunning()) {
-		if (move_to_vel) {
-			//update_trajectories_2D();
-
-			// Update each robot's velocity scalar so they arrive at the
-			// target at the same time
-			float scale_factor = 1.0;
-			float dist_0 = robots[0]->actual_to_desired_distance;
-			float dist_1 = robots[1]->actual_to_desired_distance;
-			if (abs(dist_0) > abs(dist_1)) {
-				if (dist_0 != 0) scale_factor = abs(dist_1 / dist_0);
-				robots[1]->velocity_scalar = scale_factor;
-			}
-			else {
-				if (dist_1 != 0) scale_factor = abs(dist_0 / dist_1);
-				robots[0]->velocity_scalar = scale_factor;
-			}
-
-			// get the smoothed RPMs
-			float rpm_0 = robots[0]->compute_velocity();
-			float rpm_1 = robots[1]->compute_velocity();
-
-			// record the raw and filtered rpm for visualization
-			if (debugging) {
-				plot_data[0] = robots[0]->plot_data_vel[0];
-				plot_data[1] = robots[0]->plot_data_vel[1];
-				plot_data[2] = robots[1]->plot_data_vel[0];
-				plot_data[3] = robots[1]->plot_data_vel[1];
-				plot.update(plot_data);
-			}
-
-			//robots[0]->move_velocity_rpm(rpm_0);
-			//robots[1]->move_velocity_rpm(rpm_1);
-
-			robots[0]->get_motor_controller()->get_motor()->move_velocity(rpm_0);
-			robots[1]->get_motor_controller()->get_motor()->move_velocity(rpm_1);
+		tick();
+	}
+}
+
+/**
+ * @brief Runs one control tick: computes each motor's velocity and sends it.
+ * Called continuously by the robot's thread, or once per step when running offline.
+ */
+void CableRobot2D::tick()
+{
+	if (move_to_vel) {
+		// pick up the latest traced target once the kinematics have published it
+		LatencyTrace::resume(LatencyTrace::KINEMATICS_UPDATE);
+		LatencyTrace::mark(LatencyTrace::TICK_START);
+
+		//update_trajectories_2D();
+
+		// Update each robot's velocity scalar so they arrive at the
+		// target at the same time
+		float scale_factor = 1.0;
+		float dist_0 = robots[0]->actual_to_desired_distance;
+		float dist_1 = robots[1]->actual_to_desired_distance;
+		if (abs(dist_0) > abs(dist_1)) {
+			if (dist_0 != 0) scale_factor = abs(dist_1 / dist_0);
+			robots[1]->velocity_scalar = scale_factor;
+		}
+		else {
+			if (dist_1 != 0) scale_factor = abs(dist_0 / dist_1);
+			robots[0]->velocity_scalar = scale_factor;
+		}
+
+		// read both cable positions and convert them together, with the cables' stretch under load
+		int64_t counts[2] = { robots[0]->get_position_counts(), robots[1]->get_position_counts() };
+		robots[0]->cache_scale(scales[0], scale_sources[0]);
+		robots[1]->cache_scale(scales[1], scale_sources[1]);
+		float torques[2] = { robots[0]->get_torque_measured(), robots[1]->get_torque_measured() };
+		float actual[2];
+		CountScale::to_mm(counts, scales, actual, 2, true, torques);
+
+		// get the smoothed RPMs
+		float rpm_0 = robots[0]->compute_velocity(actual[0]);
+		float rpm_1 = robots[1]->compute_velocity(actual[1]);
+
+		// record the raw and filtered rpm for visualization (plotted by update)
+		if (debugging) {
+			plot_latest[0].store(robots[0]->plot_data_vel[0], std::memory_order_relaxed);
+			plot_latest[1].store(robots[0]->plot_data_vel[1], std::memory_order_relaxed);
+			plot_latest[2].store(robots[1]->plot_data_vel[0], std::memory_order_relaxed);
+			plot_latest[3].store(robots[1]->plot_data_vel[1], std::memory_order_relaxed);
+			plot_published.fetch_add(1, std::memory_order_release);
 		}
+
+		//robots[0]->move_velocity_rpm(rpm_0);
+		//robots[1]->move_velocity_rpm(rpm_1);
+
+		robots[0]->get_motor_controller()->get_motor()->move_velocity(rpm_0);
+		robots[1]->get_motor_controller()->get_motor()->move_velocity(rpm_1);
+
+		LatencyTrace::end(LatencyTrace::TICK_END);
 	}
 }
 
@@ -201,21 +248,17 @@ void CableRobot2D::draw_ee_path()
 	//ofPopStyle();
 }
 
-void CableRobot2D::draw()
+void CableRobot2D::draw(BatchRenderer& batch)
 {
 	// draw the bounds
-	ofPushStyle();
 	ofColor color;
 	if (bounds.inside(gizmo_ee.getTranslation()))
 		color = ofColor::yellow;
 	else
 		color = ofColor::red;
-	ofSetColor(color, 10);
-	ofDrawRectangle(bounds.getPosition(), bounds.width, bounds.height);
+	batch.add_rectangle(bounds.getPosition(), bounds.width, bounds.height, ofColor(color, 10));
 	
-	draw_cables_2D();
-
-	ofPopStyle();
+	draw_cables_2D(batch);
 
 
 	//for (int i = 0; i < robots.size(); i++) {
@@ -240,7 +283,7 @@ void CableRobot2D::get_status() {
 
 	string state = "";
 	for (int i = 1; i < robots.size(); i++) {
-		state += robots[i]->status.get() + ", ";
+		state += robots[i]->get_state_name() + ", ";
 	}
 
 	// check if any of the motors are in E_STOP
@@ -289,45 +332,90 @@ void CableRobot2D::get_status() {
 	}
 }
 
+/**
+ * @brief Posts a new XY target for the end effector; safe to call from any thread.
+ * It's applied to the gizmo (and the kinematics) on the next update_gizmo.
+ *
+ * @param (float)  x: target x (world, mm)
+ * @param (float)  y: target y (world, mm)
+ */
+void CableRobot2D::set_target(float x, float y)
+{
+	std::lock_guard<std::mutex> lock(mutex_target);
+	target_posted = glm::vec2(x, y);
+	has_target_posted = true;
+}
+
 void CableRobot2D::update_gizmo()
 {
+	// move the gizmo to the latest posted target
+	bool posted = false;
+	glm::vec2 target;
+	{
+		std::lock_guard<std::mutex> lock(mutex_target);
+		posted = has_target_posted;
+		target = target_posted;
+		has_target_posted = false;
+	}
+	if (posted && !override_gizmo) {
+		ofNode node;
+		node.setGlobalPosition(target.x, target.y, base_top_left.z);
+		node.setGlobalOrientation(gizmo_ee.getRotation());
+		gizmo_ee.setNode(node);
+	}
+
 	if (override_gizmo) {
-		gizmo_ee.setNode(*ee);
+		gizmo_ee.setNode(kinematics->get_node(ee));
 	}
-	else if (gizmo_ee.getTranslation() != ee->getGlobalPosition() ||
-		gizmo_ee.getRotation() != ee->getGlobalOrientation()) {
+	else if (gizmo_ee.getTranslation() != kinematics->get_global_position(ee) ||
+		gizmo_ee.getRotation() != kinematics->get_global_orientation(ee)) {
 		// override the Z position ... it's jumping around for some reason
 		auto p = gizmo_ee.getTranslation();
 		p.z = base_top_left.z;
-		ee->setGlobalPosition(p);
-		ee->setGlobalOrientation(gizmo_ee.getRotation());
-		gizmo_ee.setNode(*ee);
+		kinematics->set_global_transform(ee, p, gizmo_ee.getRotation());
+		ofNode node;
+		node.setGlobalPosition(p);
+		node.setGlobalOrientation(gizmo_ee.getRotation());
+		gizmo_ee.setNode(node);
 		// update the gui
 		if (gizmo_ee.isInteracting()) {
-			auto pos = ee->getPosition();
+			auto pos = kinematics->get_position(ee);
 			move_to.set(glm::vec2(pos.x, -1 * pos.y));
 		}
 	}
 	// update bounds if we've moved the origin gizmo
-	if (bounds.getPosition() != robots[0]->get_tangent().getGlobalPosition())
-		bounds.setPosition(robots[0]->get_tangent().getGlobalPosition());
+	if (bounds.getPosition() != robots[0]->get_tangent())
+		bounds.setPosition(robots[0]->get_tangent());
 }
 
 void CableRobot2D::add_to_path(glm::vec3 pos) {
-	if (path.getVertices().size() == 0) {
-		path.addVertex(pos);
+	if (path.empty()) {
+		path.push(pos);
 	}
 	else {
-		auto p = path.getVertices().back();
+		auto p = path.back();
 		float threshold = 50;
 		float dist_sq = glm::distance2(pos, p);
 		if (dist_sq > threshold * threshold &&
 			dist_sq < (threshold * 10) * (threshold * 10)) {
-			path.addVertex(pos);
+			path.push(pos);
 		}
 	}
 }
 
+/**
+ * @brief Returns where each cable leaves its drum.
+ *
+ * @return (vector<glm::vec3>)  tangent points (in world coordinates)
+ */
+vector<glm::vec3> CableRobot2D::get_anchors()
+{
+	vector<glm::vec3> anchors;
+	for (int i = 0; i < robots.size(); i++)
+		anchors.push_back(robots[i]->get_tangent());
+	return anchors;
+}
+
 void CableRobot2D::key_pressed(int key)
 {
 	for (int i = 0; i < robots.size(); i++) {
@@ -378,7 +466,7 @@ void CableRobot2D::update_trajectories_2D()
 	robots[1]->move_velocity_rpm(rpm_1);
 }
 
-void CableRobot2D::draw_cables_actual(glm::vec3 start_0, glm::vec3 end_0, float dist_0, glm::vec3 start_1, glm::vec3 end_1, float dist_1)
+void CableRobot2D::draw_cables_actual(BatchRenderer& batch, glm::vec3 start_0, glm::vec3 end_0, float dist_0, glm::vec3 start_1, glm::vec3 end_1, float dist_1)
 {
 	auto heading_0 = glm::normalize(end_0 - start_0) * dist_0;
 	auto heading_1 = glm::normalize(end_1 - start_1) * dist_1;
@@ -387,29 +475,18 @@ void CableRobot2D::draw_cables_actual(glm::vec3 start_0, glm::vec3 end_0, float
 
 	estimated_target_actual = (end_0 + end_1) / 2;
 
-	ofSetLineWidth(2);
-	ofSetColor(255);
-	ofDrawLine(start_0, end_0);
-	ofFill();
-	ofSetColor(ofColor::orange, 200);
-	ofDrawEllipse(end_0, 40, 40);
+	batch.add_line(start_0, end_0, ofColor(255), 2);
+	batch.add_ellipse(end_0, 40, 40, ofColor(ofColor::orange, 200));
 
-	ofSetColor(255);
-	ofDrawLine(start_1, end_1);
-	ofFill();
-	ofSetColor(ofColor::orange, 200);
-	ofDrawEllipse(end_1, 40, 40);
+	batch.add_line(start_1, end_1, ofColor(255), 2);
+	batch.add_ellipse(end_1, 40, 40, ofColor(ofColor::orange, 200));
 
-	ofDrawLine(end_0, end_1);
-	ofSetColor(ofColor::red, 200);
-	ofDrawEllipse(estimated_target_actual, 40, 40);
+	batch.add_line(end_0, end_1, ofColor(ofColor::orange, 200), 2);
+	batch.add_ellipse(estimated_target_actual, 40, 40, ofColor(ofColor::red, 200));
 }
 
 
-void CableRobot2D::draw_cables_2D() {
-	//ofPushStyle();
-	ofSetColor(120);
-	ofSetLineWidth(1);
+void CableRobot2D::draw_cables_2D(BatchRenderer& batch) {
 
 	if (robots.size() > 0) {
 
@@ -427,27 +504,22 @@ void CableRobot2D::draw_cables_2D() {
 		//float actual_0 = robots[0]->get_position_actual();	// <-- !!!caused HUGE delays!!!
 		//float actual_1 = robots[1]->get_position_actual();
 
-		glm::vec3 start_0 = robots[0]->get_tangent_ptr()->getGlobalPosition();
-		glm::vec3 start_1 = robots[1]->get_tangent_ptr()->getGlobalPosition();
-		glm::vec3 end_0 = robots[0]->get_target()->getGlobalPosition();
-		glm::vec3 end_1 = robots[1]->get_target()->getGlobalPosition();
+		glm::vec3 start_0 = robots[0]->get_tangent();
+		glm::vec3 start_1 = robots[1]->get_tangent();
+		glm::vec3 end_0 = robots[0]->get_target();
+		glm::vec3 end_1 = robots[1]->get_target();
 
-		ofDrawLine(start_0, end_0);
-		ofDrawLine(end_0, end_1);
-		ofDrawLine(start_1, end_1);
+		batch.add_line(start_0, end_0, ofColor(120));
+		batch.add_line(end_0, end_1, ofColor(120));
+		batch.add_line(start_1, end_1, ofColor(120));
 
-		ofSetColor(255, 60);
-		ofDrawEllipse(end_0, zone.get() * 2, zone.get() * 2);
-		ofDrawEllipse(end_1, zone.get() * 2, zone.get() * 2);
+		batch.add_ellipse(end_0, zone.get() * 2, zone.get() * 2, ofColor(255, 60));
+		batch.add_ellipse(end_1, zone.get() * 2, zone.get() * 2, ofColor(255, 60));
 
-		draw_cables_actual(start_0, end_0, actual_0, start_1, end_1, actual_1);
+		draw_cables_actual(batch, start_0, end_0, actual_0, start_1, end_1, actual_1);
 	}
 
-	ofSetColor(255, 0, 255);
-	ofNoFill();
-	path.draw();
-
-	//ofPopStyle();
+	path.draw(batch, ofColor(255, 0, 255));
 }
 
 void CableRobot2D::setup_gui()
@@ -603,7 +675,7 @@ void CableRobot2D::on_bounds_changed(float& val)
 	// update the height of the bounds rectangle
 	float h = robots[0]->bounds_max - robots[0]->bounds_min;
 	bounds.setHeight(-1 * h);
-	auto pos = robots[0]->get_tangent().getGlobalPosition();
+	auto pos = robots[0]->get_tangent();
 	pos.y -= robots[0]->bounds_min.get();
 	bounds.setPosition(pos);
 	// relay change to robots
@@ -615,6 +687,26 @@ void CableRobot2D::on_bounds_changed(float& val)
 	move_to.setMax(glm::vec2(bounds.getWidth(), -1 * bounds.getHeight()));
 }
 
+/**
+ * @brief Refreshes the 2D workspace after the robots' config was hot-reloaded.
+ * Expects the kinematic graph to already be updated with the new offsets.
+ */
+void CableRobot2D::on_config_reloaded()
+{
+	bounds_min.setWithoutEventNotifications(robots[0]->bounds_min.get());
+	bounds_max.setWithoutEventNotifications(robots[0]->bounds_max.get());
+
+	float h = robots[0]->bounds_max - robots[0]->bounds_min;
+	bounds.setHeight(-1 * h);
+	bounds.setWidth(robots[1]->get_tangent().x - robots[0]->get_tangent().x);
+	auto pos = robots[0]->get_tangent();
+	pos.y -= robots[0]->bounds_min.get();
+	bounds.setPosition(pos);
+
+	// the GUI thread updates the move_to range (see update_gui)
+	bounds_published = true;
+}
+
 void CableRobot2D::on_vel_limit_changed(float& val)
 {
 	for (int i = 0; i < robots.size(); i++) {
@@ -625,8 +717,8 @@ void CableRobot2D::on_vel_limit_changed(float& val)
 void CableRobot2D::on_ee_offset_changed(float& val)
 {
 	float offset =  val;
-	robots[0]->get_target()->setPosition(-offset, 0, 0);
-	robots[1]->get_target()->setPosition(offset, 0, 0);
+	robots[0]->set_target_position(glm::vec3(-offset, 0, 0));
+	robots[1]->set_target_position(glm::vec3(offset, 0, 0));
 }
 
 void CableRobot2D::on_x_offset_max_changed(float& val)
@@ -674,7 +766,7 @@ void CableRobot2D::on_move_to_vel(bool& val)
 
 void CableRobot2D::on_base_offset_changed(float& val)
 {
-	auto pos = robots[1]->get_base().getPosition();
+	auto pos = robots[1]->get_base_position();
 	pos.x = val;
 	robots[1]->set_base_position(pos);
 
@@ -699,8 +791,12 @@ void CableRobot2D::on_torque_limits_changed(float& val)
 
 void CableRobot2D::on_move_to_changed(glm::vec2& val)
 {
-	ee->setPosition(glm::vec3(val.x, -1 * val.y, base_top_left.z));
-	gizmo_ee.setNode(*ee);
+	glm::vec3 pos = glm::vec3(val.x, -1 * val.y, base_top_left.z);
+	kinematics->set_position(ee, pos);
+	ofNode node;
+	node.setGlobalPosition(pos);
+	node.setGlobalOrientation(kinematics->get_global_orientation(ee));
+	gizmo_ee.setNode(node);
 }
 
 bool CableRobot2D::is_estopped()
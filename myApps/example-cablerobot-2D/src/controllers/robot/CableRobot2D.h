@@ -7,6 +7,8 @@
 #include "CableRobot.h"
 
 #include "../TimeSeriesPlot.h"
+#include "../LatencyTrace.h"
+#include "../motion/PathQueue.h"
 
 
 class CableRobot2D :
@@ -19,15 +21,24 @@ private:
 
 	void update_trajectories_2D();
 
-	void draw_cables_actual(glm::vec3 start_0, glm::vec3 end_0, float dist_0, glm::vec3 start_1, glm::vec3 end_1, float dist_1);
-	void draw_cables_2D();
+	void draw_cables_actual(BatchRenderer& batch, glm::vec3 start_0, glm::vec3 end_0, float dist_0, glm::vec3 start_1, glm::vec3 end_1, float dist_1);
+	void draw_cables_2D(BatchRenderer& batch);
 
 	vector<vector<glm::vec3>> ee_path;
 	void draw_ee_path();
 
-	ofNode* origin;     // World reference frame 
-	ofNode* ee;			// World reference 
+	KinematicGraph* kinematics;
+	int origin;			// World reference frame
+	int ee;				// World reference
 	ofxGizmo gizmo_ee;
+
+	// the cables' scales, copied by the tick only when a reload replaces them
+	CountScale scales[2];
+	const CountScale* scale_sources[2] = { nullptr, nullptr };
+
+	std::mutex mutex_target;
+	glm::vec2 target_posted;			// set from any thread, applied to the gizmo by update_gizmo
+	bool has_target_posted = false;
 	
 	glm::vec3 base_top_left;
 	glm::vec3 base_top_right;
@@ -39,15 +50,19 @@ private:
 public:
 
 	CableRobot2D() {};
-	CableRobot2D(CableRobot* top_left, CableRobot* top_right, ofNode* _origin, glm::vec3 base_top_left, glm::vec3 base_top_right, int id);
+	CableRobot2D(CableRobot* top_left, CableRobot* top_right, KinematicGraph* _kinematics, int _origin, glm::vec3 base_top_left, glm::vec3 base_top_right, int id, bool run_threaded = true);
+	~CableRobot2D();
 
 	void update();
-	void draw();
+	void draw(BatchRenderer& batch);
 	void update_gui(ofxPanel* _panel);
 	void draw_gui();
 	void shutdown();
 
 	void threadedFunction();
+	void tick();
+
+	CableRobot* get_robot(int i) { return robots[i]; }
 
 	void get_status();
 	bool debugging = true;
@@ -55,6 +70,7 @@ public:
 	ofxGizmo* get_gizmo() { return &gizmo_ee; }
 	bool override_gizmo = false;
 	void update_gizmo();
+	void set_target(float x, float y);
 
 	void key_pressed(int key);
 
@@ -75,14 +91,24 @@ public:
 	//PD_Controller pd_controller_1;
 	TimeSeriesPlot plot = TimeSeriesPlot(4);
 	vector<float> plot_data = { 0, 0, 0, 0 };
+	std::atomic<float> plot_latest[4]{};				// published by the control tick for the GUI thread's plot
+	std::atomic<uint64_t> plot_published{ 0 };
+	uint64_t plot_shown = 0;
+	std::atomic<bool> bounds_published{ false };		// set by on_config_reloaded for the GUI thread
+	void update_gui();
 
-	ofPolyline path;
+	PathQueue path = PathQueue(500);
 	void add_to_path(glm::vec3 pos);
 	void draw_path();
 
 	glm::vec3 estimated_target_actual;
 	glm::vec3 get_target_actual();
 
+	vector<glm::vec3> get_anchors();
+	glm::vec3 get_ee() { return kinematics->get_global_position(ee); }
+	ofRectangle get_bounds() { return bounds; }
+	float get_mm_per_rev() { return robots[0]->get_mm_per_rev(); }
+
 
 	// GUI Listeners
 	void on_enable(bool& val);
@@ -94,6 +120,7 @@ public:
 	void on_vel_limit_changed(float& val);
 	void on_accel_limit_changed(float& val);
 
+	void on_config_reloaded();
 	void on_ee_offset_changed(float& val);
 	void on_base_offset_changed(float& val);
 
@@ -0,0 +1,308 @@
+#include "CableRobot3D.h"
+
+CableRobot3D::CableRobot3D(const vector<CableRobot*>& cables, KinematicGraph* kinematics, int origin, const vector<glm::vec3>& bases, int id, bool run_threaded)
+{
+	this->cables = cables;
+	this->kinematics = kinematics;
+	this->origin = origin;
+	this->id = id;
+
+	setup_gui();
+
+	// Setup the end effector (a world frame, so it is added before the cables' targets)
+	ee = kinematics->add();
+
+	// Configure the cables with one end effector; they meet at its center
+	solver.set_num_cables(cables.size());
+	for (int i = 0; i < cables.size(); i++) {
+		cables[i]->configure(kinematics, origin, bases[i], ee);
+		cables[i]->set_target_position(glm::vec3(0));
+		solver.set_attachment(i, glm::vec3(0));
+	}
+	kinematics->update();
+
+	// start halfway down the cables' range, under the middle of the anchors
+	glm::vec3 center;
+	for (auto cable : cables)
+		center += cable->get_tangent();
+	center /= cables.size();
+	float h = (cables[0]->bounds_min.get() + cables[0]->bounds_max.get()) / 2;
+	kinematics->set_global_position(ee, center + get_down() * h);
+	kinematics->update();
+	position_estimate = glm::dvec3(kinematics->get_global_position(ee));
+	published_estimate = glm::vec3(position_estimate);
+
+	gizmo_ee.setDisplayScale(.5);
+	gizmo_ee.setNode(kinematics->get_node(ee));
+
+	// offline, the RobotController steps every tick itself
+	if (run_threaded)
+		startThread();
+}
+
+CableRobot3D::~CableRobot3D()
+{
+	// stop the control tick before the rig frees this robot
+	waitForThread(true);
+}
+
+void CableRobot3D::setup_gui()
+{
+	panel.setup("3D_Robot_" + ofToString(id));
+	panel.setWidthElements(250);
+	panel.add(status.set("Status", "DISABLED"));
+	panel.add(enable.set("Enable", false));
+	panel.add(e_stop.set("E_Stop", false));
+	panel.add(move_to_vel.set("Move_to_Vel", false));
+	panel.add(mass.set("Mass_(kg)", 2, 0, 50));
+	panel.add(tension_min.set("Tension_Min_(N)", 10, 0, 500));
+	panel.add(tension_max.set("Tension_Max_(N)", 500, 0, 2000));
+	panel.add(info_tensions.set("Tensions_(N)", ""));
+	panel.add(info_fk_error.set("FK_Error_(mm)", ""));
+	panel.add(info_solve_time.set("Solve_Time_(us)", ""));
+
+	enable.addListener(this, &CableRobot3D::on_enable);
+	e_stop.addListener(this, &CableRobot3D::on_e_stop);
+	move_to_vel.addListener(this, &CableRobot3D::on_move_to_vel);
+}
+
+/**
+ * @brief Returns the world direction of gravity: the robots' frames hang their cables along -Y.
+ */
+glm::vec3 CableRobot3D::get_down()
+{
+	return kinematics->get_global_orientation(origin) * glm::vec3(0, -1, 0);
+}
+
+void CableRobot3D::update()
+{
+	update_gizmo();
+}
+
+/**
+ * @brief Shows the latest tick published by the control thread. Call from the GUI thread only.
+ */
+void CableRobot3D::update_gui()
+{
+	float t_min = 0, t_max = 0, residual, solve_time;
+	bool feasible;
+	{
+		std::lock_guard<std::mutex> lock(mutex_published);
+		feasible = published_feasible;
+		residual = published_residual;
+		solve_time = published_solve_time;
+		for (int i = 0; i < cables.size(); i++) {
+			t_min = i == 0 ? published_tensions[i] : MIN(t_min, published_tensions[i]);
+			t_max = i == 0 ? published_tensions[i] : MAX(t_max, published_tensions[i]);
+		}
+	}
+	info_tensions.set(ofToString(t_min, 0) + " / " + ofToString(t_max, 0) + (feasible ? "" : " INFEASIBLE"));
+	info_fk_error.set(ofToString(residual, 2));
+	info_solve_time.set(ofToString(solve_time, 1));
+}
+
+void CableRobot3D::threadedFunction()
+{
+	LatencyTrace::set_thread_name("robot_3D_" + ofToString(id));
+	while (isThreadRunning()) {
+		tick();
+	}
+}
+
+/**
+ * @brief Runs one control tick: estimates the end effector, checks the target's tensions,
+ * and sends every cable's velocity. Called continuously by the robot's thread, or once
+ * per step when running offline.
+ */
+void CableRobot3D::tick()
+{
+	if (!move_to_vel)
+		return;
+
+	LatencyTrace::resume(LatencyTrace::KINEMATICS_UPDATE);
+	LatencyTrace::mark(LatencyTrace::TICK_START);
+	uint64_t time_start = ofGetElapsedTimeMicros();
+	int n = cables.size();
+
+	// read every cable's length and convert them together, with the cables' stretch under load
+	for (int i = 0; i < n; i++) {
+		counts[i] = cables[i]->get_position_counts();
+		cables[i]->cache_scale(scales[i], scale_sources[i]);
+		torques[i] = cables[i]->get_torque_measured();
+		solver.set_anchor(i, cables[i]->get_tangent());
+	}
+	CountScale::to_mm(counts.data(), scales.data(), lengths_actual.data(), n, true, torques.data());
+	for (int i = 0; i < n; i++)
+		lengths[i] = lengths_actual[i];
+
+	// where the end effector is, starting from where it was last tick
+	solver.forward(lengths.data(), position_estimate);
+
+	// the tensions that would hold it at the target
+	glm::dvec3 target(get_target());
+	solver.force = glm::dvec3(get_down() * mass.get() * 9.81f);
+	solver.tension_min = tension_min.get();
+	solver.tension_max = tension_max.get();
+	bool feasible = solver.distribute(target, tensions.data());
+	solver.inverse(target, lengths_target.data());
+
+	// scale each cable's velocity so they all arrive at the same time
+	double dist_max = 0;
+	for (int i = 0; i < n; i++)
+		dist_max = MAX(dist_max, abs(lengths_target[i] - lengths[i]));
+	for (int i = 0; i < n; i++) {
+		cables[i]->velocity_scalar = dist_max > 0 ? abs(lengths_target[i] - lengths[i]) / dist_max : 1;
+		float rpm = cables[i]->compute_velocity(lengths_actual[i]);
+		// hold where we are rather than slacken a cable
+		cables[i]->get_motor_controller()->get_motor()->move_velocity(feasible ? rpm : 0);
+	}
+	if (!feasible && !holding)
+		ofLogWarning("CableRobot3D::tick") << "Robot " << id << " target is outside the wrench-feasible workspace. Holding.";
+	holding = !feasible;
+
+	float solve_time = ofGetElapsedTimeMicros() - time_start;
+	{
+		std::lock_guard<std::mutex> lock(mutex_published);
+		published_estimate = glm::vec3(position_estimate);
+		for (int i = 0; i < n; i++)
+			published_tensions[i] = tensions[i];
+		published_feasible = feasible;
+		published_residual = solver.get_residual();
+		published_solve_time = solve_time;
+	}
+
+	LatencyTrace::end(LatencyTrace::TICK_END);
+}
+
+void CableRobot3D::draw(BatchRenderer& batch)
+{
+	glm::vec3 target = get_target();
+	std::array<float, CableSolver3D::MAX_CABLES> t;
+	bool feasible;
+	glm::vec3 estimate;
+	{
+		std::lock_guard<std::mutex> lock(mutex_published);
+		t = published_tensions;
+		feasible = published_feasible;
+		estimate = published_estimate;
+	}
+
+	// cables shade from grey (slack) to white (at the max tension)
+	for (int i = 0; i < cables.size(); i++) {
+		float shade = ofMap(t[i], 0, tension_max.get(), 80, 255, true);
+		ofColor color = feasible ? ofColor(shade) : ofColor(ofColor::red, 200);
+		batch.add_line(cables[i]->get_tangent(), target, color, 2);
+		batch.add_line(cables[i]->get_tangent(), estimate, ofColor(ofColor::orange, 120));
+	}
+	batch.add_ellipse(target, 40, 40, ofColor(255, 60));
+	batch.add_ellipse(estimate, 40, 40, ofColor(ofColor::orange, 200));
+}
+
+/**
+ * @brief Returns where forward kinematics last estimated the end effector; safe to call from any thread.
+ */
+glm::vec3 CableRobot3D::get_target_actual()
+{
+	std::lock_guard<std::mutex> lock(mutex_published);
+	return published_estimate;
+}
+
+void CableRobot3D::update_gui(ofxPanel* _panel)
+{
+	int padding = 5;
+	panel.setPosition(_panel->getPosition().x + _panel->getWidth() + padding, _panel->getPosition().y);
+}
+
+void CableRobot3D::draw_gui()
+{
+	panel.draw();
+}
+
+/**
+ * @brief Posts a new target for the end effector; safe to call from any thread.
+ * It's applied to the gizmo (and the kinematics) on the next update_gizmo.
+ *
+ * @param (glm::vec3)  target: target position (world, mm)
+ */
+void CableRobot3D::set_target(glm::vec3 target)
+{
+	std::lock_guard<std::mutex> lock(mutex_target);
+	target_posted = target;
+	has_target_posted = true;
+}
+
+void CableRobot3D::update_gizmo()
+{
+	// move the gizmo to the latest posted target
+	bool posted = false;
+	glm::vec3 target;
+	{
+		std::lock_guard<std::mutex> lock(mutex_target);
+		posted = has_target_posted;
+		target = target_posted;
+		has_target_posted = false;
+	}
+	if (posted && !override_gizmo) {
+		ofNode node;
+		node.setGlobalPosition(target);
+		node.setGlobalOrientation(gizmo_ee.getRotation());
+		gizmo_ee.setNode(node);
+	}
+
+	if (override_gizmo) {
+		gizmo_ee.setNode(kinematics->get_node(ee));
+	}
+	else if (gizmo_ee.getTranslation() != kinematics->get_global_position(ee)) {
+		kinematics->set_global_position(ee, gizmo_ee.getTranslation());
+	}
+}
+
+void CableRobot3D::key_pressed(int key)
+{
+	for (auto cable : cables)
+		cable->key_pressed(key);
+	switch (key)
+	{
+	case ' ':
+		move_to_vel.set(false);
+		break;
+	default:
+		break;
+	}
+}
+
+void CableRobot3D::stop()
+{
+	for (auto cable : cables)
+		cable->stop();
+}
+
+void CableRobot3D::set_e_stop(bool val)
+{
+	if (val) {
+		status.set("E_STOP");
+		move_to_vel.set(false);
+	}
+	for (auto cable : cables)
+		cable->e_stop.set(val);
+}
+
+void CableRobot3D::on_enable(bool& val)
+{
+	status.set(val ? "ENABLED" : "DISABLED");
+	for (auto cable : cables)
+		cable->on_enable(val);
+}
+
+void CableRobot3D::on_e_stop(bool& val)
+{
+	stop();
+	for (auto cable : cables)
+		cable->on_e_stop(val);
+}
+
+void CableRobot3D::on_move_to_vel(bool& val)
+{
+	for (auto cable : cables)
+		cable->on_move_to_vel(val);
+}
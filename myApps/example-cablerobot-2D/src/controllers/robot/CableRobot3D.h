@@ -0,0 +1,106 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGui.h"
+#include "ofxGizmo.h"
+#include "CableRobot.h"
+#include "CableSolver3D.h"
+
+#include "../LatencyTrace.h"
+#include "../BatchRenderer.h"
+
+/**
+ * @brief Spatial cable-driven parallel robot: one end effector hung from 4 to 8 cables.
+ *
+ * Each control tick reads every cable's length, estimates where the end
+ * effector actually is (forward kinematics), checks that the cables can hold
+ * it at the target with positive tension, and drives every cable toward its
+ * target length so they all arrive together. Targets the cables can't hold
+ * (outside the wrench-feasible workspace) stop the robot instead of letting
+ * a cable go slack.
+ *
+ * Like CableRobot2D, it ticks on its own thread, or from Rig::tick when offline.
+ */
+class CableRobot3D :
+	public ofThread
+{
+public:
+	CableRobot3D(const vector<CableRobot*>& cables, KinematicGraph* kinematics, int origin, const vector<glm::vec3>& bases, int id, bool run_threaded = true);
+	~CableRobot3D();
+
+	void update();
+	void draw(BatchRenderer& batch);
+	void update_gui(ofxPanel* _panel);
+	void update_gui();
+	void draw_gui();
+
+	void threadedFunction();
+	void tick();
+
+	CableRobot* get_robot(int i) { return cables[i]; }
+	int get_num_cables() { return cables.size(); }
+	CableSolver3D* get_solver() { return &solver; }
+
+	ofxGizmo* get_gizmo() { return &gizmo_ee; }
+	bool override_gizmo = false;
+	void update_gizmo();
+	void set_target(glm::vec3 target);
+
+	void key_pressed(int key);
+	void stop();
+	void set_e_stop(bool val);
+
+	glm::vec3 get_target_actual();
+	glm::vec3 get_target() { return kinematics->get_global_position(ee); }
+
+	ofxPanel panel;
+	ofParameter<string> status;
+	ofParameter<bool> enable;
+	ofParameter<bool> e_stop;
+	ofParameter<bool> move_to_vel;
+	ofParameter<float> mass;				// kg, of the end effector
+	ofParameter<float> tension_min;			// N
+	ofParameter<float> tension_max;			// N
+	ofParameter<string> info_tensions;		// N, min / max
+	ofParameter<string> info_fk_error;		// mm, rms
+	ofParameter<string> info_solve_time;	// us per tick
+
+private:
+	int id;
+	vector<CableRobot*> cables;
+	KinematicGraph* kinematics;
+	int origin;
+	int ee;
+	ofxGizmo gizmo_ee;
+
+	std::mutex mutex_target;
+	glm::vec3 target_posted;			// set from any thread, applied to the gizmo by update_gizmo
+	bool has_target_posted = false;
+
+	// control tick state, fixed size
+	CableSolver3D solver;
+	glm::dvec3 position_estimate;
+	std::array<int64_t, CableSolver3D::MAX_CABLES> counts;
+	std::array<CountScale, CableSolver3D::MAX_CABLES> scales;		// copied only when a reload replaces them
+	std::array<const CountScale*, CableSolver3D::MAX_CABLES> scale_sources{};
+	std::array<float, CableSolver3D::MAX_CABLES> torques;			// % of max
+	std::array<float, CableSolver3D::MAX_CABLES> lengths_actual;	// mm
+	std::array<double, CableSolver3D::MAX_CABLES> lengths;			// mm
+	std::array<double, CableSolver3D::MAX_CABLES> lengths_target;	// mm
+	std::array<double, CableSolver3D::MAX_CABLES> tensions;			// N
+	bool holding = false;		// stopped at an infeasible target
+
+	// published by the tick for the GUI thread
+	std::mutex mutex_published;
+	glm::vec3 published_estimate;			// from forward kinematics
+	std::array<float, CableSolver3D::MAX_CABLES> published_tensions{};
+	bool published_feasible = true;
+	float published_residual = 0;
+	float published_solve_time = 0;
+
+	glm::vec3 get_down();
+	void setup_gui();
+	void on_enable(bool& val);
+	void on_e_stop(bool& val);
+	void on_move_to_vel(bool& val);
+};
@@ -0,0 +1,146 @@
+#include "CableSolver3D.h"
+
+/**
+ * @brief Returns the cable lengths that put the end effector at a position.
+ *
+ * @param (glm::dvec3)  position: end effector (world, mm)
+ * @param (double*)  lengths: one per cable out (mm)
+ */
+void CableSolver3D::inverse(const glm::dvec3& position, double* lengths) const
+{
+	for (int i = 0; i < num_cables; i++)
+		lengths[i] = glm::length(position + attachments[i] - anchors[i]);
+}
+
+/**
+ * @brief Finds the end effector position that best fits measured cable lengths.
+ *
+ * @param (double*)  lengths: one per cable (mm)
+ * @param (glm::dvec3)  position: the previous solution in, the new solution out
+ * @return (bool)  true if it converged within max_iterations
+ */
+bool CableSolver3D::forward(const double* lengths, glm::dvec3& position)
+{
+	double error = cost(lengths, position);
+	iterations = 0;
+	bool converged = false;
+
+	while (iterations < max_iterations && !converged) {
+		iterations++;
+
+		// normal equations of the length residuals
+		glm::dmat3 jtj(0);
+		glm::dvec3 jtr(0);
+		for (int i = 0; i < num_cables; i++) {
+			glm::dvec3 d = position + attachments[i] - anchors[i];
+			double length = glm::length(d);
+			if (length < 1e-9)
+				continue;
+			glm::dvec3 j = d / length;
+			jtj += glm::outerProduct(j, j);
+			jtr += j * (length - lengths[i]);
+		}
+
+		// damp toward gradient descent until a step lowers the error
+		while (true) {
+			glm::dmat3 h = jtj;
+			for (int k = 0; k < 3; k++)
+				h[k][k] += damping * MAX(jtj[k][k], 1e-9);
+			if (glm::determinant(h) == 0)
+				return false;
+			glm::dvec3 step = -(glm::inverse(h) * jtr);
+			glm::dvec3 next = position + step;
+			double next_error = cost(lengths, next);
+			if (next_error <= error) {
+				position = next;
+				error = next_error;
+				damping = MAX(damping * 0.1, 1e-9);
+				converged = glm::length(step) < tolerance;
+				break;
+			}
+			damping *= 10;
+			if (damping > 1e9) {
+				// no step lowers the error any more: this is the minimum
+				damping = 1e-3;
+				converged = true;
+				break;
+			}
+		}
+	}
+
+	residual = num_cables > 0 ? sqrt(error / num_cables) : 0;
+	return converged;
+}
+
+/**
+ * @brief Finds the cable tensions that hold the end effector still against the external force.
+ *
+ * @param (glm::dvec3)  position: end effector (world, mm)
+ * @param (double*)  tensions: one per cable out (N), clamped to the tension range
+ * @return (bool)  false if the tension range can't hold the end effector at this position
+ */
+bool CableSolver3D::distribute(const glm::dvec3& position, double* tensions) const
+{
+	std::array<glm::dvec3, MAX_CABLES> u;	// unit vectors from the end effector along each cable
+	std::array<bool, MAX_CABLES> fixed;
+	for (int i = 0; i < num_cables; i++) {
+		glm::dvec3 d = anchors[i] - position - attachments[i];
+		double length = glm::length(d);
+		u[i] = length > 1e-9 ? d / length : glm::dvec3(0);
+		fixed[i] = false;
+	}
+
+	double mid = (tension_min + tension_max) / 2;
+	int num_free = num_cables;
+	while (num_free >= 3) {
+		// solve sum(t_i * u_i) = -force for the free cables, closest to mid-range tension:
+		// t = mid - A^T (A A^T)^-1 (force + fixed + A mid)
+		glm::dmat3 aat(0);
+		glm::dvec3 b = force;
+		for (int i = 0; i < num_cables; i++) {
+			if (fixed[i]) {
+				b += tensions[i] * u[i];
+			}
+			else {
+				aat += glm::outerProduct(u[i], u[i]);
+				b += mid * u[i];
+			}
+		}
+		if (abs(glm::determinant(aat)) < 1e-12)
+			return false;
+		glm::dvec3 lambda = glm::inverse(aat) * b;
+
+		// fix the worst cable out of range at its bound, and solve the rest again
+		int worst = -1;
+		double worst_violation = 0;
+		for (int i = 0; i < num_cables; i++) {
+			if (fixed[i])
+				continue;
+			tensions[i] = mid - glm::dot(u[i], lambda);
+			double violation = MAX(tension_min - tensions[i], tensions[i] - tension_max);
+			if (violation > worst_violation) {
+				worst = i;
+				worst_violation = violation;
+			}
+		}
+		if (worst < 0)
+			return true;
+		tensions[worst] = ofClamp(tensions[worst], tension_min, tension_max);
+		fixed[worst] = true;
+		num_free--;
+	}
+
+	for (int i = 0; i < num_cables; i++)
+		tensions[i] = ofClamp(tensions[i], tension_min, tension_max);
+	return false;
+}
+
+double CableSolver3D::cost(const double* lengths, const glm::dvec3& position) const
+{
+	double sum = 0;
+	for (int i = 0; i < num_cables; i++) {
+		double r = glm::length(position + attachments[i] - anchors[i]) - lengths[i];
+		sum += r * r;
+	}
+	return sum;
+}
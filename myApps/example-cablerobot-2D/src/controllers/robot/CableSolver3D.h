@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ofMain.h"
+
+/**
+ * @brief Kinematics and statics of a spatial cable robot: one point-mass end
+ * effector hung from 4 to MAX_CABLES cables.
+ *
+ * - inverse: cable lengths for an end effector position, in closed form.
+ * - forward: the end effector position for measured cable lengths, by
+ *   Levenberg-Marquardt least squares, seeded from the last solution (so it
+ *   converges in a couple of iterations at control rates).
+ * - distribute: cable tensions that hold the end effector against an external
+ *   force, within [tension_min, tension_max], by the closed-form method (the
+ *   distribution closest to mid-range tension). Cables that would go out of
+ *   range are fixed at the bound and the rest are solved again; if fewer than
+ *   3 cables are left, the pose isn't wrench feasible.
+ *
+ * All storage is fixed size, so solving never allocates.
+ * Positions are in mm, forces in N.
+ */
+class CableSolver3D
+{
+public:
+	static const int MAX_CABLES = 8;
+
+	void set_num_cables(int n) { num_cables = ofClamp(n, 0, MAX_CABLES); }
+	int get_num_cables() const { return num_cables; }
+
+	void set_anchor(int i, const glm::vec3& anchor) { anchors[i] = glm::dvec3(anchor); }
+	void set_attachment(int i, const glm::vec3& attachment) { attachments[i] = glm::dvec3(attachment); }
+
+	void inverse(const glm::dvec3& position, double* lengths) const;
+	bool forward(const double* lengths, glm::dvec3& position);
+	bool distribute(const glm::dvec3& position, double* tensions) const;
+
+	glm::dvec3 force = glm::dvec3(0);	// external force on the end effector (N), e.g. its weight
+	double tension_min = 10;			// N, keeps every cable taut
+	double tension_max = 1000;			// N
+
+	int max_iterations = 20;			// forward
+	double tolerance = 0.01;			// mm, forward stops when a step is smaller than this
+	int get_iterations() const { return iterations; }
+	double get_residual() const { return residual; }	// rms length error of the last forward solution (mm)
+
+private:
+	int num_cables = 0;
+	std::array<glm::dvec3, MAX_CABLES> anchors;		// where each cable leaves its drum (world)
+	std::array<glm::dvec3, MAX_CABLES> attachments;	// where each cable meets the end effector, relative to it
+
+	double cost(const double* lengths, const glm::dvec3& position) const;
+
+	int iterations = 0;
+	double residual = 0;
+	double damping = 1e-3;		// Levenberg-Marquardt, carried over to the next solve
+};
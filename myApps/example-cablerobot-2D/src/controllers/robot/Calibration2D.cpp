@@ -0,0 +1,411 @@
+#include "Calibration2D.h"
+
+Calibration2D::Calibration2D(CableRobot2D* robot, int id, Settings settings)
+{
+	this->robot = robot;
+	this->id = id;
+	this->settings = settings;
+}
+
+Calibration2D::~Calibration2D()
+{
+	waitForThread(true);
+}
+
+/**
+ * @brief Starts driving the robot through the calibration poses. The robot must be homed and moving to its targets,
+ * and nothing else may set its targets until the calibration is done (see RobotController::set_targets).
+ */
+void Calibration2D::start()
+{
+	if (isThreadRunning())
+		return;
+	samples.clear();
+	pose = 0;
+	state = State::RUNNING;
+	startThread();
+}
+
+void Calibration2D::threadedFunction()
+{
+	LatencyTrace::set_thread_name("calibration_2D_" + ofToString(id));
+
+	// a grid inside the robot's bounds, in rows that alternate direction so the moves stay short
+	ofRectangle bounds = robot->get_bounds();
+	bounds.standardize();
+	float x_min = bounds.getLeft() + bounds.getWidth() * settings.margin;
+	float x_max = bounds.getRight() - bounds.getWidth() * settings.margin;
+	float y_min = bounds.getTop() + bounds.getHeight() * settings.margin;
+	float y_max = bounds.getBottom() - bounds.getHeight() * settings.margin;
+	glm::vec3 home = robot->get_ee();
+
+	bool aborted = false;
+	for (int row = 0; row < settings.rows && !aborted; row++) {
+		for (int col = 0; col < settings.columns && !aborted; col++) {
+			int c = row % 2 == 0 ? col : settings.columns - 1 - col;
+			glm::dvec2 target(
+				settings.columns > 1 ? ofMap(c, 0, settings.columns - 1, x_min, x_max) : bounds.getCenter().x,
+				settings.rows > 1 ? ofMap(row, 0, settings.rows - 1, y_min, y_max) : bounds.getCenter().y);
+			pose = row * settings.columns + col;
+
+			Sample s;
+			if (!move_to(target)) {
+				aborted = !isThreadRunning() || !robot->move_to_vel.get();
+				if (!aborted)
+					ofLogWarning("Calibration2D::threadedFunction") << "Robot " << id << " didn't reach pose " << pose.load() << " in " << settings.timeout << " ms. Skipping it.";
+				continue;
+			}
+			if (sample(target, s))
+				samples.push_back(s);
+		}
+	}
+	move_to(glm::dvec2(home.x, home.y));
+
+	if (aborted) {
+		ofLogWarning("Calibration2D::threadedFunction") << "Robot " << id << " calibration stopped after " << samples.size() << " poses.";
+		state = State::FAILED;
+		return;
+	}
+	save_samples("calibration_2D_" + ofToString(id) + "_" + ofGetTimestampString("%Y-%m-%d-%H-%M-%S") + ".csv");
+
+	// fit the samples from the configured geometry
+	glm::vec3 anchors[2];
+	float diameters[2], diameter_cable[2];
+	for (int i = 0; i < 2; i++) {
+		anchors[i] = robot->get_robot(i)->get_tangent();
+		diameters[i] = robot->get_robot(i)->get_drum_diameter();
+		diameter_cable[i] = robot->get_robot(i)->get_cable_diameter();
+	}
+	Result fit;
+	bool success = solve(samples, anchors, diameters, diameter_cable, settings, fit);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		result = fit;
+	}
+	state = success ? State::DONE : State::FAILED;
+	if (success) {
+		ofLogNotice("Calibration2D::threadedFunction") << "Robot " << id << " calibrated from " << fit.num_samples << " poses in " << fit.iterations << " iterations:";
+		for (int i = 0; i < 2; i++)
+			ofLogNotice("Calibration2D::threadedFunction") << "\tCable " << i << ": anchor moved " << ofToString(fit.anchors[i] - anchors[i]) << " mm, drum diameter " << diameters[i] << " -> " << fit.diameters[i] << " mm";
+		ofLogNotice("Calibration2D::threadedFunction") << "\tRMS error: " << ofToString(fit.rms_length, 2) << " mm, " << ofToString(fit.rms_force * 100, 1) << "% of the weight";
+	}
+}
+
+/**
+ * @brief Sends the end effector to a pose and waits for both cables to arrive.
+ *
+ * @param (glm::dvec2)  target: end effector (world, mm)
+ * @return (bool)  false if the pose wasn't reached in time, or the robot stopped moving
+ */
+bool Calibration2D::move_to(const glm::dvec2& target)
+{
+	// the controller thread moves the gizmo there on its next update
+	robot->set_target(target.x, target.y);
+
+	// wait for the new target to reach the cables, then for the cables to reach it
+	uint64_t time_start = ofGetElapsedTimeMillis();
+	bool arrived = false;
+	while (!arrived) {
+		if (!isThreadRunning() || !robot->move_to_vel.get() || ofGetElapsedTimeMillis() - time_start > settings.timeout)
+			return false;
+		glm::vec3 ee = robot->get_ee();
+		arrived = glm::distance(glm::dvec2(ee.x, ee.y), target) < 0.5 &&
+			abs(robot->get_robot(0)->actual_to_desired_distance) < settings.tolerance &&
+			abs(robot->get_robot(1)->actual_to_desired_distance) < settings.tolerance;
+		sleep(10);
+	}
+
+	// let the end effector stop swinging
+	uint64_t time_arrived = ofGetElapsedTimeMillis();
+	while (ofGetElapsedTimeMillis() - time_arrived < settings.settle_time) {
+		if (!isThreadRunning() || !robot->move_to_vel.get())
+			return false;
+		sleep(10);
+	}
+	return true;
+}
+
+/**
+ * @brief Averages the cables' counts and torques at the current pose.
+ *
+ * @param (glm::dvec2)  target: the pose the end effector was sent to
+ * @param (Sample&)  sample: filled with the averages
+ * @return (bool)  false if the robot stopped moving while sampling
+ */
+bool Calibration2D::sample(const glm::dvec2& target, Sample& sample)
+{
+	double counts[2] = { 0, 0 };
+	double torques[2] = { 0, 0 };
+	for (int n = 0; n < settings.num_samples; n++) {
+		if (!isThreadRunning() || !robot->move_to_vel.get())
+			return false;
+		for (int i = 0; i < 2; i++) {
+			counts[i] += robot->get_robot(i)->get_position_counts();
+			torques[i] += robot->get_robot(i)->get_torque_measured();
+		}
+		sleep(20);
+	}
+
+	CountScale scales[2];
+	glm::vec3 ee = robot->get_ee();
+	sample.target = glm::dvec2(ee.x, ee.y);
+	for (int i = 0; i < 2; i++) {
+		sample.counts[i] = llround(counts[i] / settings.num_samples);
+		sample.torques[i] = torques[i] / settings.num_samples;
+		scales[i] = robot->get_robot(i)->get_scale();
+		glm::vec3 attachment = robot->get_robot(i)->get_target() - ee;
+		sample.attachments[i] = glm::dvec2(attachment.x, attachment.y);
+	}
+	CountScale::to_mm(sample.counts, scales, sample.lengths, 2, true, sample.torques);
+	return true;
+}
+
+/**
+ * @brief Writes the samples as a CSV, to refit or compare calibrations later.
+ *
+ * @param (string)  filename: CSV saved to the local /bin/data folder
+ */
+void Calibration2D::save_samples(string filename)
+{
+	ofFile file;
+	if (!file.open(filename, ofFile::WriteOnly, false)) {
+		ofLogWarning("Calibration2D::save_samples") << "Could not open " << filename;
+		return;
+	}
+	file << "x,y,counts_0,counts_1,torque_0,torque_1,length_0,length_1\n";
+	for (auto& s : samples) {
+		file << s.target.x << "," << s.target.y << ","
+			<< s.counts[0] << "," << s.counts[1] << ","
+			<< s.torques[0] << "," << s.torques[1] << ","
+			<< s.lengths[0] << "," << s.lengths[1] << "\n";
+	}
+}
+
+/**
+ * @brief Returns the progress, for the GUI.
+ */
+string Calibration2D::get_status()
+{
+	switch (state.load()) {
+	case State::RUNNING: return "POSE " + ofToString(pose.load() + 1) + "/" + ofToString(settings.columns * settings.rows);
+	case State::DONE: return "DONE";
+	case State::FAILED: return "FAILED";
+	default: return "IDLE";
+	}
+}
+
+Calibration2D::Result Calibration2D::get_result()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return result;
+}
+
+/**
+ * @brief Solves a * x = b in place for a symmetric positive definite a (n x n, row major).
+ *
+ * @return (bool)  false if a isn't positive definite
+ */
+static bool solve_cholesky(vector<double>& a, vector<double>& b, int n)
+{
+	for (int j = 0; j < n; j++) {
+		double d = a[j * n + j];
+		for (int k = 0; k < j; k++)
+			d -= a[j * n + k] * a[j * n + k];
+		if (d <= 0)
+			return false;
+		d = sqrt(d);
+		a[j * n + j] = d;
+		for (int i = j + 1; i < n; i++) {
+			double v = a[i * n + j];
+			for (int k = 0; k < j; k++)
+				v -= a[i * n + k] * a[j * n + k];
+			a[i * n + j] = v / d;
+		}
+	}
+	for (int i = 0; i < n; i++) {
+		for (int k = 0; k < i; k++)
+			b[i] -= a[i * n + k] * b[k];
+		b[i] /= a[i * n + i];
+	}
+	for (int i = n - 1; i >= 0; i--) {
+		for (int k = i + 1; k < n; k++)
+			b[i] -= a[k * n + i] * b[k];
+		b[i] /= a[i * n + i];
+	}
+	return true;
+}
+
+/**
+ * @brief Fits a 2D robot's geometry to its calibration samples.
+ *
+ * The unknowns are the anchors' offset from each other, both drum scales, the
+ * torque to tension scale, and every pose's actual position. Each pose fits its
+ * two cable lengths and the balance of its cable tensions against gravity.
+ *
+ * @param (vector<Sample>)  samples: at least 3 poses, with the end effector hanging on the cables
+ * @param (glm::vec3[2])  anchors: configured anchors (world)
+ * @param (float[2])  diameters: configured drum diameters (mm)
+ * @param (float[2])  diameter_cable: cable diameters (mm)
+ * @param (Settings)  settings: prior and weights
+ * @param (Result&)  result: the calibrated geometry
+ * @return (bool)  false if the samples can't constrain the fit
+ */
+bool Calibration2D::solve(const vector<Sample>& samples, const glm::vec3 anchors[2], const float diameters[2], const float diameter_cable[2], const Settings& settings, Result& result)
+{
+	int num_poses = samples.size();
+	result.num_samples = num_poses;
+	if (num_poses < 3) {
+		ofLogError("Calibration2D::solve") << "Need at least 3 poses, got " << num_poses << ".";
+		return false;
+	}
+
+	// the tensions have to carry the end effector for the statics to say anything
+	double torque_mean = 0;
+	for (auto& s : samples)
+		torque_mean += (fabs(s.torques[0]) + fabs(s.torques[1])) / (2 * num_poses);
+	if (torque_mean < 0.5) {
+		ofLogError("Calibration2D::solve") << "The motors' torques are too low to calibrate (" << ofToString(torque_mean, 2) << "% on average). Is the end effector hanging on the cables?";
+		return false;
+	}
+
+	const glm::dvec2 down(0, -1);
+	glm::dvec2 a[2] = { glm::dvec2(anchors[0].x, anchors[0].y), glm::dvec2(anchors[1].x, anchors[1].y) };
+	double sigma[2];
+	for (int i = 0; i < 2; i++)
+		sigma[i] = settings.diameter_sigma / (diameters[i] + diameter_cable[i]);
+
+	// x = [offset.x, offset.y, scale_0, scale_1, tension_scale, pose_0.x, pose_0.y, ...]
+	int n = 5 + 2 * num_poses;
+	int m = 4 * num_poses + 2;
+	auto residuals = [&](const vector<double>& x, vector<double>& r) {
+		glm::dvec2 offset(x[0], x[1]);
+		glm::dvec2 anchor[2] = { a[0] - offset * 0.5, a[1] + offset * 0.5 };
+		for (int k = 0; k < num_poses; k++) {
+			const Sample& s = samples[k];
+			glm::dvec2 p(x[5 + 2 * k], x[6 + 2 * k]);
+			glm::dvec2 force = down;
+			for (int i = 0; i < 2; i++) {
+				glm::dvec2 v = anchor[i] - (p + s.attachments[i]);
+				double length = glm::length(v);
+				r[4 * k + i] = length - x[2 + i] * s.lengths[i];
+				if (length > 0)
+					force += x[4] * fabs(s.torques[i]) * v / length;
+			}
+			r[4 * k + 2] = settings.force_weight * force.x;
+			r[4 * k + 3] = settings.force_weight * force.y;
+		}
+		r[4 * num_poses] = (x[2] - 1) / sigma[0];
+		r[4 * num_poses + 1] = (x[3] - 1) / sigma[1];
+	};
+	auto cost = [](const vector<double>& r) {
+		double sum = 0;
+		for (double v : r)
+			sum += v * v;
+		return sum;
+	};
+
+	// start from the configured geometry, with each pose where it was sent
+	vector<double> x(n, 0);
+	x[2] = 1;
+	x[3] = 1;
+	double ff = 0, fd = 0;
+	for (int k = 0; k < num_poses; k++) {
+		const Sample& s = samples[k];
+		x[5 + 2 * k] = s.target.x;
+		x[6 + 2 * k] = s.target.y;
+		glm::dvec2 force(0);
+		for (int i = 0; i < 2; i++)
+			force += fabs(s.torques[i]) * glm::normalize(a[i] - (s.target + s.attachments[i]));
+		ff += glm::dot(force, force);
+		fd -= glm::dot(force, down);
+	}
+	x[4] = fd / ff;
+
+	vector<double> r(m), r_next(m), jac(m * n), jtj(n * n), step(n), x_next(n);
+	residuals(x, r);
+	double error = cost(r);
+	double damping = 1e-3;
+	result.converged = false;
+	result.iterations = 0;
+
+	while (result.iterations < settings.max_iterations && !result.converged) {
+		result.iterations++;
+
+		// forward difference jacobian
+		for (int j = 0; j < n; j++) {
+			x_next = x;
+			double h = 1e-6 * MAX(1.0, fabs(x[j]));
+			x_next[j] += h;
+			residuals(x_next, r_next);
+			for (int i = 0; i < m; i++)
+				jac[i * n + j] = (r_next[i] - r[i]) / h;
+		}
+		vector<double> jtr(n, 0);
+		std::fill(jtj.begin(), jtj.end(), 0);
+		for (int i = 0; i < m; i++) {
+			for (int j = 0; j < n; j++) {
+				double jij = jac[i * n + j];
+				if (jij == 0)
+					continue;
+				jtr[j] += jij * r[i];
+				for (int k = 0; k <= j; k++)
+					jtj[j * n + k] += jij * jac[i * n + k];
+			}
+		}
+		for (int j = 0; j < n; j++)
+			for (int k = 0; k < j; k++)
+				jtj[k * n + j] = jtj[j * n + k];
+
+		// damp toward gradient descent until a step lowers the error
+		while (true) {
+			vector<double> h = jtj;
+			for (int j = 0; j < n; j++) {
+				h[j * n + j] += damping * MAX(jtj[j * n + j], 1e-9);
+				step[j] = -jtr[j];
+			}
+			bool solved = solve_cholesky(h, step, n);
+			double next_error = std::numeric_limits<double>::max();
+			if (solved) {
+				for (int j = 0; j < n; j++)
+					x_next[j] = x[j] + step[j];
+				residuals(x_next, r_next);
+				next_error = cost(r_next);
+			}
+			if (next_error <= error) {
+				bool small = true;
+				for (int j = 0; j < n; j++)
+					small = small && fabs(step[j]) < 1e-6 * MAX(1.0, fabs(x[j]));
+				result.converged = small || error - next_error < 1e-12 * error;
+				x = x_next;
+				r = r_next;
+				error = next_error;
+				damping = MAX(damping * 0.1, 1e-12);
+				break;
+			}
+			damping *= 10;
+			if (damping > 1e12) {
+				// no step lowers the error any more: this is the minimum
+				result.converged = true;
+				break;
+			}
+		}
+	}
+
+	glm::dvec2 offset(x[0], x[1]);
+	glm::dvec2 anchor[2] = { a[0] - offset * 0.5, a[1] + offset * 0.5 };
+	double sum_length = 0, sum_force = 0;
+	for (int k = 0; k < num_poses; k++) {
+		sum_length += r[4 * k] * r[4 * k] + r[4 * k + 1] * r[4 * k + 1];
+		sum_force += (r[4 * k + 2] * r[4 * k + 2] + r[4 * k + 3] * r[4 * k + 3]) / (settings.force_weight * settings.force_weight);
+	}
+	for (int i = 0; i < 2; i++) {
+		result.anchors[i] = glm::vec3(anchor[i].x, anchor[i].y, anchors[i].z);
+		result.diameters[i] = (diameters[i] + diameter_cable[i]) * x[2 + i] - diameter_cable[i];
+	}
+	result.tension_scale = x[4];
+	result.rms_length = sqrt(sum_length / (2 * num_poses));
+	result.rms_force = sqrt(sum_force / (2 * num_poses));
+	if (!result.converged)
+		ofLogWarning("Calibration2D::solve") << "Didn't converge in " << settings.max_iterations << " iterations.";
+	return result.converged;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ofMain.h"
+#include "CableRobot2D.h"
+
+/**
+ * @brief Self-calibration of a 2D robot's cable anchors and drum diameters.
+ *
+ * The calibration thread drives the robot's end effector through a grid of
+ * poses. At each pose it waits for the cables to settle, then averages their
+ * counts and torques. The robot's own control thread does the moving.
+ *
+ * The samples are fit by nonlinear least squares (Levenberg-Marquardt) over
+ * every pose's actual position, the anchors, the drum diameters and a torque to
+ * tension scale. Each pose gives two residuals from its cable lengths and two
+ * from its static equilibrium: the cables' tensions hold up the end effector.
+ *
+ * Anchors are the points where the cables leave their drums (base + tangent).
+ * Only this sum is observable, and only relative to the other cable. So the
+ * pair's midpoint stays where it is configured, and the correction is applied
+ * to the tangent. The overall scale isn't observable from lengths and forces
+ * either, so the drum diameters carry a prior at their configured values.
+ */
+class Calibration2D :
+	public ofThread
+{
+public:
+	struct Settings {
+		int columns = 4;
+		int rows = 3;
+		float margin = 0.2;				// fraction of the bounds left out on each side
+		float tolerance = 2;			// mm, both cables within this of the pose to sample it
+		int settle_time = 1000;			// ms after arriving, before sampling
+		int timeout = 30000;			// ms to reach a pose before skipping it
+		int num_samples = 20;			// averaged per pose, 20 ms apart
+		float diameter_sigma = 2;		// mm, prior on each drum diameter
+		float force_weight = 100;		// mm of length error per unit of weight error
+		int max_iterations = 50;
+	};
+
+	struct Sample {
+		glm::dvec2 target;			// where the end effector was sent (world, mm)
+		glm::dvec2 attachments[2];	// each cable's attachment, relative to the end effector
+		int64_t counts[2];
+		float torques[2];			// % of max
+		float lengths[2];			// mm, converted at the configured drum scales
+	};
+
+	struct Result {
+		glm::vec3 anchors[2];		// world
+		float diameters[2];			// mm
+		float tension_scale = 0;	// weights per % of max torque
+		float rms_length = 0;		// mm
+		float rms_force = 0;		// weights
+		int num_samples = 0;
+		int iterations = 0;
+		bool converged = false;
+	};
+
+	enum State {
+		IDLE,
+		RUNNING,
+		DONE,
+		FAILED
+	};
+
+	Calibration2D(CableRobot2D* robot, int id, Settings settings);
+	~Calibration2D();
+
+	void start();
+	void threadedFunction();
+
+	State get_state() { return state.load(); }
+	string get_status();
+	Result get_result();
+	CableRobot2D* get_robot() { return robot; }
+
+	static bool solve(const vector<Sample>& samples, const glm::vec3 anchors[2], const float diameters[2], const float diameter_cable[2], const Settings& settings, Result& result);
+
+private:
+	CableRobot2D* robot;
+	int id;
+	Settings settings;
+
+	std::atomic<State> state{ State::IDLE };
+	std::atomic<int> pose{ 0 };
+	std::mutex mutex;
+	Result result;
+
+	vector<Sample> samples;
+	bool move_to(const glm::dvec2& target);
+	bool sample(const glm::dvec2& target, Sample& sample);
+	void save_samples(string filename);
+};
@@ -0,0 +1,172 @@
+#include "KinematicGraph.h"
+
+/**
+ * @brief Adds a frame to the graph.
+ *
+ * @param (int)  parent: index of the parent frame, or -1 for a world frame. Must already exist.
+ * @param (glm::vec3)  position: local position
+ * @param (glm::quat)  orientation: local orientation
+ * @return (int)  index of the new frame
+ */
+int KinematicGraph::add(int parent, glm::vec3 position, glm::quat orientation)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (parent >= (int)parents.size()) {
+		ofLogError(__FUNCTION__) << "Parent " << parent << " does not exist yet; adding frame to the world instead.";
+		parent = -1;
+	}
+	parents.push_back(parent);
+	positions.push_back(position);
+	orientations.push_back(orientation);
+	dirty.push_back(true);
+	any_dirty = true;
+	global_positions.push_back(position);
+	global_orientations.push_back(orientation);
+	update_globals();
+
+	std::lock_guard<std::mutex> lock_published(mutex_published);
+	published_positions = global_positions;
+	published_orientations = global_orientations;
+
+	return parents.size() - 1;
+}
+
+void KinematicGraph::set_position(int i, glm::vec3 position)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (positions[i] != position) {
+		positions[i] = position;
+		dirty[i] = true;
+		any_dirty = true;
+	}
+}
+
+void KinematicGraph::set_orientation(int i, glm::quat orientation)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (orientations[i] != orientation) {
+		orientations[i] = orientation;
+		dirty[i] = true;
+		any_dirty = true;
+	}
+}
+
+/**
+ * @brief Sets the local position of a frame so that it lands on a world position.
+ *
+ * @param (int)  i: frame index
+ * @param (glm::vec3)  position: position (in world coordinates)
+ */
+void KinematicGraph::set_global_position(int i, glm::vec3 position)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	update_globals();
+	glm::vec3 local = glm::inverse(parent_orientation(i)) * (position - parent_position(i));
+	if (positions[i] != local) {
+		positions[i] = local;
+		dirty[i] = true;
+		any_dirty = true;
+	}
+}
+
+void KinematicGraph::set_global_transform(int i, glm::vec3 position, glm::quat orientation)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	update_globals();
+	glm::quat inv = glm::inverse(parent_orientation(i));
+	positions[i] = inv * (position - parent_position(i));
+	orientations[i] = inv * orientation;
+	dirty[i] = true;
+	any_dirty = true;
+}
+
+glm::vec3 KinematicGraph::get_position(int i)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return positions[i];
+}
+
+/**
+ * @brief Recomputes the dirty frames and publishes the new globals.
+ * Call once per tick, after all the frames for that tick have been set.
+ */
+void KinematicGraph::update()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	update_globals();
+	if (!needs_publish)
+		return;
+	needs_publish = false;
+
+	std::lock_guard<std::mutex> lock_published(mutex_published);
+	published_positions = global_positions;
+	published_orientations = global_orientations;
+}
+
+/**
+ * @brief Returns the world position of a frame as of the last update().
+ * Safe to call from any thread.
+ */
+glm::vec3 KinematicGraph::get_global_position(int i)
+{
+	std::lock_guard<std::mutex> lock(mutex_published);
+	return published_positions[i];
+}
+
+glm::quat KinematicGraph::get_global_orientation(int i)
+{
+	std::lock_guard<std::mutex> lock(mutex_published);
+	return published_orientations[i];
+}
+
+/**
+ * @brief Returns a world-space ofNode for a frame (for gizmos and drawing).
+ */
+ofNode KinematicGraph::get_node(int i)
+{
+	ofNode node;
+	node.setGlobalPosition(get_global_position(i));
+	node.setGlobalOrientation(get_global_orientation(i));
+	return node;
+}
+
+/**
+ * @brief Walks the frames in index (topological) order and recomputes
+ * every frame that is dirty or has a recomputed parent.
+ * Expects the caller to hold the mutex. The setters call it to read fresh parent
+ * globals, so it only marks the globals for publishing; update() publishes them.
+ */
+void KinematicGraph::update_globals()
+{
+	if (!any_dirty)
+		return;
+	for (int i = 0; i < parents.size(); i++) {
+		int p = parents[i];
+		if (p >= 0 && dirty[p])
+			dirty[i] = true;
+		if (!dirty[i])
+			continue;
+		if (p < 0) {
+			global_positions[i] = positions[i];
+			global_orientations[i] = orientations[i];
+		}
+		else {
+			global_positions[i] = global_positions[p] + global_orientations[p] * positions[i];
+			global_orientations[i] = global_orientations[p] * orientations[i];
+		}
+	}
+	// clear after the pass, so children further down still see their parent's flag
+	std::fill(dirty.begin(), dirty.end(), false);
+	any_dirty = false;
+	needs_publish = true;
+}
+
+glm::vec3 KinematicGraph::parent_position(int i)
+{
+	return parents[i] < 0 ? glm::vec3() : global_positions[parents[i]];
+}
+
+glm::quat KinematicGraph::parent_orientation(int i)
+{
+	return parents[i] < 0 ? glm::quat(1, 0, 0, 0) : global_orientations[parents[i]];
+}
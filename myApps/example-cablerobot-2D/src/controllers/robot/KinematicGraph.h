@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ofMain.h"
+
+/**
+ * @brief Flat transform hierarchy for the robots' kinematic frames.
+ *
+ * Frames are stored in contiguous arrays with parent indices. A parent must
+ * be added before its children, so index order is always a valid topological
+ * order. Setting a local transform only marks the frame dirty; update()
+ * recomputes the dirty frames (and their children) once per tick, then
+ * publishes the global positions for readers on other threads.
+ */
+class KinematicGraph
+{
+public:
+	int add(int parent = -1, glm::vec3 position = glm::vec3(), glm::quat orientation = glm::quat(1, 0, 0, 0));
+	int size() { return parents.size(); }
+
+	void set_position(int i, glm::vec3 position);
+	void set_orientation(int i, glm::quat orientation);
+	void set_global_position(int i, glm::vec3 position);
+	void set_global_transform(int i, glm::vec3 position, glm::quat orientation);
+
+	glm::vec3 get_position(int i);
+	int get_parent(int i) { return parents[i]; }
+
+	void update();
+
+	glm::vec3 get_global_position(int i);
+	glm::quat get_global_orientation(int i);
+	ofNode get_node(int i);
+
+private:
+	// local transforms (written by the app and robot threads)
+	vector<int> parents;
+	vector<glm::vec3> positions;
+	vector<glm::quat> orientations;
+	vector<bool> dirty;
+	bool any_dirty = false;
+	bool needs_publish = false;		// globals changed since the last publish; only update() clears it
+
+	// global transforms (recomputed in update)
+	vector<glm::vec3> global_positions;
+	vector<glm::quat> global_orientations;
+
+	// last published globals (read by the control and render threads)
+	vector<glm::vec3> published_positions;
+	vector<glm::quat> published_orientations;
+
+	std::mutex mutex;
+	std::mutex mutex_published;
+
+	void update_globals();
+	glm::vec3 parent_position(int i);
+	glm::quat parent_orientation(int i);
+};
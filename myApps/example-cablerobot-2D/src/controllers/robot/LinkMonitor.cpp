@@ -0,0 +1,185 @@
+#include "LinkMonitor.h"
+
+static int64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//--------------------------------------------------------------
+LinkMonitor::Transaction::Transaction(Node* node) :
+	node(node) {
+	if (node == nullptr)
+		return;
+	exceptions = std::uncaught_exceptions();
+	int depth = node->port->in_flight.fetch_add(1, std::memory_order_relaxed) + 1;
+	int peak = node->port->in_flight_peak.load(std::memory_order_relaxed);
+	while (depth > peak && !node->port->in_flight_peak.compare_exchange_weak(peak, depth, std::memory_order_relaxed));
+	start = now_ns();
+}
+
+LinkMonitor::Transaction::~Transaction() {
+	if (node == nullptr)
+		return;
+	int64_t rtt = now_ns() - start;
+	node->port->in_flight.fetch_sub(1, std::memory_order_relaxed);
+	node->rtt[LatencyHistogram::get_index(rtt)].fetch_add(1, std::memory_order_relaxed);
+	node->commands.fetch_add(1, std::memory_order_relaxed);
+	if (std::uncaught_exceptions() > exceptions)
+		node->failures.fetch_add(1, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+LinkMonitor::~LinkMonitor()
+{
+	waitForThread(true);
+}
+
+/**
+ * @brief Starts monitoring a node. Call for every node before start().
+ *
+ * @param (int)  port_index: index of the node's port in the SysManager
+ * @param (INode*)  node: node to monitor
+ * @param (int)  serial_number: node serial number, for the telemetry log
+ * @return (Node*)  counters to hand to the node's Motor.
+ */
+LinkMonitor::Node* LinkMonitor::add(int port_index, INode* node, int serial_number)
+{
+	while (ports.size() <= port_index)
+		ports.push_back(make_unique<Port>());
+
+	nodes.push_back(make_unique<Node>());
+	auto& n = *nodes.back();
+	n.node = node;
+	n.port = ports[port_index].get();
+	n.port_index = port_index;
+	n.address = node->Info.Ex.Addr();
+	n.serial_number = serial_number;
+	return &n;
+}
+
+/**
+ * @brief Starts the monitor thread.
+ *
+ * @param (int)  interval: length of each statistics window (ms)
+ * @param (string)  filename: telemetry log in the local /bin/data folder, appended to. Defaults to "link_telemetry.csv"
+ */
+void LinkMonitor::start(int interval, string filename)
+{
+	this->interval = interval;
+	bool is_new = !ofFile::doesFileExist(filename);
+	if (telemetry.open(filename, ofFile::Append, false) && is_new)
+		telemetry << "time,port,address,serial_number,rtt_p50_ms,rtt_p99_ms,rtt_max_ms,commands_per_sec,in_flight_peak,buffer_full,failures,err_checksum,err_fragment,err_stray,err_overrun\n";
+	time_window = ofGetElapsedTimeMillis();
+	startThread();
+}
+
+/**
+ * @brief Returns the statistics of the last complete window, one per node.
+ */
+vector<LinkMonitor::Stats> LinkMonitor::get_stats()
+{
+	std::lock_guard<std::mutex> lock(mutex_stats);
+	return stats;
+}
+
+void LinkMonitor::threadedFunction()
+{
+	while (isThreadRunning()) {
+		sleep(interval);
+
+		uint64_t t = ofGetElapsedTimeMillis();
+		float seconds = MAX(1, t - time_window) / 1000.0;
+		time_window = t;
+
+		vector<Stats> window_stats;
+		for (auto& node : nodes)
+			window_stats.push_back(read_window(*node, seconds));
+		for (auto& port : ports)
+			port->in_flight_peak.store(port->in_flight.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+		// flag saturation once per episode
+		bool is_saturated = false;
+		for (auto& s : window_stats) {
+			if (s.buffer_full > 0 || s.rtt_p99 > rtt_warning.load()) {
+				if (!saturated.load())
+					ofLogWarning("LinkMonitor") << "Port " << s.port << " looks saturated: node " << s.address << " p99 round trip " << ofToString(s.rtt_p99, 2) << " ms, " << s.buffer_full << " move buffer full events, " << s.in_flight_peak << " commands in flight.";
+				is_saturated = true;
+				break;
+			}
+		}
+		saturated.store(is_saturated);
+
+		write_telemetry(window_stats);
+		{
+			std::lock_guard<std::mutex> lock(mutex_stats);
+			stats = window_stats;
+		}
+		window++;
+	}
+}
+
+/**
+ * @brief Closes the current window on a node: diffs its counters against the last window.
+ */
+LinkMonitor::Stats LinkMonitor::read_window(Node& node, float seconds)
+{
+	Stats s;
+	s.port = node.port_index;
+	s.address = node.address;
+	s.serial_number = node.serial_number;
+
+	LatencyHistogram histogram;
+	for (int i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+		uint32_t count = node.rtt[i].load(std::memory_order_relaxed);
+		if (count != node.rtt_last[i])
+			histogram.add(LatencyHistogram::get_value(i), count - node.rtt_last[i]);
+		node.rtt_last[i] = count;
+	}
+	s.rtt_p50 = histogram.get_percentile(50) / 1000000.0;
+	s.rtt_p99 = histogram.get_percentile(99) / 1000000.0;
+	s.rtt_max = histogram.get_max() / 1000000.0;
+
+	uint64_t commands = node.commands.load(std::memory_order_relaxed);
+	s.commands_per_sec = (commands - node.commands_last) / seconds;
+	node.commands_last = commands;
+
+	uint64_t buffer_full = node.buffer_full.load(std::memory_order_relaxed);
+	s.buffer_full = buffer_full - node.buffer_full_last;
+	node.buffer_full_last = buffer_full;
+
+	uint64_t failures = node.failures.load(std::memory_order_relaxed);
+	s.failures = failures - node.failures_last;
+	node.failures_last = failures;
+
+	s.in_flight_peak = node.port->in_flight_peak.load(std::memory_order_relaxed);
+
+	// the node counts the same checksum/fragment/stray/overrun errors the host reports
+	nodeparam params[4] = { CPM_P_NETERR_APP_CHKSUM, CPM_P_NETERR_APP_FRAG, CPM_P_NETERR_APP_STRAY, CPM_P_NETERR_APP_OVERRUN };
+	uint32_t* errors[4] = { &s.err_checksum, &s.err_fragment, &s.err_stray, &s.err_overrun };
+	try {
+		for (int i = 0; i < 4; i++) {
+			double count = node.node->Info.Ex.Parameter(params[i]);
+			if (node.errors_last[i] >= 0)
+				*errors[i] = count >= node.errors_last[i] ? count - node.errors_last[i] : count;	// counters wrap
+			node.errors_last[i] = count;
+		}
+	}
+	catch (mnErr& theErr) {
+		ofLogWarning("LinkMonitor::read_window") << "Could not read the network error counters of node " << node.address << ": " << theErr.ErrorMsg;
+	}
+	return s;
+}
+
+void LinkMonitor::write_telemetry(const vector<Stats>& window_stats)
+{
+	if (!telemetry.is_open())
+		return;
+	string time = ofGetTimestampString("%Y-%m-%d %H:%M:%S.%i");
+	for (auto& s : window_stats) {
+		telemetry << time << "," << s.port << "," << s.address << "," << s.serial_number << ",";
+		telemetry << s.rtt_p50 << "," << s.rtt_p99 << "," << s.rtt_max << "," << s.commands_per_sec << "," << s.in_flight_peak << ",";
+		telemetry << s.buffer_full << "," << s.failures << ",";
+		telemetry << s.err_checksum << "," << s.err_fragment << "," << s.err_stray << "," << s.err_overrun << "\n";
+	}
+	telemetry.flush();
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ofMain.h"
+#include "pubSysCls.h"
+#include "../LatencyTrace.h"
+
+using namespace sFnd;
+
+/**
+ * @brief Live performance monitor for the serial links to the motors.
+ *
+ * Motors bracket each blocking command with a Transaction, which records the
+ * round-trip time and the number of commands in flight on the node's port in
+ * lock-free counters. Once per window, the monitor thread turns the counters
+ * into rolling per-node statistics, reads the node's own network error
+ * counters, and appends one line per node to the telemetry log.
+ *
+ * A port whose round trips stretch past the warning threshold, or whose
+ * motors report a full move buffer, is logged as saturated.
+ */
+class LinkMonitor :
+	public ofThread
+{
+public:
+	struct Port {
+		std::atomic<int> in_flight{ 0 };
+		std::atomic<int> in_flight_peak{ 0 };
+	};
+
+	struct Node {
+		INode* node = nullptr;
+		Port* port = nullptr;
+		int port_index = 0;
+		int address = 0;
+		int serial_number = 0;
+
+		// written by any thread that talks to the node
+		std::atomic<uint32_t> rtt[LatencyHistogram::NUM_BUCKETS];
+		std::atomic<uint64_t> commands{ 0 };
+		std::atomic<uint64_t> buffer_full{ 0 };
+		std::atomic<uint64_t> failures{ 0 };
+
+		// last window, read by the monitor thread only
+		uint32_t rtt_last[LatencyHistogram::NUM_BUCKETS] = { 0 };
+		uint64_t commands_last = 0;
+		uint64_t buffer_full_last = 0;
+		uint64_t failures_last = 0;
+		double errors_last[4] = { -1, -1, -1, -1 };
+
+		Node() { for (auto& count : rtt) count.store(0, std::memory_order_relaxed); }
+	};
+
+	/**
+	 * @brief Brackets one blocking round trip on the link.
+	 * A command that throws is counted as a failure.
+	 */
+	class Transaction {
+	public:
+		Transaction(Node* node);
+		~Transaction();
+	private:
+		Node* node;
+		int64_t start;
+		int exceptions;
+	};
+
+	struct Stats {
+		int port = 0;
+		int address = 0;
+		int serial_number = 0;
+		float rtt_p50 = 0;			// ms
+		float rtt_p99 = 0;			// ms
+		float rtt_max = 0;			// ms
+		float commands_per_sec = 0;
+		int in_flight_peak = 0;		// deepest the node's port got this window
+		uint64_t buffer_full = 0;	// move buffer full events this window
+		uint64_t failures = 0;		// commands that threw this window
+		uint32_t err_checksum = 0;	// network errors the node counted this window
+		uint32_t err_fragment = 0;
+		uint32_t err_stray = 0;
+		uint32_t err_overrun = 0;
+	};
+
+	~LinkMonitor();
+
+	Node* add(int port_index, INode* node, int serial_number);
+	void start(int interval = 1000, string filename = "link_telemetry.csv");
+
+	vector<Stats> get_stats();
+	uint64_t get_window() { return window.load(); }
+	bool is_saturated() { return saturated.load(); }
+
+	std::atomic<float> rtt_warning{ 10 };	// ms
+
+	void threadedFunction();
+
+private:
+	vector<unique_ptr<Port>> ports;
+	vector<unique_ptr<Node>> nodes;
+
+	int interval = 1000;		// ms per window
+	ofFile telemetry;
+	uint64_t time_window = 0;
+
+	std::mutex mutex_stats;
+	vector<Stats> stats;
+	std::atomic<uint64_t> window{ 0 };
+	std::atomic<bool> saturated{ false };
+
+	Stats read_window(Node& node, float seconds);
+	void write_telemetry(const vector<Stats>& window_stats);
+};
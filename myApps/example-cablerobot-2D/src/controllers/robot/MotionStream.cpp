@@ -0,0 +1,152 @@
+#include "MotionStream.h"
+
+std::atomic<MotionStream*> MotionStream::registry[NET_CONTROLLER_MAX][MN_API_MAX_NODES];
+
+MotionStream::~MotionStream()
+{
+	if (registered)
+		registry[port][address].store(nullptr);
+}
+
+/**
+ * @brief Routes the node's attentions to this stream.
+ * The node's attention mask and the port's handler are set up by the Motor.
+ *
+ * @param (int)  port: SC Hub port index
+ * @param (int)  address: node address on the port
+ */
+void MotionStream::setup(int port, int address)
+{
+	if (port < 0 || port >= NET_CONTROLLER_MAX || address < 0 || address >= MN_API_MAX_NODES)
+		return;
+	this->port = port;
+	this->address = address;
+	registry[port][address].store(this);
+	registered = true;
+	time_progress.store(ofGetElapsedTimeMillis());
+}
+
+/**
+ * @brief Port attention handler. Runs on sFoundation's thread, so it only updates counters.
+ */
+void nodeCallback MotionStream::on_attention(const mnAttnReqReg& detected)
+{
+	int port = detected.MultiAddr >> 4;
+	int address = detected.MultiAddr & MN_API_ADDR_MASK;
+	if (port >= NET_CONTROLLER_MAX)
+		return;
+	MotionStream* stream = registry[port][address].load();
+	if (stream == nullptr || !detected.AttentionReg.cpm.MoveCmdComplete)
+		return;
+
+	int d = stream->depth.load();
+	while (d > 0 && !stream->depth.compare_exchange_weak(d, d - 1));
+	stream->completed++;
+	stream->time_progress.store(ofGetElapsedTimeMillis());
+}
+
+/**
+ * @brief Queues the newest velocity command, superseding any that is still held.
+ *
+ * @param (float)  rpm: target velocity
+ */
+void MotionStream::push(float rpm)
+{
+	// the node was stopped outside the stream: whatever it was last sent no longer holds
+	if (is_reset.exchange(false)) {
+		has_pending = false;
+		last_sent = NAN;
+	}
+	if (has_pending)
+		merged++;
+	// the node is already headed to (about) this velocity
+	if (abs(rpm - last_sent) <= epsilon) {
+		has_pending = false;
+		return;
+	}
+	pending = rpm;
+	has_pending = true;
+}
+
+/**
+ * @brief Returns true if a command is waiting and the node has room for it.
+ */
+bool MotionStream::is_ready()
+{
+	return has_pending && depth.load() < target_depth;
+}
+
+/**
+ * @brief Takes the waiting command to send, and counts it as buffered on the node.
+ */
+float MotionStream::take()
+{
+	has_pending = false;
+	last_sent = pending;
+	depth++;
+	sent++;
+	time_progress.store(ofGetElapsedTimeMillis());
+	return pending;
+}
+
+/**
+ * @brief The node refused a command: holds it for retry, unless a newer one arrived.
+ */
+void MotionStream::on_rejected(float rpm)
+{
+	int d = depth.load();
+	while (d > 0 && !depth.compare_exchange_weak(d, d - 1));
+	rejected++;
+	if (!has_pending) {
+		pending = rpm;
+		has_pending = true;
+	}
+}
+
+/**
+ * @brief Returns true if commands are waiting on a full buffer that hasn't moved in a while,
+ * e.g. a completion attention was missed.
+ */
+bool MotionStream::is_stalled()
+{
+	return has_pending && depth.load() >= target_depth && ofGetElapsedTimeMillis() - time_progress.load() > stall_timeout;
+}
+
+/**
+ * @brief Resets the tracked depth from a status read.
+ *
+ * @param (int)  depth: moves the node has buffered
+ */
+void MotionStream::resync(int depth)
+{
+	this->depth.store(depth);
+	resyncs++;
+	time_progress.store(ofGetElapsedTimeMillis());
+}
+
+/**
+ * @brief Forgets the node's buffered moves and its last sent velocity, after it was stopped
+ * outside the stream. The next command is always sent. Safe to call from any thread.
+ */
+void MotionStream::reset()
+{
+	depth.store(0);
+	is_reset.store(true);
+	time_progress.store(ofGetElapsedTimeMillis());
+}
+
+/**
+ * @brief Resets the stream of every node on a port, after a group stop.
+ *
+ * @param (int)  port: SC Hub port index
+ */
+void MotionStream::reset_port(int port)
+{
+	if (port < 0 || port >= NET_CONTROLLER_MAX)
+		return;
+	for (int i = 0; i < MN_API_MAX_NODES; i++) {
+		MotionStream* stream = registry[port][i].load();
+		if (stream != nullptr)
+			stream->reset();
+	}
+}
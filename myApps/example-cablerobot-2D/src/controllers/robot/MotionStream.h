@@ -0,0 +1,67 @@
+#pragma once
+
+#include "ofMain.h"
+#include "pubSysCls.h"
+
+using namespace sFnd;
+
+/**
+ * @brief Streaming velocity command queue for one motor.
+ *
+ * Tracks how many moves the node has buffered without polling: every
+ * accepted command adds one, and every Move Command Complete attention from
+ * the node takes one away. Submissions are paced to keep the node's buffer at
+ * a target depth; a command that has to wait is held, and superseded by the
+ * next one, instead of being dropped.
+ *
+ * If no attention arrives for a while with commands waiting, the owner resyncs
+ * the depth from one status read (see is_stalled). Anything that stops the node
+ * outside the stream (stops, E-Stops, group stops) must reset it.
+ */
+class MotionStream
+{
+public:
+	MotionStream() {};
+	~MotionStream();
+
+	void setup(int port, int address);
+	static void nodeCallback on_attention(const mnAttnReqReg& detected);
+
+	void push(float rpm);
+	bool is_ready();
+	float take();
+	void on_rejected(float rpm);
+	bool is_stalled();
+	void resync(int depth);
+	void reset();
+	static void reset_port(int port);
+
+	bool is_attention_enabled() { return registered; }
+	int get_depth() { return depth.load(); }
+
+	int target_depth = 2;			// moves to keep buffered on the node
+	float epsilon = 0.01;			// RPM, smaller changes than this aren't sent
+	int stall_timeout = 50;			// ms without progress before resyncing
+
+	// exported counters
+	std::atomic<uint64_t> sent{ 0 };
+	std::atomic<uint64_t> completed{ 0 };	// from attentions
+	std::atomic<uint64_t> merged{ 0 };		// held commands superseded by a newer one
+	std::atomic<uint64_t> rejected{ 0 };	// the node refused (buffer full); held for retry
+	std::atomic<uint64_t> resyncs{ 0 };
+
+private:
+	int port = -1;
+	int address = -1;
+	bool registered = false;
+
+	std::atomic<int> depth{ 0 };
+	std::atomic<uint64_t> time_progress{ 0 };	// ms, last send or completion
+
+	bool has_pending = false;		// tick thread only
+	float pending = 0;
+	float last_sent = 0;
+	std::atomic<bool> is_reset{ false };	// set by reset() from any thread, applied by the tick thread
+
+	static std::atomic<MotionStream*> registry[NET_CONTROLLER_MAX][MN_API_MAX_NODES];
+};
@@ -1,24 +1,43 @@
 #include "Motor.h"
+#include "../LatencyTrace.h"
 
 Motor::Motor(SysManager& SysMgr, INode* node):
+	Motor(SysMgr, node, NodeInventory::read_node(-1, *node)) {
+}
+
+/**
+ * @brief Creates a Motor from a node whose static Info has already been read (or cached).
+ * Only the node's live state is read from the network here.
+ */
+Motor::Motor(SysManager& SysMgr, INode* node, NodeInfo info):
 	m_node(node),
-	m_sysMgr(SysMgr) {
-
-	printf("   Node[%d]: type=%d\n", m_node->Info.Ex.Addr(), m_node->Info.NodeType());
-	printf("            userID: %s\n", m_node->Info.UserID.Value());
-	printf("        FW version: %s\n", m_node->Info.FirmwareVersion.Value());
-	printf("          Serial #: %d\n", m_node->Info.SerialNumber.Value());
-	printf("             Model: %s\n", m_node->Info.Model.Value());
-	printf("        Resolution: %d\n", m_node->Info.PositioningResolution.Value());
+	m_sysMgr(&SysMgr),
+	m_info(info) {
+
+	printf("   Node[%d]: type=%d%s\n", m_info.address, m_info.node_type, m_info.cached ? " (cached)" : "");
+	printf("            userID: %s\n", m_info.user_id.c_str());
+	printf("        FW version: %s\n", m_info.firmware_version.c_str());
+	printf("          Serial #: %d\n", m_info.serial_number);
+	printf("             Model: %s\n", m_info.model.c_str());
+	printf("        Resolution: %d\n", m_info.resolution);
 	printf("      Is E-Stopped: %s\n", is_estopped() ? "TRUE" : "FALSE");
 	printf("        Is Enabled: %s\n", is_enabled() ? "TRUE" : "FALSE");
 	printf("          Is Homed: %s\n", m_node->Motion.Homing.WasHomed() ? "TRUE":"FALSE");
-	printf("  Current Position: %d\n\n", get_position());
+	printf("  Current Position: %lld\n\n", (long long)get_position());
 
 	set_motion_params();
 }
 
+Motor::Motor(NodeInfo info):
+	m_node(nullptr),
+	m_sysMgr(nullptr),
+	m_info(info) {
+}
+
 Motor::~Motor() {
+	if (m_node == nullptr)
+		return;
+
 	// Disable the node and wait for it to disable
 	m_node->EnableReq(false);
 
@@ -37,7 +56,7 @@ Motor::~Motor() {
 
 int Motor::get_resolution()
 {
-	return m_node->Info.PositioningResolution.Value();;
+	return m_info.resolution;
 }
 
 void Motor::set_motion_params(float limit_vel, float limit_accel, int limit_trq_percent)
@@ -52,7 +71,7 @@ void Motor::set_motion_params(float limit_vel, float limit_accel, int limit_trq_
 	m_node->Motion.VelLimit.Value(limit_vel);
 	m_node->Motion.AccLimit.Value(limit_accel);
 	m_node->Motion.JrkLimit.Value(jerk_limit);
-	m_node->Limits.PosnTrackingLimit.Value(m_node->Info.PositioningResolution.Value() / 4);
+	m_node->Limits.PosnTrackingLimit.Value(uint32_t(get_resolution() / 4));
 	m_node->Limits.TrqGlobal.Value(limit_trq_percent);
 
 	m_node->Motion.TrqMeasured.AutoRefresh(true);
@@ -67,6 +86,7 @@ void Motor::enable()
 		m_node->Status.AlertsClear();
 		m_node->Motion.NodeStop(STOP_TYPE_ABRUPT);
 		m_node->Motion.NodeStop(STOP_TYPE_CLR_ALL);
+		m_stream.reset();
 
 		// Enable the node
 		m_node->EnableReq(true);
@@ -109,14 +129,94 @@ void Motor::stop(nodeStopCodes stop_type)
 	m_node->Motion.NodeStop(stop_type);
 	m_node->Motion.MoveVelStart(0);			// ensure stop by setting velocity to zero
 	m_node->Motion.MoveVelStart(0);
+	m_stream.reset();
 	m_node->Status.RT.Refresh();
 }
 
+/**
+ * @brief Tracks the node's move buffer from its Move Command Complete attentions, instead of polling it.
+ * The port's attentions must be enabled, with MotionStream::on_attention as the handler.
+ */
+void Motor::setup_stream()
+{
+	mnStatusReg mask;
+	mask.cpm.MoveCmdComplete = 1;
+	try {
+		LinkMonitor::Transaction transaction(m_link);
+		m_node->Adv.Attn.Mask = mask;
+		m_stream.setup(m_node->Port.NetNumber(), m_node->Info.Ex.Addr());
+	}
+	catch (mnErr& theErr) {
+		ofLogWarning("Motor::setup_stream") << "Motor " << ofToString(int(m_node->Info.Ex.Addr())) << " can't send attentions, polling its move buffer instead: " << theErr.ErrorMsg;
+	}
+}
+
+/**
+ * @brief E-Stops every node on this motor's port with one broadcast command.
+ * Future motion is blocked until each node's E-Stop is cleared.
+ *
+ * @param (nodeStopCodes)  stop_type: defaults to STOP_TYPE_ESTOP_ABRUPT
+ */
+void Motor::group_stop(nodeStopCodes stop_type)
+{
+	LinkMonitor::Transaction transaction(m_link);
+	m_node->Motion.GroupNodeStop(stop_type);
+	MotionStream::reset_port(m_node->Port.NetNumber());
+}
+
+/**
+ * @brief Programs the node's own position and torque limits, so it enforces them without the host.
+ * Soft limits only take effect once the node is homed. Torque foldback needs an Advanced node.
+ *
+ * @param (int)  position_min: lower soft limit (counts)
+ * @param (int)  position_max: upper soft limit (counts)
+ * @param (float)  torque_min: negative torque limit (% of max)
+ * @param (float)  torque_max: positive torque limit (% of max)
+ */
+void Motor::set_hardware_limits(int position_min, int position_max, float torque_min, float torque_max)
+{
+	LinkMonitor::Transaction transaction(m_link);
+	m_node->TrqUnit(INode::PCT_MAX);
+	m_node->Limits.SoftLimit1.Value(position_min);
+	m_node->Limits.SoftLimit2.Value(position_max);
+	try {
+		// the negative limit is a magnitude
+		m_node->Limits.Adv.PositiveTrq.Value(torque_max);
+		m_node->Limits.Adv.NegativeTrq.Value(abs(torque_min));
+		m_node->Limits.Adv.StartPosFoldback(true);
+		m_node->Limits.Adv.StartNegFoldback(true);
+	}
+	catch (mnErr& theErr) {
+		ofLogWarning("Motor::set_hardware_limits") << "Motor " << ofToString(m_node->Info.Ex.Addr()) << " does not support torque foldback: " << theErr.ErrorMsg;
+	}
+}
+
+/**
+ * @brief Makes any shutdown on this node (tracking, overload, soft limit...) group stop every node on its port.
+ *
+ * @param (nodeStopCodes)  stop_type: how every node on the port stops. Defaults to STOP_TYPE_ESTOP_ABRUPT
+ */
+void Motor::arm_group_shutdown(nodeStopCodes stop_type)
+{
+	// shutdowns all raise an alert
+	mnStatusReg mask;
+	mask.cpm.AlertPresent = 1;
+
+	ShutdownInfo info;
+	info.enabled = true;
+	info.theStopType = stop_type;
+	info.statusMask = mask;
+
+	LinkMonitor::Transaction transaction(m_link);
+	m_node->Port.GrpShutdown.ShutdownWhen(m_node->Info.Ex.Addr(), info);
+}
+
 void Motor::set_e_stop(bool val)
 {
 	if (val) {
 		ofLogNotice("Motor::set_e_stop") << "Triggering E-Stop for Motor " << ofToString(m_node->Info.Ex.Addr()) << ".";
 		m_node->Motion.NodeStop(STOP_TYPE_ESTOP_ABRUPT);
+		m_stream.reset();
 	}
 	// Clear the E-Stop
 	else {
@@ -126,6 +226,7 @@ void Motor::set_e_stop(bool val)
 		if (m_node->Status.Alerts.Value().cpm.Common.EStopped) {
 			ofLogNotice("Motor::clearMotionStop") << "Clearing E-Stop for Motor " << ofToString(m_node->Info.Ex.Addr()) << ".";
 			m_node->Motion.NodeStopClear();
+			m_stream.reset();
 		}
 		else {
 			ofLogNotice("Motor::clearMotionStop") << "Motor " << ofToString(m_node->Info.Ex.Addr()) << " is not E-Stopped.";
@@ -150,17 +251,18 @@ void Motor::set_enabled(bool val)
  * 
  * @param (bool)  get_actual_pos: returns the current actual position if true, the target position if false. True by default.
  * 
- * @return (int) motor position (in counts) 
+ * @return (int64_t) motor position (in counts), continuous across wraps of the node's position register
  */
-int Motor::get_position(bool get_actual_pos)
+int64_t Motor::get_position(bool get_actual_pos)
 {
+	LinkMonitor::Transaction transaction(m_link);
 	if (get_actual_pos) {
 		m_node->Motion.PosnMeasured.Refresh();
-		return int64_t(m_node->Motion.PosnMeasured.Value());
+		return m_posn_measured.update(m_node->Motion.PosnMeasured.Value());
 	}
 	else {
 		m_node->Motion.PosnCommanded.Refresh();
-		return int64_t(m_node->Motion.PosnCommanded.Value());
+		return m_posn_commanded.update(m_node->Motion.PosnCommanded.Value());
 	}
 }
 
@@ -204,6 +306,16 @@ float Motor::get_acceleration()
 	return m_node->Motion.AccLimit.Value();
 }
 
+/**
+ * @brief Get the measured torque.
+ *
+ * @return (float)  torque (% of max)
+ */
+float Motor::get_torque()
+{
+	return m_node->Motion.TrqMeasured.Value();
+}
+
 /**
  * @brief Set the desired acceleration.
  * 
@@ -223,21 +335,46 @@ void Motor::set_acceleration(float val)
  */
 void Motor::move_position(int target_pos, bool is_absolute, bool add_dwell)
 {
+	LinkMonitor::Transaction transaction(m_link);
 	m_node->Motion.MovePosnStart(target_pos, is_absolute, add_dwell);
 }
 
 void Motor::move_velocity(float target_vel)
-{		
-	// check that there is space in the motor's move buffer & then send vel command
-	m_node->Status.RT.Refresh();
-	if (m_node->Status.RT.Value().cpm.MoveBufAvail) {
-		// filter out smalled changes
-		float epsilon = 0.01;	
-		if (abs(target_vel - get_velocity_actual()) >  epsilon)
-			m_node->Motion.MoveVelStart(target_vel);
+{
+	// the newest command supersedes any that is still waiting for room in the node's buffer
+	m_stream.push(target_vel);
+
+	// without attentions (or after missing one) read the buffer state instead
+	if (!m_stream.is_attention_enabled() || m_stream.is_stalled()) {
+		{
+			LinkMonitor::Transaction transaction(m_link);
+			m_node->Status.RT.Refresh();
+		}
+		bool is_available = m_node->Status.RT.Value().cpm.MoveBufAvail;
+		m_stream.resync(is_available ? m_stream.target_depth - 1 : m_stream.target_depth);
+		if (!is_available && m_link != nullptr)
+			m_link->buffer_full++;
 	}
-	else {
-		ofLogNotice(__FUNCTION__) << "Motor " << ofToString(int(m_node->Info.Ex.Addr())) << ": Move Buffer Full. TimeStamp: " << ofGetElapsedTimeMillis() << endl;
+
+	if (m_stream.is_ready()) {
+		float rpm = m_stream.take();
+		// MoveVelStart blocks until the node responds, so this brackets the round trip on the link
+		LatencyTrace::mark(LatencyTrace::CMD_SUBMIT);
+		try {
+			LinkMonitor::Transaction transaction(m_link);
+			m_node->Motion.MoveVelStart(rpm);
+			m_rejecting = false;
+		}
+		catch (mnErr& theErr) {
+			// hold the command for the next tick instead of dropping it
+			m_stream.on_rejected(rpm);
+			if (m_link != nullptr)
+				m_link->buffer_full++;
+			if (!m_rejecting)
+				ofLogWarning(__FUNCTION__) << "Motor " << ofToString(int(m_node->Info.Ex.Addr())) << ": command refused, holding it for retry: " << theErr.ErrorMsg;
+			m_rejecting = true;
+		}
+		LatencyTrace::mark(LatencyTrace::CMD_RESPONSE);
 	}
 	if (target_vel == 0) {
 		ofLogNotice(__FUNCTION__) << "stopping due to 0 RPM." << endl;
@@ -275,12 +412,12 @@ bool Motor::run_homing_routine(int _timeout)
 		enable();
 	}
 	// set a timeout(ms) in case the node is unable to home
-	double timeout = m_sysMgr.TimeStampMsec() + (_timeout * 1000);	
+	double timeout = m_sysMgr->TimeStampMsec() + (_timeout * 1000);	
 
 	cout << "Initiating homing. Timeout in " << _timeout << " seconds." << endl;
 	m_node->Motion.Homing.Initiate();
 	while (!m_node->Motion.Homing.WasHomed()) {
-		if (m_sysMgr.TimeStampMsec() > timeout) {
+		if (m_sysMgr->TimeStampMsec() > timeout) {
 			printf("Node did not complete homing:  \n\t -Ensure Homing settings have been defined through ClearView. \n\t -Check for alerts/Shutdowns \n\t -Ensure timeout is longer than the longest possible homing move.\n");
 			return false;
 		}
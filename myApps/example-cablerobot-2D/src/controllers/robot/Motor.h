@@ -3,6 +3,10 @@
 #include "ofMain.h"
 #include <time.h>
 #include "pubSysCls.h"
+#include "NodeInventory.h"
+#include "LinkMonitor.h"
+#include "MotionStream.h"
+#include "CablePosition.h"
 
 using namespace sFnd;
 
@@ -10,37 +14,57 @@ class Motor // Only for Clearpath-SC Motor
 {
 private:
     INode* m_node;				
-    SysManager& m_sysMgr;
+    SysManager* m_sysMgr;
+    NodeInfo m_info;            // static Info fields, read once at startup
+    LinkMonitor::Node* m_link = nullptr;
+    MotionStream m_stream;      // paces velocity commands against the node's move buffer
+    bool m_rejecting = false;   // logs only the first of a run of refused commands
+    PositionUnwrap m_posn_measured;     // 64-bit positions across register wraps
+    PositionUnwrap m_posn_commanded;
 
 public:
     Motor(SysManager& SysMgr, INode* node);
-    ~Motor();
+    Motor(SysManager& SysMgr, INode* node, NodeInfo info);
+    virtual ~Motor();
 
     INode* get() { return m_node; };
+    NodeInfo get_info() { return m_info; }
     int get_resolution();
+    int get_serial_number() { return m_info.serial_number; }
+    int get_address() { return m_info.address; }
+    void set_link_monitor(LinkMonitor::Node* link) { m_link = link; }
+    void setup_stream();
+    MotionStream* get_stream() { return &m_stream; }
 
-    void set_motion_params(float limit_vel=200, float limit_accel=400, int limit_trq_percent=100);
-    void enable();
-    void disable();
-    void stop(nodeStopCodes stop_type=STOP_TYPE_ABRUPT);
-    void set_e_stop(bool val);
-    void set_enabled(bool val);
+    virtual void set_motion_params(float limit_vel=200, float limit_accel=400, int limit_trq_percent=100);
+    virtual void enable();
+    virtual void disable();
+    virtual void stop(nodeStopCodes stop_type=STOP_TYPE_ABRUPT);
+    virtual void group_stop(nodeStopCodes stop_type=STOP_TYPE_ESTOP_ABRUPT);
+    virtual void set_hardware_limits(int position_min, int position_max, float torque_min, float torque_max);
+    virtual void arm_group_shutdown(nodeStopCodes stop_type=STOP_TYPE_ESTOP_ABRUPT);
+    virtual void set_e_stop(bool val);
+    virtual void set_enabled(bool val);
 
-    int get_position(bool get_actual_pos=true);
+    virtual int64_t get_position(bool get_actual_pos=true);
 
-    float get_velocity();
-    float get_velocity_actual();
-    void set_velocity(float val);
-    float get_acceleration();
-    void set_acceleration(float val);
+    virtual float get_velocity();
+    virtual float get_velocity_actual();
+    virtual void set_velocity(float val);
+    virtual float get_acceleration();
+    virtual void set_acceleration(float val);
+    virtual float get_torque();
 
-    void move_position(int target_pos, bool is_absolute, bool add_dwell=false);
-    void move_velocity(float target_vel);
+    virtual void move_position(int target_pos, bool is_absolute, bool add_dwell=false);
+    virtual void move_velocity(float target_vel);
 
-    bool is_estopped();
-    bool is_homed();
-    bool is_enabled();
-    bool is_moving();
+    virtual bool is_estopped();
+    virtual bool is_homed();
+    virtual bool is_enabled();
+    virtual bool is_moving();
 
-    bool run_homing_routine(int _timeout=20);
+    virtual bool run_homing_routine(int _timeout=20);
+
+protected:
+    Motor(NodeInfo info);       // for motors without a node (see VirtualMotor)
 };
\ No newline at end of file
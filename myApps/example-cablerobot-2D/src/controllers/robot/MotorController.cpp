@@ -10,6 +10,19 @@ MotorController::MotorController(SysManager& SysMgr, INode* node)
 	motor = new Motor(SysMgr, node);
 }
 
+MotorController::MotorController(SysManager& SysMgr, INode* node, NodeInfo info)
+{
+	motor = new Motor(SysMgr, node, info);
+}
+
+/**
+ * @brief Wraps a motor that was created elsewhere (e.g. a VirtualMotor).
+ */
+MotorController::MotorController(Motor* motor)
+{
+	this->motor = motor;
+}
+
 MotorController::~MotorController()
 {
 }
@@ -19,5 +32,5 @@ Motor* MotorController::get_motor() {
 }
 
 int MotorController::get_motor_id() {
-	return int(motor->get()->Info.Ex.Addr());
+	return motor->get_address();
 }
\ No newline at end of file
@@ -33,6 +33,8 @@ private:
 public:
 	MotorController();
     MotorController(SysManager& SysMgr, INode* node);
+    MotorController(SysManager& SysMgr, INode* node, NodeInfo info);
+    MotorController(Motor* motor);
 	~MotorController();
 	bool initialize();
 	void update();
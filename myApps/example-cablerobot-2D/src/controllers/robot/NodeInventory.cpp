@@ -0,0 +1,171 @@
+#include "NodeInventory.h"
+#include <future>
+
+/**
+ * @brief Loads the cached inventory from a file.
+ *
+ * @param (string)  filename: file in the local /bin/data folder (must end in .xml).
+ * @return (bool)  True if the file was loaded.
+ */
+bool NodeInventory::load(string filename)
+{
+	ofxXmlSettings file;
+	if (!file.loadFile(filename)) {
+		ofLogNotice(__FUNCTION__) << "No node inventory found at: /bin/data/" << filename << ". Running full discovery.";
+		return false;
+	}
+
+	nodes.clear();
+	file.pushTag("inventory");
+	int count = file.getNumTags("node");
+	for (int i = 0; i < count; i++) {
+		file.pushTag("node", i);
+		NodeInfo info;
+		info.port = file.getValue("port", -1);
+		info.address = file.getValue("address", -1);
+		info.serial_number = file.getValue("serial_number", 0);
+		info.node_type = file.getValue("node_type", 0);
+		info.user_id = file.getValue("user_id", "");
+		info.firmware_version = file.getValue("firmware_version", "");
+		info.model = file.getValue("model", "");
+		info.resolution = file.getValue("resolution", 0);
+		info.cached = true;
+		nodes[get_key(info.port, info.serial_number)] = info;
+		file.popTag();
+	}
+	file.popTag();
+
+	ofLogNotice(__FUNCTION__) << "Loaded " << nodes.size() << " cached nodes from: " << filename;
+	return true;
+}
+
+/**
+ * @brief Saves the inventory of every node seen so far.
+ *
+ * @param (string)  filename: file saved to local /bin/data folder (must end in .xml).
+ * @return (bool)  True if the file was saved.
+ */
+bool NodeInventory::save(string filename)
+{
+	ofxXmlSettings file;
+	file.addTag("inventory");
+	file.pushTag("inventory");
+	file.addValue("timestamp", ofGetTimestampString());
+	int i = 0;
+	for (auto& entry : nodes) {
+		auto& info = entry.second;
+		file.addTag("node");
+		file.pushTag("node", i++);
+		file.addValue("port", info.port);
+		file.addValue("address", info.address);
+		file.addValue("serial_number", info.serial_number);
+		file.addValue("node_type", info.node_type);
+		file.addValue("user_id", info.user_id);
+		file.addValue("firmware_version", info.firmware_version);
+		file.addValue("model", info.model);
+		file.addValue("resolution", info.resolution);
+		file.popTag();
+	}
+	file.popTag();
+
+	changed = !file.saveFile(filename);
+	return !changed;
+}
+
+/**
+ * @brief Reads the static Info of every node on every open port.
+ * Each port is read on its own thread.
+ *
+ * @param (SysManager&)  mgr: system manager (ports must already be open)
+ * @param (int)  port_count: number of open ports
+ */
+void NodeInventory::read_ports(SysManager& mgr, int port_count)
+{
+	vector<std::future<vector<NodeInfo>>> reads;
+	for (int i = 0; i < port_count; i++) {
+		IPort& myPort = mgr.Ports(i);
+		reads.push_back(std::async(std::launch::async, &NodeInventory::read_port, this, i, std::ref(myPort)));
+	}
+
+	// join every port before touching the cache: the other reads are still looking it up
+	ports.clear();
+	for (auto& read : reads)
+		ports.push_back(read.get());
+
+	num_cached = 0;
+	for (auto& port : ports) {
+		for (auto& info : port) {
+			if (info.cached)
+				num_cached++;
+			else
+				changed = true;
+			nodes[get_key(info.port, info.serial_number)] = info;
+		}
+	}
+}
+
+/**
+ * @brief Returns the static Info of a node found by read_ports().
+ *
+ * @param (int)  port: port index
+ * @param (int)  address: node address on the port
+ * @return (NodeInfo)  the node's Info, or a default NodeInfo if it wasn't found.
+ */
+NodeInfo NodeInventory::get(int port, int address)
+{
+	if (port < ports.size() && address < ports[port].size())
+		return ports[port][address];
+	ofLogWarning(__FUNCTION__) << "No inventory for node " << address << " on port " << port << ".";
+	return NodeInfo();
+}
+
+/**
+ * @brief Reads the static Info fields of a node directly from the network.
+ */
+NodeInfo NodeInventory::read_node(int port, INode& node)
+{
+	NodeInfo info;
+	info.port = port;
+	info.address = node.Info.Ex.Addr();
+	info.serial_number = node.Info.SerialNumber.Value();
+	info.node_type = node.Info.NodeType();
+	info.user_id = node.Info.UserID.Value();
+	info.firmware_version = node.Info.FirmwareVersion.Value();
+	info.model = node.Info.Model.Value();
+	info.resolution = node.Info.PositioningResolution.Value();
+	return info;
+}
+
+/**
+ * @brief Validates the cached nodes on one port, and reads the full Info of any node that isn't cached.
+ * Runs on its own thread: only touches this port's nodes and the cache, which
+ * read_ports doesn't update until every port's read has finished.
+ */
+vector<NodeInfo> NodeInventory::read_port(int port, IPort& myPort)
+{
+	vector<NodeInfo> found;
+	for (size_t j = 0; j < myPort.NodeCount(); j++) {
+		INode& node = myPort.Nodes(j);
+		// the serial number validates the cache; the resolution is re-read below
+		int serial_number = node.Info.SerialNumber.Value();
+		auto it = nodes.find(get_key(port, serial_number));
+		if (it != nodes.end() && it->second.address == node.Info.Ex.Addr()) {
+			NodeInfo info = it->second;
+			info.resolution = node.Info.PositioningResolution.Value();
+			if (info.resolution != it->second.resolution) {
+				ofLogWarning(__FUNCTION__) << "Resolution of node " << info.address << " on port " << port << " changed from " << it->second.resolution << " to " << info.resolution << ".";
+				info.cached = false;	// so the inventory file is rewritten
+			}
+			found.push_back(info);
+		}
+		else {
+			found.push_back(read_node(port, node));
+		}
+	}
+	return found;
+}
+
+string NodeInventory::get_key(int port, int serial_number)
+{
+	return ofToString(port) + ":" + ofToString(serial_number);
+}
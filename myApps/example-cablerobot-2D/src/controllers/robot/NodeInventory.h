@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxXmlSettings.h"
+#include "pubSysCls.h"
+
+using namespace sFnd;
+
+/**
+ * @brief Static (never changing) Info fields of one ClearPath node.
+ */
+struct NodeInfo {
+	int port = -1;				// SC Hub port index
+	int address = -1;			// node address on the port
+	int serial_number = 0;
+	int node_type = 0;
+	string user_id;
+	string firmware_version;
+	string model;
+	int resolution = 0;			// counts per revolution (set in ClearView, so re-read every start)
+	bool cached = false;		// true if restored from the inventory file
+};
+
+/**
+ * @brief Cached inventory of the nodes on every SC Hub port, keyed by port and serial number.
+ *
+ * On a warm restart only each node's serial number and positioning resolution
+ * are read; the rest of the static Info fields come from the inventory file.
+ * The resolution can be changed in ClearView without the serial changing, and
+ * it sets the mm per count, so it's never trusted from the cache.
+ * Ports are read in parallel, since each one is its own serial link.
+ */
+class NodeInventory
+{
+public:
+	bool load(string filename = "node_inventory.xml");
+	bool save(string filename = "node_inventory.xml");
+
+	void read_ports(SysManager& mgr, int port_count);
+	NodeInfo get(int port, int address);
+	int get_num_cached() { return num_cached; }
+	bool is_changed() { return changed; }
+
+	static NodeInfo read_node(int port, INode& node);
+
+private:
+	map<string, NodeInfo> nodes;		// every node we've seen, keyed by port and serial
+	vector<vector<NodeInfo>> ports;		// nodes found on the open ports (by address)
+	int num_cached = 0;
+	bool changed = false;
+
+	vector<NodeInfo> read_port(int port, IPort& myPort);
+	static string get_key(int port, int serial_number);
+};
@@ -0,0 +1,452 @@
+#include "RigConfig.h"
+#include "ofxXmlSettings.h"
+#include <set>
+
+RigConfig::~RigConfig()
+{
+	close();
+}
+
+/**
+ * @brief Loads the config store.
+ *
+ * Records written by an older version are migrated by copying the fields they
+ * have and leaving any newer fields at their defaults.
+ *
+ * @param (string)  filename: file in the local /bin/data folder. Defaults to "rig_config.bin"
+ * @return (bool)  True if the store was loaded.
+ */
+bool RigConfig::load(string filename)
+{
+	ofFile file(filename, ofFile::ReadOnly, true);
+	if (!file.exists()) {
+		ofLogNotice(__FUNCTION__) << "No config store found at: /bin/data/" << filename << ". Robots will be migrated from their XML files.";
+		return false;
+	}
+
+	ofBuffer buffer = file.readToBuffer();
+	Header header;
+	if (buffer.size() < sizeof(Header)) {
+		ofLogError(__FUNCTION__) << "Config store is too short: " << filename;
+		return false;
+	}
+	memcpy(&header, buffer.getData(), sizeof(Header));
+	if (strncmp(header.magic, "KFRC", 4) != 0 || header.version > VERSION) {
+		ofLogError(__FUNCTION__) << "Unsupported config store (version " << header.version << "): " << filename;
+		return false;
+	}
+	if (buffer.size() < sizeof(Header) + header.count * header.record_size) {
+		ofLogError(__FUNCTION__) << "Config store is truncated: " << filename;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	records.assign(header.count, RobotConfig());
+	index.clear();
+	const char* data = buffer.getData() + sizeof(Header);
+	size_t size = MIN(header.record_size, sizeof(RobotConfig));
+	for (int i = 0; i < header.count; i++) {
+		memcpy(&records[i], data + i * header.record_size, size);
+		index[records[i].serial_number] = i;
+	}
+
+	ofLogNotice(__FUNCTION__) << "Loaded " << records.size() << " robot configs (version " << header.version << ") from: " << filename;
+	return true;
+}
+
+/**
+ * @brief Saves a snapshot of the store on the background writer.
+ * Replaces any snapshot of the same file the writer hasn't started on yet.
+ *
+ * @param (string)  filename: file saved to local /bin/data folder. Defaults to "rig_config.bin"
+ */
+void RigConfig::save(string filename)
+{
+	vector<RobotConfig> snapshot;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		snapshot = records;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_writer);
+	if (closing) {
+		ofLogWarning(__FUNCTION__) << "Config store is closed, not saving: " << filename;
+		return;
+	}
+	saves_pending[filename] = std::move(snapshot);
+	if (!writer.joinable())
+		writer = std::thread(&RigConfig::run_writer, this);
+	cv_writer.notify_one();
+}
+
+/**
+ * @brief Finishes any pending save and stops the background writer.
+ * Call on shutdown, so the process never exits in the middle of a write.
+ */
+void RigConfig::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_writer);
+		closing = true;
+	}
+	cv_writer.notify_one();
+	if (writer.joinable())
+		writer.join();
+}
+
+/**
+ * @brief Background writer: writes the latest snapshot of each file until closed.
+ */
+void RigConfig::run_writer()
+{
+	std::unique_lock<std::mutex> lock(mutex_writer);
+	while (true) {
+		cv_writer.wait(lock, [this] { return closing || !saves_pending.empty(); });
+		if (saves_pending.empty())
+			return;		// closing, and everything is written
+
+		auto it = saves_pending.begin();
+		string filename = it->first;
+		vector<RobotConfig> snapshot = std::move(it->second);
+		saves_pending.erase(it);
+
+		// save() can queue a newer snapshot while this one is written
+		lock.unlock();
+		write(filename, snapshot);
+		lock.lock();
+	}
+}
+
+/**
+ * @brief Checks that a config is safe to push to a running robot: a missing or
+ * mistyped field would otherwise reach the motors as 0.
+ *
+ * @param (string&)  error: set to the first problem found
+ * @return (bool)  True if the config is valid.
+ */
+bool RobotConfig::validate(string& error) const
+{
+	if (!(drum_diameter > 0))
+		error = "drum_diameter must be > 0";
+	else if (!(cable_diameter > 0))
+		error = "cable_diameter must be > 0";
+	else if (!(cable_scale > 0))
+		error = "cable_scale must be > 0";
+	else if (!(bounds_min < bounds_max))
+		error = "bounds_min must be < bounds_max";
+	else if (!(vel_limit > 0) || !(accel_limit > 0))
+		error = "vel_limit and accel_limit must be > 0";
+	else if (!(torque_max > 0) || !(torque_min < torque_max))
+		error = "torque_max must be > 0 and > torque_min";
+	else
+		return true;
+	error = "robot " + ofToString(serial_number) + ": " + error;
+	return false;
+}
+
+/**
+ * @brief Writes the store as a human-readable text file.
+ * Edits to this file are picked up live by the RigConfigWatcher. The file is written
+ * to a temporary file and renamed over the old one, so the watcher never reads it half-written.
+ *
+ * @param (string)  filename: file saved to local /bin/data folder. Defaults to "rig_config.txt"
+ * @return (bool)  True if the file was written.
+ */
+bool RigConfig::export_text(string filename)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	string path = ofToDataPath(filename, true);
+	string path_tmp = path + ".tmp";
+	std::ofstream file(path_tmp, std::ios::trunc);
+	if (!file.is_open()) {
+		ofLogError(__FUNCTION__) << "Could not open " << path_tmp;
+		return false;
+	}
+
+	auto vec = [](const float* v) { return ofToString(v[0]) + ", " + ofToString(v[1]) + ", " + ofToString(v[2]); };
+
+	file << "# rig config, version " << VERSION << ", exported " << ofGetTimestampString() << "\n";
+	for (auto& config : records) {
+		file << "\n[robot " << config.serial_number << "]\n";
+		file << "motor_id = " << config.motor_id << "\n";
+		file << "auto_home = " << config.auto_home << "\n";
+		file << "base = " << vec(config.base) << "\n";
+		file << "tangent = " << vec(config.tangent) << "\n";
+		file << "target = " << vec(config.target) << "\n";
+		file << "vel_limit = " << config.vel_limit << "\n";
+		file << "accel_limit = " << config.accel_limit << "\n";
+		file << "bounds_min = " << config.bounds_min << "\n";
+		file << "bounds_max = " << config.bounds_max << "\n";
+		file << "bounds_shutdown = " << config.bounds_shutdown << "\n";
+		file << "torque_min = " << config.torque_min << "\n";
+		file << "torque_max = " << config.torque_max << "\n";
+		file << "jog_vel = " << config.jog_vel << "\n";
+		file << "jog_accel = " << config.jog_accel << "\n";
+		file << "drum_direction = " << config.drum_direction << "\n";
+		file << "drum_diameter = " << config.drum_diameter << "\n";
+		file << "drum_tangent = " << vec(config.drum_tangent) << "\n";
+		file << "drum_length = " << config.drum_length << "\n";
+		file << "drum_turns = " << config.drum_turns << "\n";
+		file << "cable_diameter = " << config.cable_diameter << "\n";
+		file << "guide_distance = " << config.guide_distance << "\n";
+		file << "guide_offset = " << config.guide_offset << "\n";
+		file << "cable_scale = " << config.cable_scale << "\n";
+		file << "cable_compliance = " << config.cable_compliance << "\n";
+		file << "cable_stretch_home = " << config.cable_stretch_home << "\n";
+	}
+	file.close();
+	if (!file.good()) {
+		ofLogError(__FUNCTION__) << "Could not write " << path_tmp;
+		return false;
+	}
+
+	std::error_code err;
+	std::filesystem::rename(path_tmp, path, err);
+	if (err) {
+		ofLogError(__FUNCTION__) << "Could not replace " << path << ": " << err.message();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Reads robot configs from a text file written by export_text().
+ * Every robot's section must set every field: a file that's half-written or missing
+ * a field is rejected as a whole, rather than defaulting the field to 0.
+ *
+ * @param (string)  filename: file in the local /bin/data folder
+ * @param (vector<RobotConfig>&)  configs: filled with one config per [robot <serial>] section
+ * @return (bool)  True if the file was read and every section is complete.
+ */
+bool RigConfig::import_text(string filename, vector<RobotConfig>& configs)
+{
+	ofBuffer buffer = ofBufferFromFile(filename);
+	if (buffer.size() == 0)
+		return false;
+
+	static const vector<string> keys = {
+		"motor_id", "auto_home", "base", "tangent", "target",
+		"vel_limit", "accel_limit", "bounds_min", "bounds_max", "bounds_shutdown", "torque_min", "torque_max",
+		"jog_vel", "jog_accel",
+		"drum_direction", "drum_diameter", "drum_tangent", "drum_length", "drum_turns",
+		"cable_diameter", "guide_distance", "guide_offset",
+		"cable_scale", "cable_compliance", "cable_stretch_home"
+	};
+	vector<std::set<string>> found;		// keys read for each robot
+
+	configs.clear();
+	for (auto line : buffer.getLines()) {
+		line = ofTrim(line);
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		if (line[0] == '[') {
+			auto tokens = ofSplitString(line.substr(1, line.find(']') - 1), " ", true, true);
+			if (tokens.size() == 2 && tokens[0] == "robot") {
+				configs.push_back(RobotConfig());
+				configs.back().serial_number = ofToInt(tokens[1]);
+				found.push_back(std::set<string>());
+			}
+			continue;
+		}
+
+		auto pair = ofSplitString(line, "=", true, true);
+		if (configs.empty() || pair.size() != 2)
+			continue;
+		string key = pair[0];
+		vector<float> vals;
+		for (auto& val : ofSplitString(pair[1], ",", true, true))
+			vals.push_back(ofToFloat(val));
+		if (vals.empty())
+			continue;
+
+		auto& config = configs.back();
+		auto set_vec = [&vals](float* v) {
+			for (int i = 0; i < 3 && i < vals.size(); i++)
+				v[i] = vals[i];
+		};
+		bool is_vec = key == "base" || key == "tangent" || key == "target" || key == "drum_tangent";
+		if (is_vec && vals.size() != 3) {
+			ofLogWarning(__FUNCTION__) << "Robot " << config.serial_number << ": \"" << key << "\" needs 3 values in " << filename;
+			continue;
+		}
+		if (std::find(keys.begin(), keys.end(), key) != keys.end())
+			found.back().insert(key);
+		if (key == "motor_id") config.motor_id = vals[0];
+		else if (key == "auto_home") config.auto_home = vals[0];
+		else if (key == "base") set_vec(config.base);
+		else if (key == "tangent") set_vec(config.tangent);
+		else if (key == "target") set_vec(config.target);
+		else if (key == "vel_limit") config.vel_limit = vals[0];
+		else if (key == "accel_limit") config.accel_limit = vals[0];
+		else if (key == "bounds_min") config.bounds_min = vals[0];
+		else if (key == "bounds_max") config.bounds_max = vals[0];
+		else if (key == "bounds_shutdown") config.bounds_shutdown = vals[0];
+		else if (key == "torque_min") config.torque_min = vals[0];
+		else if (key == "torque_max") config.torque_max = vals[0];
+		else if (key == "jog_vel") config.jog_vel = vals[0];
+		else if (key == "jog_accel") config.jog_accel = vals[0];
+		else if (key == "drum_direction") config.drum_direction = vals[0];
+		else if (key == "drum_diameter") config.drum_diameter = vals[0];
+		else if (key == "drum_tangent") set_vec(config.drum_tangent);
+		else if (key == "drum_length") config.drum_length = vals[0];
+		else if (key == "drum_turns") config.drum_turns = vals[0];
+		else if (key == "cable_diameter") config.cable_diameter = vals[0];
+		else if (key == "guide_distance") config.guide_distance = vals[0];
+		else if (key == "guide_offset") config.guide_offset = vals[0];
+		else if (key == "cable_scale") config.cable_scale = vals[0];
+		else if (key == "cable_compliance") config.cable_compliance = vals[0];
+		else if (key == "cable_stretch_home") config.cable_stretch_home = vals[0];
+		else
+			ofLogWarning(__FUNCTION__) << "Unknown key \"" << key << "\" in " << filename;
+	}
+
+	for (int i = 0; i < configs.size(); i++) {
+		for (auto& key : keys) {
+			if (found[i].count(key) == 0) {
+				ofLogWarning(__FUNCTION__) << "Robot " << configs[i].serial_number << " is missing \"" << key << "\" in " << filename;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Looks up a robot's config by serial number.
+ * Robots that aren't in the store yet are migrated from their legacy XML file.
+ *
+ * @param (int)  serial_number: motor serial number
+ * @param (RobotConfig&)  config: filled with the robot's config
+ * @return (bool)  True if a config was found.
+ */
+bool RigConfig::get(int serial_number, RobotConfig& config)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = index.find(serial_number);
+		if (it != index.end()) {
+			config = records[it->second];
+			return true;
+		}
+	}
+
+	if (import_xml(serial_number, config)) {
+		set(config);
+		return true;
+	}
+	return false;
+}
+
+void RigConfig::set(const RobotConfig& config)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = index.find(config.serial_number);
+	if (it != index.end()) {
+		records[it->second] = config;
+	}
+	else {
+		index[config.serial_number] = records.size();
+		records.push_back(config);
+	}
+}
+
+int RigConfig::size()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return records.size();
+}
+
+/**
+ * @brief Reads a robot's legacy robot_config_<serial>.xml file.
+ *
+ * @param (int)  serial_number: motor serial number
+ * @param (RobotConfig&)  config: filled with the robot's config
+ * @return (bool)  True if the file was found and belongs to this robot.
+ */
+bool RigConfig::import_xml(int serial_number, RobotConfig& config)
+{
+	string filename = "robot_config_" + ofToString(serial_number) + ".xml";
+	ofxXmlSettings xml;
+	if (!xml.loadFile(filename)) {
+		ofLogWarning(__FUNCTION__) << "No config file found at: /bin/data/" << filename;
+		return false;
+	}
+
+	// Check that the serial numbers match
+	int sn = xml.getValue("config:serial_number", 0);
+	if (sn != serial_number) {
+		ofLogWarning(__FUNCTION__) << "Cannot load config file: Wrong serial number. Loaded " << ofToString(sn) << ", but should be " << ofToString(serial_number);
+		return false;
+	}
+
+	config = RobotConfig();
+	config.serial_number = sn;
+	config.motor_id = xml.getValue("config:motor_id", 0);
+	config.auto_home = xml.getValue("config:auto_home", 0);
+
+	// kinematics
+	string axes[3] = { "X", "Y", "Z" };
+	for (int i = 0; i < 3; i++) {
+		config.base[i] = xml.getValue("config:kinematics:base:" + axes[i], 0.0);
+		config.tangent[i] = xml.getValue("config:kinematics:tangent:" + axes[i], 0.0);
+		config.target[i] = xml.getValue("config:kinematics:target:" + axes[i], 0.0);
+	}
+
+	// limits
+	config.vel_limit = xml.getValue("config:limits:vel_limit", 0.0);
+	config.accel_limit = xml.getValue("config:limits:accel_limit", 0.0);
+	config.bounds_min = xml.getValue("config:limits:bounds_min", 0.0);
+	config.bounds_max = xml.getValue("config:limits:bounds_max", 0.0);
+	config.bounds_shutdown = xml.getValue("config:limits:bounds_shutdown", 0.0);
+	config.torque_min = xml.getValue("config:limits:torque_min", 0.0);
+	config.torque_max = xml.getValue("config:limits:torque_max", 0.0);
+
+	// jogging
+	config.jog_vel = xml.getValue("config:jogging:jog_vel", 0.0);
+	config.jog_accel = xml.getValue("config:jogging:jog_accel", 0.0);
+
+	// cable drum (Y and Z of the drum tangent were always loaded from the kinematics tangent)
+	config.drum_direction = xml.getValue("config:cable_drum:direction", 0);
+	config.drum_diameter = xml.getValue("config:cable_drum:diameter_drum", 0.0);
+	config.drum_tangent[0] = xml.getValue("config:cable_drum:tangent:X", 0.0);
+	config.drum_tangent[1] = config.tangent[1];
+	config.drum_tangent[2] = config.tangent[2];
+
+	ofLogNotice(__FUNCTION__) << "Migrated robot " << serial_number << " from: " << filename;
+	return true;
+}
+
+/**
+ * @brief Writes a snapshot to a temporary file, then renames it over the store.
+ * Only called by the writer thread, so writes never overlap.
+ */
+bool RigConfig::write(string filename, const vector<RobotConfig>& snapshot)
+{
+	Header header;
+	memcpy(header.magic, "KFRC", 4);
+	header.version = VERSION;
+	header.count = snapshot.size();
+	header.record_size = sizeof(RobotConfig);
+
+	string path = ofToDataPath(filename, true);
+	string path_tmp = path + ".tmp";
+	{
+		std::ofstream out(path_tmp, std::ios::binary | std::ios::trunc);
+		out.write((const char*)&header, sizeof(Header));
+		out.write((const char*)snapshot.data(), snapshot.size() * sizeof(RobotConfig));
+		out.flush();
+		if (!out.good()) {
+			ofLogError("RigConfig::write") << "Could not write " << path_tmp;
+			return false;
+		}
+	}
+
+	std::error_code err;
+	std::filesystem::rename(path_tmp, path, err);
+	if (err) {
+		ofLogError("RigConfig::write") << "Could not replace " << path << ": " << err.message();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ofMain.h"
+#include <condition_variable>
+
+/**
+ * @brief Per-robot configuration record.
+ * Plain data with a fixed layout, so records are stored and read as a flat array.
+ */
+struct RobotConfig {
+	int32_t serial_number = 0;
+	int32_t motor_id = 0;
+	int32_t auto_home = 0;
+
+	// kinematics (local coordinates)
+	float base[3] = { 0, 0, 0 };
+	float tangent[3] = { 0, 0, 0 };
+	float target[3] = { 0, 0, 0 };
+
+	// limits
+	float vel_limit = 0;
+	float accel_limit = 0;
+	float bounds_min = 0;
+	float bounds_max = 0;
+	float bounds_shutdown = 0;
+	float torque_min = 0;
+	float torque_max = 0;
+
+	// jogging
+	float jog_vel = 0;
+	float jog_accel = 0;
+
+	// cable drum
+	int32_t drum_direction = 0;
+	float drum_diameter = 0;
+	float drum_tangent[3] = { 0, 0, 0 };
+	float drum_length = 30;			// mm of drum axis covered by the groove (version 2)
+	int32_t drum_turns = 30;
+	float cable_diameter = 0.3048;
+	float guide_distance = 0;
+	float guide_offset = 0;
+
+	// cable length compensation, fit by CableLengthModel::fit (version 2)
+	float cable_scale = 1;
+	float cable_compliance = 0;
+	float cable_stretch_home = 0;
+
+	bool validate(string& error) const;
+};
+
+/**
+ * @brief Single versioned configuration store for every robot in the rig.
+ *
+ * The store is one binary file: a small header followed by the RobotConfig
+ * records. Loading is a single read, and each robot's record is found by
+ * serial number in O(1). Saves hand a snapshot to a single writer thread,
+ * which writes it to a temporary file and renames it over the old file, so a
+ * save never leaves a half-written store or blocks the caller. The writer
+ * only keeps the latest snapshot per file, so an older one never lands last,
+ * and close() (or the destructor) finishes the last save before returning.
+ *
+ * If no store exists yet, robots are migrated from their legacy
+ * robot_config_<serial>.xml files on first lookup.
+ *
+ * The text export can be edited by hand: RigConfigWatcher reloads it live.
+ */
+class RigConfig
+{
+public:
+	static const uint32_t VERSION = 2;
+
+	~RigConfig();
+
+	bool load(string filename = "rig_config.bin");
+	void save(string filename = "rig_config.bin");
+	void close();
+	bool export_text(string filename = "rig_config.txt");
+	static bool import_text(string filename, vector<RobotConfig>& configs);
+
+	bool get(int serial_number, RobotConfig& config);
+	void set(const RobotConfig& config);
+	int size();
+
+	static bool import_xml(int serial_number, RobotConfig& config);
+
+private:
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t count;
+		uint32_t record_size;
+	};
+
+	vector<RobotConfig> records;
+	unordered_map<int, int> index;	// serial number -> record
+	std::mutex mutex;
+
+	// single background writer
+	std::thread writer;
+	std::mutex mutex_writer;
+	std::condition_variable cv_writer;
+	map<string, vector<RobotConfig>> saves_pending;	// latest unwritten snapshot, by filename
+	bool closing = false;
+
+	void run_writer();
+	static bool write(string filename, const vector<RobotConfig>& snapshot);
+};
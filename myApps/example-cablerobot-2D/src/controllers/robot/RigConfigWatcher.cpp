@@ -0,0 +1,79 @@
+#include "RigConfigWatcher.h"
+
+RigConfigWatcher::~RigConfigWatcher()
+{
+	waitForThread(true);
+	delete pending.exchange(nullptr);
+}
+
+/**
+ * @brief Starts watching a rig config text file.
+ * The file's current contents are not reloaded, only later changes.
+ *
+ * @param (string)  filename: file in the local /bin/data folder. Defaults to "rig_config.txt"
+ * @param (int)  interval: time between checks (ms)
+ */
+void RigConfigWatcher::start(string filename, int interval)
+{
+	this->filename = filename;
+	this->interval = interval;
+	time_modified = get_time_modified();
+	startThread();
+}
+
+/**
+ * @brief Takes the latest snapshot, if the file changed since the last call.
+ * Lock-free; call once per control tick.
+ *
+ * @return (Snapshot*)  new snapshot (the caller owns it), or nullptr if nothing changed.
+ */
+RigConfigWatcher::Snapshot* RigConfigWatcher::take()
+{
+	if (pending.load(std::memory_order_relaxed) == nullptr)
+		return nullptr;
+	return pending.exchange(nullptr, std::memory_order_acquire);
+}
+
+/**
+ * @brief Marks the file's current contents as already applied, so the watcher doesn't
+ * reload a file the app just exported itself. Call right after writing the file.
+ */
+void RigConfigWatcher::skip_own_write()
+{
+	time_modified = get_time_modified();
+}
+
+void RigConfigWatcher::threadedFunction()
+{
+	while (isThreadRunning()) {
+		int64_t t = get_time_modified();
+		if (t != 0 && t != time_modified) {
+			time_modified = t;
+			auto snapshot = new Snapshot();
+			string error;
+			bool is_valid = RigConfig::import_text(filename, snapshot->robots) && !snapshot->robots.empty();
+			for (int i = 0; is_valid && i < snapshot->robots.size(); i++)
+				is_valid = snapshot->robots[i].validate(error);
+			if (is_valid) {
+				snapshot->time_loaded = ofGetElapsedTimeMillis();
+				ofLogNotice(__FUNCTION__) << "Reloaded " << snapshot->robots.size() << " robot configs from: " << filename;
+				// replace any snapshot the control thread hasn't taken yet
+				delete pending.exchange(snapshot, std::memory_order_release);
+			}
+			else {
+				delete snapshot;
+				ofLogWarning(__FUNCTION__) << "Could not reload: " << filename << (error.empty() ? "" : ". Invalid config for " + error) << ". Keeping the running config.";
+			}
+		}
+		sleep(interval);
+	}
+}
+
+int64_t RigConfigWatcher::get_time_modified()
+{
+	std::error_code err;
+	auto t = std::filesystem::last_write_time(ofToDataPath(filename, true), err);
+	if (err)
+		return 0;
+	return t.time_since_epoch().count();
+}
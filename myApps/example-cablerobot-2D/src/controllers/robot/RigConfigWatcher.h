@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ofMain.h"
+#include "RigConfig.h"
+
+/**
+ * @brief Watches the rig config text file and parses it whenever it changes.
+ *
+ * Each parsed file becomes an immutable snapshot that is handed to the control
+ * thread through a single atomic pointer: the watcher publishes, and the control
+ * thread takes the latest snapshot at the start of its next tick. Neither side
+ * ever waits on the other. A snapshot is only published if every robot's config
+ * is complete and valid, so a half-saved or mistyped file never reaches the motors.
+ */
+class RigConfigWatcher :
+	public ofThread
+{
+public:
+	struct Snapshot {
+		vector<RobotConfig> robots;
+		uint64_t time_loaded = 0;	// ms
+	};
+
+	~RigConfigWatcher();
+
+	void start(string filename = "rig_config.txt", int interval = 250);
+	Snapshot* take();
+	void skip_own_write();
+
+	void threadedFunction();
+
+private:
+	string filename;
+	int interval = 250;			// ms between checks
+	std::atomic<int64_t> time_modified{ 0 };
+	std::atomic<Snapshot*> pending{ nullptr };
+
+	int64_t get_time_modified();
+};
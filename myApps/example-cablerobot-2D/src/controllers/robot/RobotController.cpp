@@ -4,10 +4,12 @@ RobotController::RobotController(int count, float offset_x, float offset_y, floa
 {
 }
 
-RobotController::RobotController(vector<glm::vec3> bases, ofNode* _origin)
+RobotController::RobotController(vector<glm::vec3> bases, ofNode* _origin, bool run_offline)
 {
+	this->run_offline = run_offline;
 	this->bases = bases;
 	this->origin = _origin;
+	this->node_origin = kinematics.add(-1, origin->getGlobalPosition(), origin->getGlobalOrientation());
 	
 	//load_settings();
 
@@ -31,7 +33,9 @@ RobotController::RobotController(vector<glm::vec3> bases, ofNode* _origin)
 	
 
 
-	startThread();
+	// offline controllers are stepped by the app instead (see step)
+	if (!run_offline)
+		startThread();
 }
 
 /**
@@ -65,8 +69,10 @@ void RobotController::save_settings(string filename)
 
 	config.saveFile(filename);
 
+	// the store is written in the background, so this is safe to call mid-show
 	for (auto robot : robots)
-		robot->save_config_to_file();
+		rig_config.set(robot->get_config());
+	rig_config.save();
 }
 
 /**
@@ -96,6 +102,7 @@ void RobotController::load_settings(string filename)
 		float qw = config.getValue("config:origin:QW", 0);
 		origin->setGlobalPosition(x, y, z);
 		origin->setGlobalOrientation(glm::quat(qw, qx, qy, qz));
+		kinematics.set_global_transform(node_origin, origin->getGlobalPosition(), origin->getGlobalOrientation());
 	}
 	else {
 		ofLogWarning("CableRobot::load_settings") << "No settings file found at: /bin/data/" << filename;
@@ -112,6 +119,8 @@ void RobotController::load_settings(string filename)
  */
 bool RobotController::initialize()
 {
+	uint64_t time_start = ofGetElapsedTimeMillis();
+
 	// Create the CPM System Manager
 	myMgr = SysManager::Instance();
 
@@ -145,16 +154,43 @@ bool RobotController::initialize()
 			// Open the port
 			myMgr->PortsOpen(portCount);
 
+			// Load the config store before creating the robots
+			if (load_robots_from_file)
+				rig_config.load();
+			int num_configs = rig_config.size();
+
+			// Read the static Info of every node (validated against the cached inventory)
+			inventory.load();
+			inventory.read_ports(*myMgr, portCount);
+			if (inventory.is_changed())
+				inventory.save();
+
 			// For each motor on the port, create a new CableRobot
 			for (size_t i = 0; i < portCount; i++) {
 				IPort& myPort = myMgr->Ports(i);
 				ofLogNotice("RobotController::initialize") << "\tSTATUS: Port " << myPort.NetNumber() << ", state=" << myPort.OpenState() << ", nodes=" << myPort.NodeCount();
+
+				// Move Command Complete attentions let each motor track its move buffer without polling it
+				try {
+					myPort.Adv.Attn.Enable(true);
+					myPort.Adv.Attn.AttnHandler(MotionStream::on_attention);
+				}
+				catch (mnErr& theErr) {
+					ofLogWarning("RobotController::initialize") << "Port " << i << " can't route attentions, motors will poll their move buffers: " << theErr.ErrorMsg;
+				}
 				
 				// Create each cable robot and set its world position
 				for (size_t j = 0; j < myPort.NodeCount(); j++) {
 					// Store each individual robot, no matter the configuration
 					//if (j==0 || j==4)
-						robots.push_back(new CableRobot(*myMgr, &myPort.Nodes(j), this->load_robots_from_file));
+						robots.push_back(new CableRobot(*myMgr, &myPort.Nodes(j), inventory.get(i, j), this->load_robots_from_file));
+						RobotConfig robot_config;
+						if (load_robots_from_file && rig_config.get(robots.back()->get_serial_number(), robot_config))
+							robots.back()->set_config(robot_config);
+						auto motor = robots.back()->get_motor_controller()->get_motor();
+						motor->set_link_monitor(link_monitor.add(i, motor->get(), motor->get_serial_number()));
+						if (myPort.Adv.Attn.Enabled())
+							motor->setup_stream();
 					//if (system_config == Configuration::ONE_D) {
 					//	// configure for 1D application
 					//	robots.back()->configure(origin, bases[j]);
@@ -172,23 +208,24 @@ bool RobotController::initialize()
 
 
 
-			//if (j % 2 != 0) {
-				// CHANGE REAL WORLD POSITIONS IN THE COFIG FILE
-			for (int i = 0; i < 4; i++) {
-				robots_2D.push_back(new CableRobot2D(robots[i], robots[i+4], origin, bases[i], bases[i+4], 0));
-				gizmos.push_back(robots_2D.back()->get_gizmo());
-			}
+			// CHANGE REAL WORLD POSITIONS IN THE COFIG FILE
+			if (!setup_rig(true))
+				return false;
 
-				//robots_2D.push_back(new CableRobot2D(robots[1], robots[5], origin, bases[2], bases[3], 1));
-				//gizmos.push_back(robots_2D.back()->get_gizmo());
+			setup_safety();
 
-				//robots_2D.push_back(new CableRobot2D(robots[2], robots[3], origin, bases[4], bases[5], 2));
-				//gizmos.push_back(robots_2D.back()->get_gizmo());
-			//}
+			// write out any robots that were just migrated from their XML files
+			if (rig_config.size() > num_configs)
+				rig_config.save();
+			// make sure there's an editable copy for hot reloading
+			if (!ofFile::doesFileExist("rig_config.txt"))
+				rig_config.export_text();
 
 			// update the gui
 			num_robots.set(ofToString(robots.size()));
 			sync_index.setMax(robots.size() - 1);
+
+			ofLogNotice("RobotController::initialize") << "Initialized " << robots.size() << " robots (" << inventory.get_num_cached() << " from cache) in " << ofGetElapsedTimeMillis() - time_start << " ms.";
 		}
 		else {
 			ofLogWarning("RobotController::initialize") << "Unable to locate any SC hub ports.\n\tCheck that ClearView is closed and no other Clearpath applications are running.";
@@ -205,40 +242,271 @@ bool RobotController::initialize()
 	return true;
 }
 
+/**
+ * @brief Creates one virtual motor per base, instead of connecting to the hardware.
+ * Robots are paired into 2D robots the same way as the rig (see CableRig<Planar>: each
+ * pair of bases [left, right] gets one 2D robot), and start with their cables paid out to
+ * the home target.
+ *
+ * @return (bool)  true if there was at least one pair of bases.
+ */
+bool RobotController::initialize_offline()
+{
+	int count = bases.size() - bases.size() % 2;
+	if (count == 0) {
+		ofLogWarning("RobotController::initialize_offline") << "Need at least two bases to simulate a 2D robot.";
+		return false;
+	}
+
+	for (int j = 0; j < count; j++) {
+		NodeInfo info;
+		info.port = 0;
+		info.address = j;
+		info.serial_number = j;
+		info.model = "virtual";
+		info.resolution = 6400;
+		auto motor = new VirtualMotor(info);
+		virtual_motors.push_back(motor);
+		robots.push_back(new CableRobot(new MotorController(motor), false));
+	}
+
+	if (!setup_rig(false))
+		return false;
+
+	setup_safety();
+
+	// start each cable at the length that reaches its robot's initial target
+	for (int j = 0; j < count; j++) {
+		float length = glm::distance(robots[j]->get_tangent(), robots[j]->get_target());
+		virtual_motors[j]->set_position_counts(-1 * length / robots[j]->get_mm_per_rev() * virtual_motors[j]->get_resolution());
+	}
+
+	// update the gui
+	num_com_hubs.set("0");
+	com_ports.set("offline");
+	num_robots.set(ofToString(robots.size()));
+	sync_index.setMax(robots.size() - 1);
+
+	ofLogNotice("RobotController::initialize_offline") << "Initialized " << robots.size() << " virtual robots.";
+	return true;
+}
+
+/**
+ * @brief Builds the rig for the system configuration from the robots found, and adds its gizmos.
+ *
+ * @param (bool)  run_threaded: 2D robots tick on their own threads if true
+ * @return (bool)  false if no supported rig fits the robots
+ */
+bool RobotController::setup_rig(bool run_threaded)
+{
+	rig = Rig::create(system_config, robots, &kinematics, node_origin, bases, run_threaded);
+	if (rig == nullptr)
+		return false;
+	robots_2D = rig->get_robots_2D();
+	robots_3D = rig->get_robots_3D();
+	for (auto gizmo : rig->get_gizmos())
+		gizmos.push_back(gizmo);
+	ofLogNotice("RobotController::setup_rig") << "Running a " << rig->get_name() << " rig.";
+	return true;
+}
+
+/**
+ * @brief Runs one control tick in lockstep with the caller, for offline controllers.
+ * Initializes the virtual robots on the first call.
+ */
+void RobotController::step()
+{
+	if (!is_initialized) {
+		if (!is_gui_setup)
+			setup_gui();
+		if (!initialize_offline())
+			return;
+		rig->setup_gui(&panel);
+		check_for_system_ready();
+		is_initialized = true;
+
+		safety.start();
+
+		// virtual robots follow their targets right away
+		move_vel_all(true);
+	}
+
+	update();
+	rig->tick();
+}
+
 void RobotController::update()
 {
+	// swap in a hot-reloaded rig config at the tick boundary
+	std::unique_ptr<RigConfigWatcher::Snapshot> snapshot(config_watcher.take());
+	if (snapshot) {
+		int count = apply_config(snapshot->robots);
+		ofLogNotice("RobotController::update") << "Applied " << count << " robot configs, " << ofGetElapsedTimeMillis() - snapshot->time_loaded << " ms after the file changed.";
+	}
+
+	// write finished calibrations into the robots and the config store
+	update_calibration();
+
+	// the safety monitor has already stopped the motors; bring the robots and GUI into E-Stop
+	if (safety.is_tripped() && !safety_stopped) {
+		safety_stopped = true;
+		set_e_stop(true);
+	}
+
+	// pick up the latest traced target before the gizmos are read
+	LatencyTrace::resume(LatencyTrace::TARGET_SET);
+
 	// update the gizmos
 	update_gizmos();
 
-	if (system_config == Configuration::ONE_D) {
-		for (int i = 0; i < robots.size(); i++) {
-			robots[i]->update();
+	if (rig != nullptr)
+		rig->update();
+
+	// resolve all the frames that changed this tick
+	kinematics.update();
+	LatencyTrace::end(LatencyTrace::KINEMATICS_UPDATE);
+}
+
+/**
+ * @brief Applies reloaded or calibrated robot configs to the running robots.
+ * Only the derived values change (mm_per_count, kinematic offsets, bounds);
+ * the motors stay enabled and homed.
+ *
+ * @param (vector<RobotConfig>)  configs: robot configs, matched to the robots by serial number
+ * @return (int)  number of robots updated
+ */
+int RobotController::apply_config(const vector<RobotConfig>& configs)
+{
+	int count = 0;
+	for (auto& config : configs) {
+		string error;
+		if (!config.validate(error)) {
+			ofLogWarning("RobotController::apply_config") << "Skipping invalid config for " << error;
+			continue;
 		}
-	}
-	else if (system_config == Configuration::TWO_D) {
-		for (int i = 0; i < robots_2D.size(); i++) {
-			robots_2D[i]->update();
+		for (auto robot : robots) {
+			if (robot->get_serial_number() == config.serial_number) {
+				robot->set_config(config);
+				rig_config.set(config);
+				count++;
+			}
 		}
 	}
-	
+
+	// resolve the new offsets now, so the 2D bounds see them this tick
+	kinematics.update();
+	for (auto robot : robots_2D)
+		robot->on_config_reloaded();
+	for (int i = 0; i < robots_2D.size(); i++)
+		safety.set_span(i, glm::distance(robots_2D[i]->get_robot(0)->get_tangent(), robots_2D[i]->get_robot(1)->get_tangent()));
+	return count;
 }
 
-void RobotController::draw()
+/**
+ * @brief Once every 2D robot's calibration has finished, writes the calibrated tangents and
+ * drum diameters into the robots and the config store. Robots whose calibration failed keep
+ * their config.
+ */
+void RobotController::update_calibration()
 {
-	if (system_config == Configuration::ONE_D) {
-		for (int i = 0; i < robots.size(); i++) {
-			robots[i]->draw();
+	start_calibration();
+	if (!calibration_pending)
+		return;
+
+	for (auto calibration : calibrations) {
+		if (calibration->get_state() == Calibration2D::RUNNING) {
+			// show the first unfinished robot's progress
+			std::lock_guard<std::mutex> lock(mutex_calibration);
+			calibration_status_latest = calibration->get_status();
+			return;
 		}
 	}
-	else if (system_config == Configuration::TWO_D) {
-		for (int i = 0; i < robots_2D.size(); i++) {
-			robots_2D[i]->draw();
+
+	string status;
+	vector<RobotConfig> configs;
+	for (auto calibration : calibrations) {
+		status += calibration->get_status() + " ";
+		if (calibration->get_state() != Calibration2D::DONE)
+			continue;
+		auto result = calibration->get_result();
+		for (int i = 0; i < 2; i++) {
+			// the tangent is local to the drum's base
+			CableRobot* robot = calibration->get_robot()->get_robot(i);
+			glm::vec3 tangent = glm::inverse(robot->get_base_orientation()) * (result.anchors[i] - robot->get_base());
+			RobotConfig config = robot->get_config();
+			for (int j = 0; j < 3; j++)
+				config.tangent[j] = tangent[j];
+			config.drum_diameter = result.diameters[i];
+			configs.push_back(config);
 		}
 	}
+	{
+		std::lock_guard<std::mutex> lock(mutex_calibration);
+		calibration_status_latest = status;
+	}
+	if (!configs.empty()) {
+		int count = apply_config(configs);
+		rig_config.save();
+		// the robots already run this config; don't hot reload it back in
+		if (rig_config.export_text())
+			config_watcher.skip_own_write();
+		ofLogNotice("RobotController::update_calibration") << "Calibrated " << count << " robots and saved them to the config store.";
+	}
+	// hand the targets back to the app
+	calibration_pending = false;
+}
+
+/**
+ * @brief Starts a calibration the GUI requested (see on_run_calibration), on the controller
+ * thread so the calibrations are only ever touched from here.
+ */
+void RobotController::start_calibration()
+{
+	Calibration2D::Settings settings;
+	{
+		std::lock_guard<std::mutex> lock(mutex_calibration);
+		if (!calibration_requested)
+			return;
+		calibration_requested = false;
+		settings = calibration_settings;
+		calibration_status_latest = "RUNNING";
+	}
+
+	for (auto calibration : calibrations)
+		delete calibration;
+	calibrations.clear();
+
+	// lock out the app's targets before the first pose is posted
+	calibration_pending = true;
+	for (int i = 0; i < robots_2D.size(); i++) {
+		calibrations.push_back(new Calibration2D(robots_2D[i], i, settings));
+		calibrations.back()->start();
+	}
+}
+
+void RobotController::draw(BatchRenderer& batch)
+{
+	if (rig != nullptr)
+		rig->draw(batch);
 }
 
 void RobotController::shutdown()
 {
+	// stop any calibration before its robot's motors go away
+	for (auto calibration : calibrations)
+		delete calibration;
+	calibrations.clear();
+
+	// stop and free the 2D and 3D robots before their motors go away
+	robots_2D.clear();
+	robots_3D.clear();
+	gizmos.clear();
+	delete rig;
+	rig = nullptr;
+
+	// finish the last config save before the process can exit
+	rig_config.close();
+
 	if (myMgr != nullptr) {
 		ofLogNotice() << "Closing HUB Ports...";
 		myMgr->PortsClose();
@@ -253,6 +521,7 @@ void RobotController::windowResized(int w, int h)
 
 void RobotController::threadedFunction()
 {
+	LatencyTrace::set_thread_name("robot_controller");
 	while (isThreadRunning()) {
 		if (!is_initialized) {
 			
@@ -264,37 +533,24 @@ void RobotController::threadedFunction()
 			// Create one CableRobot per detected motor
 			if (initialize()) {
 				// update each robot's gui
-				if (system_config == Configuration::ONE_D) {
-					int x = panel.getPosition().x;
-					int y = panel.getPosition().y;
-					int w = panel.getWidth();
-					int padding = 5;
-					for (int i = 0; i < robots.size(); i++) {
-						robots[i]->panel.setPosition(x + w + padding, y);
-						x = robots[i]->panel.getPosition().x;
-						w = robots[i]->panel.getWidth();
-						robots[i]->panel.setParent(&panel);
-					}
-				}
-				else if (system_config == Configuration::TWO_D) {
-					for (int i = 0; i < robots_2D.size(); i++) {
-						robots_2D[i]->update_gui(&panel);
-						robots_2D[i]->plot.name = "Bot 1 RPM: Motor 1 (RED), Motor 2 (BLUE)";
-					}					
-				}
+				rig->setup_gui(&panel);
 				// check if system is ready to move (all motors are homed)
 				check_for_system_ready();
 				is_initialized = true;
+
+				// start watching the rig config for live edits
+				config_watcher.start();
+				link_monitor.start();
+				safety.start();
 			}
 			// add a delay before trying to initialize again
 			else {
-				float timer = ofGetElapsedTimeMillis();
-				float delay = 5;
-				ofLogWarning("RobotController::threadedFunction") << "initialize() FAILED. Check that the motors are powered and connected to PC.\n\tRETRYING " << delay << " SECONDS.\n";
-				while (ofGetElapsedTimeMillis() < timer + (delay * 1000))
-				{
-					// ... hold the thread for 5 seconds
-				}
+				float delay = 1;
+				ofLogWarning("RobotController::threadedFunction") << "initialize() FAILED. Check that the motors are powered and connected to PC.\n\tRETRYING IN " << delay << " SECONDS.\n";
+				// sleep instead of spinning, and stay responsive to stopThread()
+				uint64_t timer = ofGetElapsedTimeMillis();
+				while (isThreadRunning() && ofGetElapsedTimeMillis() < timer + (delay * 1000))
+					sleep(50);
 			}
 		}
 
@@ -317,7 +573,7 @@ void RobotController::check_for_system_ready()
 	// check if motors are homed and ready
 	bool is_ready = true;
 	for (int i = 0; i < robots.size(); i++) {
-		if (robots[i]->status.get() == "ENABLED" || robots[i]->status.get() == "DISABLED") {
+		if (robots[i]->get_state_name() == "ENABLED" || robots[i]->get_state_name() == "DISABLED") {
 		}
 		else {
 			is_ready = false;
@@ -343,12 +599,38 @@ void RobotController::setup_gui()
 	panel.add(status.set("Status", state_names[0]));
 	panel.add(check_status.set("Check_Status"));
 	panel.add(save_settings_files.set("Save_Settings"));
+	panel.add(export_config_text.set("Export_Config_Text"));
 	
 	params_info.setName("System_Info");
 	params_info.add(com_ports.set("COM_Ports", ""));
 	params_info.add(num_com_hubs.set("Num_Hubs", ""));
 	params_info.add(num_robots.set("Num_Motors", ""));
 
+	params_link.setName("Link_Monitor");
+	params_link.add(link_rtt.set("Round_Trip_p50/p99", ""));
+	params_link.add(link_rate.set("Cmds/s_Depth", ""));
+	params_link.add(link_errors.set("Errors_Buf_Full", ""));
+	params_link.add(link_stream.set("Queue_Depth/Merged/Rejected", ""));
+	params_link.add(link_rtt_warning.set("Round_Trip_Warning_ms", 10, 1, 50));
+	params_link.add(save_command_trace.set("Save_Command_Trace"));
+
+	params_safety.setName("Safety_Monitor");
+	params_safety.add(safety_status.set("Status", "OK"));
+	params_safety.add(safety_reaction.set("Reaction_p99/max_us", ""));
+	params_safety.add(safety_rate.set("Checks/s", ""));
+
+	params_calibration.setName("Calibration");
+	params_calibration.add(run_calibration.set("Run_Calibration"));
+	params_calibration.add(calibration_columns.set("Grid_Columns", 4, 2, 10));
+	params_calibration.add(calibration_rows.set("Grid_Rows", 3, 2, 10));
+	params_calibration.add(calibration_status.set("Status", "IDLE"));
+
+	params_latency.setName("Latency");
+	params_latency.add(trace_latency.set("Trace_Latency", false));
+	params_latency.add(latency_end_to_end.set("OSC_to_Cmd_p50/p99", ""));
+	params_latency.add(latency_link.set("Cmd_Round_Trip_p50/p99", ""));
+	params_latency.add(export_latency_trace.set("Export_Trace"));
+
 	//params_sync.setName("Synchronize_Params");
 	//params_sync.add(sync_index.set("Synchronize_Index", 0, 0, 0));
 	//params_sync.add(is_synchronized.set("Synchronize", false));
@@ -357,14 +639,26 @@ void RobotController::setup_gui()
 
 	check_status.addListener(this, &RobotController::check_for_system_ready);
 	save_settings_files.addListener(this, &RobotController::on_save_settings);
+	export_config_text.addListener(this, &RobotController::on_export_config_text);
+	trace_latency.addListener(this, &RobotController::on_trace_latency);
+	link_rtt_warning.addListener(this, &RobotController::on_link_rtt_warning);
+	save_command_trace.addListener(this, &RobotController::on_save_command_trace);
+	export_latency_trace.addListener(this, &RobotController::on_export_latency_trace);
+	run_calibration.addListener(this, &RobotController::on_run_calibration);
 	//is_synchronized.addListener(this, &RobotController::on_synchronize);
 	//ee_offset.addListener(this, &RobotController::on_ee_offset_changed);
 
 	panel.add(params_info);
+	panel.add(params_safety);
+	panel.add(params_link);
+	panel.add(params_latency);
+	panel.add(params_calibration);
 	//panel.add(params_sync);
 
 	// Minimize less important parameters
 	panel.getGroup("System_Info").minimize();
+	panel.getGroup("Latency").minimize();
+	panel.getGroup("Calibration").minimize();
 	panel.getGroup("System_Controller").minimize();
 
 	is_gui_setup = true;
@@ -372,30 +666,20 @@ void RobotController::setup_gui()
 
 void RobotController::draw_gui()
 {
+	update_latency();
+	update_link_monitor();
+	update_safety();
+	if (rig != nullptr)
+		rig->update_gui();
+	{
+		std::lock_guard<std::mutex> lock(mutex_calibration);
+		if (calibration_status.get() != calibration_status_latest)
+			calibration_status.set(calibration_status_latest);
+	}
 	if (showGUI) {
 		panel.draw();
-		if (system_config == Configuration::ONE_D) {
-			for (int i = 0; i < robots.size(); i++) {
-				robots[i]->panel.draw();
-			}
-		}
-		else if (system_config == Configuration::TWO_D) {
-			for (int i = 0; i < robots_2D.size(); i++) {
-				int padding = 20;
-				int x = panel.getPosition().x + (i * panel.getWidth()) + (i * padding);
-				int y = panel.getPosition().y + panel.getHeight() + padding;
-				robots_2D[i]->panel.setPosition(x, y);
-				robots_2D[i]->draw_gui();
-
-
-				if (robots_2D[i]->debugging) {
-					ofPushMatrix();
-					ofTranslate(ofGetWidth() - 550, i * 150 + 60);
-					robots_2D[i]->plot.draw();
-					ofPopMatrix();
-				}
-			}
-		}			
+		if (rig != nullptr)
+			rig->draw_gui(&panel);
 	}
 }
 
@@ -409,31 +693,20 @@ void RobotController::pause()
 {
 	ofLogNotice(__FUNCTION__) << "Stopping Robots ...";
 	state = ControllerState::PAUSE;
-	if (system_config == Configuration::ONE_D) {
-		for (int i = 0; i < robots.size(); i++) {
-			robots[i]->stop();
-		}
-	}
-	else if (system_config == Configuration::TWO_D) {
-		for (int i = 0; i < robots_2D.size(); i++) {
-			robots_2D[i]->stop();
-		}
-	}
+	if (rig != nullptr)
+		rig->stop();
 }
 
 void RobotController::set_e_stop(bool val)
 {
 	state = ControllerState::E_STOP;
-	if (system_config == Configuration::ONE_D) {
-		for (int i = 0; i < robots.size(); i++) {
-			robots[i]->set_e_stop(val);
-		}
-	}
-	else if (system_config == Configuration::TWO_D) {
-		for (int i = 0; i < robots_2D.size(); i++) {
-			robots_2D[i]->set_e_stop(val);
-		}
+	// clearing the E-Stop re-arms the safety monitor
+	if (!val) {
+		safety.reset();
+		safety_stopped = false;
 	}
+	if (rig != nullptr)
+		rig->set_e_stop(val);
 }
 
 void RobotController::key_pressed(int key)
@@ -458,27 +731,15 @@ void RobotController::key_pressed(int key)
 
 	key_pressed_gizmo(key);
 
-	if (system_config == Configuration::ONE_D) {
-		for (int i = 0; i < robots.size(); i++)
-			robots[i]->key_pressed(key);
-	}
-	else if (system_config == Configuration::TWO_D) {
-		for (int i = 0; i < robots_2D.size(); i++)
-			robots_2D[i]->key_pressed(key);
-	}	
+	if (rig != nullptr)
+		rig->key_pressed(key);
 }
 
 void RobotController::move_vel_all(bool val)
 {
 	ofLogNotice(__FUNCTION__) << "Turning Velocity Moves [" << (val ? "ON" : "OFF") << "]";
-	if (system_config == Configuration::ONE_D) {
-		for (int i = 0; i < robots.size(); i++)
-			robots[i]->move_to_vel.set(val);
-	}
-	else if (system_config == Configuration::TWO_D) {
-		for (int i = 0; i < robots_2D.size(); i++)
-			robots_2D[i]->move_to_vel.set(val);
-	}
+	if (rig != nullptr)
+		rig->set_move_to_vel(val);
 }
 
 void RobotController::key_pressed_gizmo(int key)
@@ -528,43 +789,66 @@ void RobotController::set_origin(glm::vec3 pos, glm::quat orient)
 {
 	origin->setGlobalPosition(pos);
 	origin->setGlobalOrientation(orient);
+	kinematics.set_global_transform(node_origin, pos, orient);
 }
 
 void RobotController::set_targets(vector<glm::vec3> targets)
 {
+	// a calibration is driving the 2D robots
+	if (calibration_pending)
+		return;
 	if (system_config == Configuration::TWO_D) {
-		for (int i = 0; i < robots_2D.size(); i++) {
-			ofNode node;
-			node.setPosition(targets[i]);
-			robots_2D[i]->get_gizmo()->setNode(node);
-		}
+		for (int i = 0; i < robots_2D.size() && i < targets.size(); i++)
+			robots_2D[i]->set_target(targets[i].x, targets[i].y);
+	}
+	else if (system_config == Configuration::THREE_D) {
+		for (int i = 0; i < robots_3D.size() && i < targets.size(); i++)
+			robots_3D[i]->set_target(targets[i]);
 	}
+	LatencyTrace::end(LatencyTrace::TARGET_SET);
 }
 
 
 void RobotController::set_targets(vector<glm::vec3*> targets)
 {
+	if (calibration_pending)
+		return;
 	if (system_config == Configuration::TWO_D) {
-		for (int i = 0; i < robots_2D.size(); i++) {
-			ofNode node;
-			node.setPosition(*targets[i]);			
-			robots_2D[i]->get_gizmo()->setNode(node);
-		}
+		for (int i = 0; i < robots_2D.size() && i < targets.size(); i++)
+			robots_2D[i]->set_target(targets[i]->x, targets[i]->y);
+	}
+	LatencyTrace::end(LatencyTrace::TARGET_SET);
+}
+
+/**
+ * @brief Sets the XY targets of all 2D robots from one command frame.
+ * Each robot keeps its current Z. The targets are only posted here; the gizmos
+ * and kinematics pick them up on the controller thread's next update.
+ *
+ * @param (vector<float>)  x: target x positions, one per robot
+ * @param (vector<float>)  y: target y positions, one per robot
+ */
+void RobotController::set_targets(const vector<float>& x, const vector<float>& y)
+{
+	if (calibration_pending)
+		return;
+	if (system_config == Configuration::TWO_D) {
+		int count = MIN(robots_2D.size(), MIN(x.size(), y.size()));
+		for (int i = 0; i < count; i++)
+			robots_2D[i]->set_target(x[i], y[i]);
 	}
+	LatencyTrace::end(LatencyTrace::TARGET_SET);
 }
 
 void RobotController::set_target(int i, float x, float y)
 {
+	if (calibration_pending)
+		return;
 	if (system_config == Configuration::TWO_D) {
-		if (i < robots_2D.size()) {
-			auto pos = robots_2D[i]->get_gizmo()->getTranslation();
-			pos.x = x;
-			pos.y = y;
-			ofNode node;
-			node.setGlobalPosition(pos);
-			robots_2D[i]->get_gizmo()->setNode(node);
-		}
+		if (i < robots_2D.size())
+			robots_2D[i]->set_target(x, y);
 	}
+	LatencyTrace::end(LatencyTrace::TARGET_SET);
 }
 
 /**
@@ -579,6 +863,11 @@ glm::vec3 RobotController::get_target(int i) {
 			return robots_2D[i]->estimated_target_actual;
 		}
 	}
+	else if (system_config == Configuration::THREE_D) {
+		if (i < robots_3D.size()) {
+			return robots_3D[i]->get_target_actual();
+		}
+	}
 	return glm::vec3();
 }
 
@@ -612,7 +901,8 @@ vector<glm::vec3> RobotController::get_actual_positions()
 vector<glm::vec3> RobotController::get_targets()
 {
 	vector<glm::vec3> tgts;
-	for (int i = 0; i < robots_2D.size(); i++) {
+	int count = system_config == Configuration::THREE_D ? robots_3D.size() : robots_2D.size();
+	for (int i = 0; i < count; i++) {
 		tgts.push_back(get_target(i));
 	}
 	return tgts;
@@ -623,21 +913,12 @@ void RobotController::update_gizmos()
 	// update the origin node to match the gizmo
 	origin->setGlobalPosition(gizmos[0]->getTranslation());
 	origin->setGlobalOrientation(gizmos[0]->getRotation());
+	kinematics.set_global_transform(node_origin, gizmos[0]->getTranslation(), gizmos[0]->getRotation());
 
 	// override ee gizmo transforms if we're moving the origin gizmo
 	bool val = gizmos[0]->isInteracting();
-	if (system_config == Configuration::ONE_D) {
-		for (int i = 0; i < robots.size(); i++) {
-			robots[i]->override_gizmo = val;
-			robots[i]->update_gizmo();
-		}
-	}
-	else if (system_config == Configuration::TWO_D) {
-		for (int i = 0; i < robots_2D.size(); i++) {
-			robots_2D[i]->override_gizmo = val;
-			robots_2D[i]->update_gizmo();
-		}
-	}
+	if (rig != nullptr)
+		rig->update_gizmos(val);
 }
 
 //void RobotController::set_ee(glm::vec3 pos, glm::quat orient)
@@ -714,6 +995,151 @@ void RobotController::on_save_settings()
 	save_settings();
 }
 
+void RobotController::on_export_config_text()
+{
+	for (auto robot : robots)
+		rig_config.set(robot->get_config());
+	if (rig_config.export_text())
+		config_watcher.skip_own_write();
+}
+
+void RobotController::on_trace_latency(bool& val)
+{
+	LatencyTrace::set_enabled(val);
+	if (val)
+		latency.reset();
+}
+
+void RobotController::on_export_latency_trace()
+{
+	latency.collect();
+	latency.export_chrome_trace();
+	ofLogNotice("RobotController::on_export_latency_trace") << "Latency (p50 / p99 / max):\n" << latency.get_summary();
+}
+
+/**
+ * @brief Drains the latency trace points a few times a second and refreshes the GUI readout.
+ */
+void RobotController::update_latency()
+{
+	if (!trace_latency.get() || ofGetElapsedTimeMillis() - time_latency_collected < 250)
+		return;
+	time_latency_collected = ofGetElapsedTimeMillis();
+	latency.collect();
+
+	auto ms = [](const LatencyHistogram& h) {
+		return ofToString(h.get_percentile(50) / 1000000.0, 1) + " / " + ofToString(h.get_percentile(99) / 1000000.0, 1) + " ms";
+	};
+	latency_end_to_end.set(ms(latency.get_end_to_end()));
+	latency_link.set(ms(latency.get_histogram(LatencyTrace::CMD_RESPONSE)));
+}
+
+void RobotController::on_link_rtt_warning(float& val)
+{
+	link_monitor.rtt_warning = val;
+}
+
+/**
+ * @brief Saves the sFoundation command trace (the last 4096 packets) of every port.
+ */
+void RobotController::on_save_command_trace()
+{
+	if (myMgr == nullptr || !is_initialized)
+		return;
+	for (int i = 0; i < ofToInt(num_com_hubs.get()); i++) {
+		string filename = ofToDataPath("command_trace_port_" + ofToString(i) + "_" + ofGetTimestampString("%Y%m%d_%H%M%S") + ".txt", true);
+		myMgr->Ports(i).CommandTraceSave(filename.c_str());
+		ofLogNotice("RobotController::on_save_command_trace") << "Saved command trace to: " << filename;
+	}
+}
+
+/**
+ * @brief Calibrates every 2D robot at once, each on its own thread (see Calibration2D).
+ * The robots must be homed and enabled; they're switched to velocity moves to follow the poses.
+ * The controller thread starts the calibrations on its next update.
+ */
+void RobotController::on_run_calibration()
+{
+	if (system_config != Configuration::TWO_D || robots_2D.empty()) {
+		ofLogWarning("RobotController::on_run_calibration") << "Calibration needs a 2D rig.";
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex_calibration);
+		if (calibration_pending || calibration_requested) {
+			ofLogWarning("RobotController::on_run_calibration") << "A calibration is already running.";
+			return;
+		}
+		calibration_settings.columns = calibration_columns.get();
+		calibration_settings.rows = calibration_rows.get();
+		calibration_requested = true;
+	}
+	move_vel_all(true);
+}
+
+/**
+ * @brief Shows the safety monitor's fault, reaction times and rate in the GUI.
+ */
+void RobotController::update_safety()
+{
+	safety_status.set(safety.is_tripped() ? "FAULT: " + safety.get_fault() : "OK");
+	safety_reaction.set(ofToString(safety.get_reaction_p99(), 0) + " / " + ofToString(safety.get_reaction_max(), 0));
+	safety_rate.set(ofToString(safety.get_rate(), 0));
+}
+
+/**
+ * @brief Registers every motor and 2D pair with the safety monitor. Call before safety.start().
+ */
+void RobotController::setup_safety()
+{
+	for (auto robot : robots)
+		robot->set_safety_channel(safety.add(robot->get_motor_controller()->get_motor()));
+	for (auto robot : robots_2D) {
+		auto a = robot->get_robot(0);
+		auto b = robot->get_robot(1);
+		safety.add_pair(a->get_safety_channel(), b->get_safety_channel(), glm::distance(a->get_tangent(), b->get_tangent()));
+	}
+}
+
+/**
+ * @brief Shows the worst node of the last link monitor window in the GUI.
+ */
+void RobotController::update_link_monitor()
+{
+	if (link_monitor.get_window() == link_window)
+		return;
+	link_window = link_monitor.get_window();
+
+	auto stats = link_monitor.get_stats();
+	if (stats.empty())
+		return;
+	auto worst = stats[0];
+	float rate = 0;
+	int depth = 0;
+	uint64_t errors = 0, buffer_full = 0;
+	for (auto& s : stats) {
+		if (s.rtt_p99 > worst.rtt_p99)
+			worst = s;
+		rate += s.commands_per_sec;
+		depth = MAX(depth, s.in_flight_peak);
+		errors += s.err_checksum + s.err_fragment + s.err_stray + s.err_overrun + s.failures;
+		buffer_full += s.buffer_full;
+	}
+	link_rtt.set(ofToString(worst.rtt_p50, 1) + " / " + ofToString(worst.rtt_p99, 1) + " ms (node " + ofToString(worst.address) + ")");
+	link_rate.set(ofToString(rate, 0) + " / " + ofToString(depth));
+	link_errors.set(ofToString(errors) + " / " + ofToString(buffer_full) + (link_monitor.is_saturated() ? " SATURATED" : ""));
+
+	int queue_depth = 0;
+	uint64_t merged = 0, rejected = 0;
+	for (auto robot : robots) {
+		auto stream = robot->get_motor_controller()->get_motor()->get_stream();
+		queue_depth = MAX(queue_depth, stream->get_depth());
+		merged += stream->merged.load();
+		rejected += stream->rejected.load();
+	}
+	link_stream.set(ofToString(queue_depth) + " / " + ofToString(merged) + " / " + ofToString(rejected));
+}
+
 //void RobotController::on_ee_offset_changed(float& val)
 //{
 //	float offset =  val;
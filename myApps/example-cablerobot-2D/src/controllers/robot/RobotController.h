@@ -5,6 +5,14 @@
 #include "pubSysCls.h"
 #include "CableRobot.h"
 #include "CableRobot2D.h"
+#include "CableRig.h"
+#include "Calibration2D.h"
+#include "NodeInventory.h"
+#include "RigConfigWatcher.h"
+#include "LinkMonitor.h"
+#include "SafetyMonitor.h"
+#include "VirtualMotor.h"
+#include "../LatencyTrace.h"
 #include "ofxGizmo.h"
 #include "ofxXmlSettings.h"
 
@@ -16,17 +24,43 @@ class RobotController :
     public ofThread
 {
 private:
-    SysManager* myMgr;
+    SysManager* myMgr = nullptr;
+    NodeInventory inventory;    // cached static Info of every node, for fast restarts
+    RigConfig rig_config;       // config store for every robot in the rig
+    RigConfigWatcher config_watcher;
+    LinkMonitor link_monitor;   // round trips, command rate and errors on each serial link
+    SafetyMonitor safety;       // torque, bounds and paired-cable watchdog with group stop
+    bool safety_stopped = false;
+    void setup_safety();
+    void update_safety();
+    int apply_config(const vector<RobotConfig>& configs);
     vector<CableRobot*> robots;
     vector<glm::vec3> bases;
 
-    vector<CableRobot2D*> robots_2D;
+    Rig* rig = nullptr;         // the robots in the system configuration's topology
+    bool setup_rig(bool run_threaded);
+
+    vector<CableRobot2D*> robots_2D;    // the rig's 2D robots, if it's planar
+    vector<CableRobot3D*> robots_3D;    // the rig's 3D robot, if it's spatial
+
+    vector<Calibration2D*> calibrations;    // one per 2D robot; controller thread only
+    std::atomic<bool> calibration_pending{ false };     // running, or results not yet written to the config store
+    std::mutex mutex_calibration;
+    bool calibration_requested = false;     // by the GUI, started by the controller thread
+    Calibration2D::Settings calibration_settings;
+    string calibration_status_latest = "IDLE";  // published for the GUI thread
+    void update_calibration();
+    void start_calibration();
 
     ofNode* origin;      // World reference frame 
     ofNode ee;
+
+    KinematicGraph kinematics;  // shared frames of all the robots, resolved once per tick
+    int node_origin = -1;
     
     bool is_initialized = false;
     bool initialize();
+    bool initialize_offline();
     void update();
 
     void check_for_system_ready();
@@ -42,7 +76,8 @@ private:
 
     bool auto_home = false;
     bool load_robots_from_file = true;
-    bool run_offline = false;
+    bool run_offline = false;   // drive virtual motors, stepped by the app (see step)
+    vector<VirtualMotor*> virtual_motors;
 
     enum ControllerState {
         NOT_READY = 0,
@@ -68,17 +103,24 @@ private:
     
     bool debugging = true;
 
+    LatencyTrace latency;       // aggregates the OSC -> motor command trace points
+    uint64_t time_latency_collected = 0;
+    void update_latency();
+    uint64_t link_window = 0;
+    void update_link_monitor();
+
 public:
     RobotController() = default;
     RobotController(int count, float offset_x=0, float offset_y=0, float offset_z=0);
-    RobotController(vector<glm::vec3> positions_base, ofNode* _origin);
+    RobotController(vector<glm::vec3> positions_base, ofNode* _origin, bool run_offline = false);
 
-    void draw();
+    void draw(BatchRenderer& batch);
     void draw_gui();
     void shutdown();
     void windowResized(int w, int h);
     
     void threadedFunction();
+    void step();
 
     void save_settings(string filename = "settings.xml");
     void load_settings(string filename = "settings.xml");
@@ -99,6 +141,7 @@ public:
 
     void set_targets(vector<glm::vec3*> targets);
     void set_targets(vector<glm::vec3> targets);
+    void set_targets(const vector<float>& x, const vector<float>& y);
     void set_target(int i, float x, float y);
     void set_target_x(int i, float x);
     void set_target_y(int i, float y);
@@ -106,16 +149,51 @@ public:
     vector<glm::vec3> get_targets();
     vector<glm::vec3> get_actual_positions();
 
+    bool is_offline() { return run_offline; }
+    int get_num_robots() { return robots.size(); }
+    CableRobot* get_robot(int i) { return robots[i]; }
+    vector<VirtualMotor*> get_virtual_motors() { return virtual_motors; }
+    int get_num_robots_2D() { return robots_2D.size(); }
+    CableRobot2D* get_robot_2D(int i) { return robots_2D[i]; }
+    int get_num_robots_3D() { return robots_3D.size(); }
+    CableRobot3D* get_robot_3D(int i) { return robots_3D[i]; }
+
     ofxPanel panel;
     ofParameter<string> status;
     ofParameter<void> check_status;
     ofParameter<void> save_settings_files;
+    ofParameter<void> export_config_text;
 
     ofParameterGroup params_info;
     ofParameter<string> com_ports;
     ofParameter<string> num_com_hubs;
     ofParameter<string> num_robots;
 
+    ofParameterGroup params_latency;
+    ofParameter<bool> trace_latency;
+    ofParameter<string> latency_end_to_end;
+    ofParameter<string> latency_link;
+    ofParameter<void> export_latency_trace;
+
+    ofParameterGroup params_link;
+    ofParameter<string> link_rtt;
+    ofParameter<string> link_rate;
+    ofParameter<string> link_errors;
+    ofParameter<string> link_stream;
+    ofParameter<float> link_rtt_warning;
+    ofParameter<void> save_command_trace;
+
+    ofParameterGroup params_safety;
+    ofParameter<string> safety_status;
+    ofParameter<string> safety_reaction;
+    ofParameter<string> safety_rate;
+
+    ofParameterGroup params_calibration;
+    ofParameter<void> run_calibration;
+    ofParameter<int> calibration_columns;
+    ofParameter<int> calibration_rows;
+    ofParameter<string> calibration_status;
+
     ofParameterGroup params_sync;
     ofParameter<int> sync_index;
     ofParameter<bool> is_synchronized;
@@ -125,6 +203,12 @@ public:
     void on_synchronize(bool& val);
     void on_ee_offset_changed(float& val);
     void on_save_settings();
+    void on_export_config_text();
+    void on_trace_latency(bool& val);
+    void on_export_latency_trace();
+    void on_link_rtt_warning(float& val);
+    void on_save_command_trace();
+    void on_run_calibration();
 
 
     ofColor mode_color_disabled;
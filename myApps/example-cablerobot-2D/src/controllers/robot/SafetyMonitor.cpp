@@ -0,0 +1,229 @@
+#include "SafetyMonitor.h"
+
+#ifdef TARGET_WIN32
+#include <windows.h>
+#endif
+
+//--------------------------------------------------------------
+SafetyMonitor::~SafetyMonitor()
+{
+	waitForThread(true);
+}
+
+/**
+ * @brief Starts watching a motor. Call for every motor before start().
+ *
+ * @param (Motor*)  motor: motor to watch (and stop)
+ * @return (Channel*)  status channel for the motor's robot to publish into.
+ */
+SafetyMonitor::Channel* SafetyMonitor::add(Motor* motor)
+{
+	channels.push_back(make_unique<Channel>());
+	channels.back()->motor = motor;
+	channels.back()->port = motor->get_info().port;
+	return channels.back().get();
+}
+
+/**
+ * @brief Cross-checks two cables that hang the same end effector.
+ *
+ * @param (Channel*)  a: first cable
+ * @param (Channel*)  b: second cable
+ * @param (float)  span: distance between the two cables' tangent points (mm)
+ */
+void SafetyMonitor::add_pair(Channel* a, Channel* b, float span)
+{
+	pairs.push_back(make_unique<Pair>());
+	pairs.back()->a = a;
+	pairs.back()->b = b;
+	pairs.back()->span.store(span);
+}
+
+void SafetyMonitor::set_span(int pair, float span)
+{
+	if (pair < pairs.size())
+		pairs[pair]->span.store(span);
+}
+
+/**
+ * @brief Starts the monitor thread.
+ *
+ * @param (float)  rate: checks per second. Defaults to 1000.
+ */
+void SafetyMonitor::start(float rate)
+{
+	interval = 1000000 / MAX(1.0f, rate);
+	startThread();
+}
+
+string SafetyMonitor::get_fault()
+{
+	std::lock_guard<std::mutex> lock(mutex_fault);
+	return fault;
+}
+
+/**
+ * @brief Clears a latched fault. The motors stay E-Stopped until they are cleared too.
+ */
+void SafetyMonitor::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_fault);
+	if (tripped.load())
+		ofLogNotice("SafetyMonitor::reset") << "Clearing fault: " << fault;
+	fault = "";
+	tripped.store(false);
+}
+
+float SafetyMonitor::get_reaction_p99()
+{
+	std::lock_guard<std::mutex> lock(mutex_fault);
+	return reaction.get_percentile(99) / 1000.0;
+}
+
+float SafetyMonitor::get_reaction_max()
+{
+	std::lock_guard<std::mutex> lock(mutex_fault);
+	return reaction.get_max() / 1000.0;
+}
+
+void SafetyMonitor::threadedFunction()
+{
+	LatencyTrace::set_thread_name("safety_monitor");
+#ifdef TARGET_WIN32
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#endif
+
+	auto next = std::chrono::steady_clock::now();
+	auto window = next;
+	int cycles = 0;
+	while (isThreadRunning()) {
+		next += std::chrono::microseconds(interval);
+		std::this_thread::sleep_until(next);
+		auto detected = std::chrono::steady_clock::now();
+		// don't try to catch up after a stall, just keep the rate
+		if (detected - next > std::chrono::microseconds(interval))
+			next = detected;
+
+		string reason;
+		if (!check(ofGetElapsedTimeMicros(), reason) && !tripped.load())
+			trip(reason, detected);
+
+		cycles++;
+		float seconds = std::chrono::duration<float>(detected - window).count();
+		if (seconds >= 1) {
+			rate_measured.store(cycles / seconds);
+			cycles = 0;
+			window = detected;
+		}
+	}
+}
+
+/**
+ * @brief Runs one cycle of checks.
+ *
+ * @param (uint64_t)  now: app time (us)
+ * @param (string&)  reason: set to the first fault found
+ * @return (bool)  true if everything is within limits.
+ */
+bool SafetyMonitor::check(uint64_t now, string& reason)
+{
+	if (channels.empty())
+		return true;
+
+	// refresh one motor's measured torque per cycle
+	auto& polled = *channels[torque_index];
+	torque_index = (torque_index + 1) % channels.size();
+	try {
+		polled.torque.store(polled.motor->get_torque());
+	}
+	catch (mnErr& theErr) {
+		reason = "Could not read the torque of motor " + ofToString(polled.motor->get_address()) + ": " + theErr.ErrorMsg;
+		return false;
+	}
+
+	for (auto& c : channels) {
+		int id = c->motor->get_address();
+		float torque = c->torque.load();
+		if (torque > c->torque_max.load() || torque < c->torque_min.load()) {
+			reason = "Motor " + ofToString(id) + " torque " + ofToString(torque, 1) + " is out of range [" + ofToString(c->torque_min.load(), 1) + ", " + ofToString(c->torque_max.load(), 1) + "]";
+			return false;
+		}
+
+		uint64_t published = c->time_published.load(std::memory_order_acquire);
+		if (published == 0)
+			continue;
+		float length = c->length_actual.load(std::memory_order_relaxed);
+		float margin = length_margin.load();
+		if (length < c->bounds_min.load() - margin || length > c->bounds_max.load() + margin) {
+			reason = "Motor " + ofToString(id) + " cable length " + ofToString(length, 1) + " mm is out of bounds [" + ofToString(c->bounds_min.load(), 0) + ", " + ofToString(c->bounds_max.load(), 0) + "]";
+			return false;
+		}
+		if (c->streaming.load() && now > published && (now - published) / 1000.0 > stale_timeout.load()) {
+			reason = "Motor " + ofToString(id) + " is streaming, but its control tick stalled for " + ofToString((now - published) / 1000.0, 1) + " ms";
+			return false;
+		}
+
+		// a target jump can put a cable far from its desired length for a moment, but it
+		// should close in: one that doesn't is stalled, slipping, or running the wrong way
+		float error = abs(c->length_desired.load(std::memory_order_relaxed) - length);
+		if (!c->streaming.load() || error <= max_tracking_error.load()) {
+			c->tracking_since = 0;
+		}
+		else if (c->tracking_since == 0 || error < c->tracking_error_best - 1) {
+			c->tracking_error_best = error;
+			c->tracking_since = now;
+		}
+		else if ((now - c->tracking_since) / 1000.0 > tracking_timeout.load()) {
+			reason = "Motor " + ofToString(id) + " cable length is " + ofToString(error, 1) + " mm from its desired length, and hasn't closed in for " + ofToString((now - c->tracking_since) / 1000.0, 0) + " ms";
+			return false;
+		}
+	}
+
+	// the two cables of a 2D robot must still meet at one end effector
+	for (auto& pair : pairs) {
+		if (pair->a->time_published.load() == 0 || pair->b->time_published.load() == 0)
+			continue;
+		float l_a = pair->a->length_actual.load(std::memory_order_relaxed);
+		float l_b = pair->b->length_actual.load(std::memory_order_relaxed);
+		float span = pair->span.load();
+		// the two length circles intersect only if |l_a - l_b| <= span <= l_a + l_b
+		float residual = MAX(0.0f, span - (l_a + l_b)) + MAX(0.0f, abs(l_a - l_b) - span);
+		if (residual > max_residual.load()) {
+			reason = "Motors " + ofToString(pair->a->motor->get_address()) + " and " + ofToString(pair->b->motor->get_address()) + " disagree by " + ofToString(residual, 1) + " mm (" + ofToString(l_a, 0) + " and " + ofToString(l_b, 0) + " mm over a " + ofToString(span, 0) + " mm span)";
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief E-Stops every port from the monitor thread, and latches the fault.
+ * One group stop reaches every node on a port; motors without a node are stopped one by one.
+ */
+void SafetyMonitor::trip(const string& reason, std::chrono::steady_clock::time_point detected)
+{
+	tripped.store(true);
+
+	vector<int> ports_stopped;
+	for (auto& c : channels) {
+		try {
+			if (c->motor->get() == nullptr)
+				c->motor->group_stop();
+			else if (find(ports_stopped.begin(), ports_stopped.end(), c->port) == ports_stopped.end()) {
+				c->motor->group_stop();
+				ports_stopped.push_back(c->port);
+			}
+		}
+		catch (mnErr& theErr) {
+			ofLogError("SafetyMonitor::trip") << "Group stop failed on port " << c->port << ": " << theErr.ErrorMsg;
+		}
+	}
+	int64_t reaction_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - detected).count();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_fault);
+		fault = reason;
+		reaction.add(reaction_time);
+	}
+	ofLogError("SafetyMonitor") << "FAULT: " << reason << ". Stopped all motors in " << ofToString(reaction_time / 1000.0, 0) << " us.";
+}
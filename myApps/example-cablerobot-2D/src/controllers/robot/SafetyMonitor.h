@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Motor.h"
+#include "../LatencyTrace.h"
+
+/**
+ * @brief Independent safety watchdog for the cable robots.
+ *
+ * Runs on its own high-priority thread at a fixed rate, independent of the
+ * frame rate and the control threads. Each cycle it checks every motor's
+ * latest status against its limits and its desired length, and every 2D
+ * pair of cables against each other. On the first fault it E-Stops each port with a single group
+ * stop, issued directly from the monitor thread, and latches until reset.
+ *
+ * The control ticks publish each cable's length into a lock-free Channel.
+ * Measured torque is read by the monitor itself, one motor per cycle, so the
+ * extra load on the serial links stays at one round trip per cycle.
+ */
+class SafetyMonitor :
+	public ofThread
+{
+public:
+	struct Channel {
+		Motor* motor = nullptr;
+		int port = 0;
+
+		// published by the control tick
+		std::atomic<float> length_actual{ 0 };		// mm
+		std::atomic<float> length_desired{ 0 };		// mm
+		std::atomic<uint64_t> time_published{ 0 };	// us, 0 if never
+		std::atomic<bool> streaming{ false };		// velocity moves on: the tick must keep publishing
+
+		// limits, kept current by the robot
+		std::atomic<float> bounds_min{ 0 };			// mm
+		std::atomic<float> bounds_max{ 0 };			// mm
+		std::atomic<float> torque_min{ -100 };		// % of max
+		std::atomic<float> torque_max{ 100 };		// % of max
+
+		// read by the monitor thread
+		std::atomic<float> torque{ 0 };
+
+		// monitor thread only
+		float tracking_error_best = 0;			// mm, smallest error since it went over the limit
+		uint64_t tracking_since = 0;			// us the error last closed in, 0 if within the limit
+
+		void publish(float actual, float desired) {
+			length_actual.store(actual, std::memory_order_relaxed);
+			length_desired.store(desired, std::memory_order_relaxed);
+			time_published.store(ofGetElapsedTimeMicros(), std::memory_order_release);
+		}
+		void set_limits(float min, float max, float trq_min, float trq_max) {
+			bounds_min.store(min, std::memory_order_relaxed);
+			bounds_max.store(max, std::memory_order_relaxed);
+			torque_min.store(trq_min, std::memory_order_relaxed);
+			torque_max.store(trq_max, std::memory_order_relaxed);
+		}
+	};
+
+	~SafetyMonitor();
+
+	Channel* add(Motor* motor);
+	void add_pair(Channel* a, Channel* b, float span);
+	void set_span(int pair, float span);
+	void start(float rate = 1000);
+
+	bool is_tripped() { return tripped.load(); }
+	string get_fault();
+	void reset();
+
+	float get_rate() { return rate_measured.load(); }
+	float get_reaction_p99();		// us, fault detected -> group stop returned
+	float get_reaction_max();		// us
+
+	std::atomic<float> length_margin{ 25 };		// mm past the bounds before tripping
+	std::atomic<float> max_residual{ 20 };		// mm the paired cables can disagree by
+	std::atomic<float> stale_timeout{ 100 };	// ms a streaming tick may go without publishing
+	std::atomic<float> max_tracking_error{ 100 };	// mm a streaming cable may be from its desired length...
+	std::atomic<float> tracking_timeout{ 500 };		// ms ...without closing in before tripping
+
+	void threadedFunction();
+
+private:
+	struct Pair {
+		Channel* a;
+		Channel* b;
+		std::atomic<float> span{ 0 };			// mm between the pair's tangent points
+	};
+
+	vector<unique_ptr<Channel>> channels;
+	vector<unique_ptr<Pair>> pairs;
+	uint64_t interval = 1000;		// us per cycle
+	int torque_index = 0;			// next motor to read torque from
+
+	std::atomic<bool> tripped{ false };
+	std::mutex mutex_fault;
+	string fault;
+	LatencyHistogram reaction;		// ns, guarded by mutex_fault
+	std::atomic<float> rate_measured{ 0 };
+
+	bool check(uint64_t now, string& reason);
+	void trip(const string& reason, std::chrono::steady_clock::time_point detected);
+};
@@ -0,0 +1,104 @@
+#include "Simulation.h"
+
+/**
+ * @brief Reads the simulation settings from the command line:
+ * --simulate <replay.csv> [--duration s] [--rate hz] [--max-error mm]
+ */
+Simulation::Settings Simulation::Settings::parse_args(int argc, char* argv[])
+{
+	Settings settings;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool has_val = i + 1 < argc;
+		if (arg == "--simulate" && has_val) {
+			settings.enabled = true;
+			settings.replay = argv[++i];
+		}
+		else if (arg == "--duration" && has_val)
+			settings.duration = ofToFloat(argv[++i]);
+		else if (arg == "--rate" && has_val)
+			settings.rate = MAX(1.0f, ofToFloat(argv[++i]));
+		else if (arg == "--max-error" && has_val)
+			settings.max_error = ofToFloat(argv[++i]);
+	}
+	return settings;
+}
+
+void Simulation::setup(Settings settings)
+{
+	this->settings = settings;
+	tick_time.reset();
+	ticks = 0;
+	cables.clear();
+	time_start = ofGetSystemTimeMillis();
+}
+
+/**
+ * @brief Runs one control tick and collects its statistics.
+ *
+ * @param (RobotController*)  robots: offline controller to step
+ */
+void Simulation::step(RobotController* robots)
+{
+	auto start = std::chrono::steady_clock::now();
+	robots->step();
+	tick_time.add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	ticks++;
+
+	auto motors = robots->get_virtual_motors();
+	if (cables.size() != robots->get_num_robots())
+		cables.resize(robots->get_num_robots());
+	for (int i = 0; i < cables.size(); i++) {
+		// updated by the robot's compute_velocity() this tick
+		float error = robots->get_robot(i)->actual_to_desired_distance;
+		cables[i].error_sum_sq += error * error;
+		cables[i].error_max = MAX(cables[i].error_max, error);
+		if (i < motors.size())
+			cables[i].rpm_peak = motors[i]->get_velocity_peak();
+	}
+}
+
+/**
+ * @brief Returns true once the simulated time has reached the requested duration.
+ *
+ * @param (float)  time: simulated time (s)
+ */
+bool Simulation::is_done(float time)
+{
+	return settings.duration > 0 && time >= settings.duration;
+}
+
+/**
+ * @brief Writes the tick timing and per-cable tracking report, and logs it.
+ *
+ * @param (string)  filename: saved to the local /bin/data folder. Defaults to "simulation_report.txt"
+ * @return (bool)  false if any cable exceeded the maximum tracking error.
+ */
+bool Simulation::report(string filename)
+{
+	bool pass = true;
+	stringstream ss;
+	float simulated = ticks / settings.rate;
+	float wall = (ofGetSystemTimeMillis() - time_start) / 1000.0;
+
+	ss << "replay: " << settings.replay << "\n";
+	ss << "simulated: " << ofToString(simulated, 2) << "s (" << ticks << " ticks @ " << settings.rate << " Hz) in " << ofToString(wall, 2) << "s wall clock\n";
+	ss << "tick cpu (us): p50 " << ofToString(tick_time.get_percentile(50) / 1000.0, 1);
+	ss << ", p99 " << ofToString(tick_time.get_percentile(99) / 1000.0, 1);
+	ss << ", max " << ofToString(tick_time.get_max() / 1000.0, 1) << "\n";
+
+	ss << "cable,rms_error_mm,max_error_mm,peak_rpm\n";
+	for (int i = 0; i < cables.size(); i++) {
+		float rms = ticks > 0 ? sqrt(cables[i].error_sum_sq / ticks) : 0;
+		ss << i << "," << ofToString(rms, 2) << "," << ofToString(cables[i].error_max, 2) << "," << ofToString(cables[i].rpm_peak, 1) << "\n";
+		if (settings.max_error > 0 && cables[i].error_max > settings.max_error)
+			pass = false;
+	}
+	ss << (pass ? "PASS" : "FAIL") << "\n";
+
+	ofBuffer buffer;
+	buffer.set(ss.str());
+	ofBufferToFile(filename, buffer);
+	ofLogNotice("Simulation::report") << "\n" << ss.str();
+	return pass;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ofMain.h"
+#include "RobotController.h"
+#include "../LatencyTrace.h"
+
+/**
+ * @brief Headless batch run of the controller against virtual motors.
+ *
+ * The app replays a recorded OSC session into an offline RobotController and
+ * steps it once per frame on a fixed clock, so a run is repeatable and can go
+ * faster than real time. Every tick is timed, and every cable's tracking error
+ * (actual vs. desired length) and peak speed are collected into a report.
+ */
+class Simulation
+{
+public:
+	struct Settings {
+		bool enabled = false;
+		string replay;				// OSC session in the local /bin/data folder
+		float duration = 0;			// s, 0 runs to the end of the replay
+		float rate = 60;			// control ticks per simulated second
+		float max_error = 0;		// mm, fails the run if any cable exceeds it (0 to ignore)
+
+		static Settings parse_args(int argc, char* argv[]);
+	};
+
+	void setup(Settings settings);
+	void step(RobotController* robots);
+	bool is_done(float time);
+
+	bool report(string filename = "simulation_report.txt");
+
+	Settings get_settings() { return settings; }
+
+private:
+	Settings settings;
+	LatencyHistogram tick_time;		// ns of CPU per control tick
+	uint64_t ticks = 0;
+	uint64_t time_start = 0;		// wall clock, ms
+
+	struct Cable {
+		double error_sum_sq = 0;	// mm^2
+		float error_max = 0;		// mm
+		float rpm_peak = 0;
+	};
+	vector<Cable> cables;
+};
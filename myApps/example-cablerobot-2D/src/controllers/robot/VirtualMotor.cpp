@@ -0,0 +1,200 @@
+#include "VirtualMotor.h"
+
+VirtualMotor::VirtualMotor(NodeInfo info) :
+	Motor(info) {
+}
+
+/**
+ * @brief Places the motor at a position, as if it had just been homed there.
+ *
+ * @param (double)  counts: position (in counts)
+ */
+void VirtualMotor::set_position_counts(double counts)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	position_commanded = counts;
+	position_measured = counts;
+	position_target = counts;
+}
+
+/**
+ * @brief Returns the fastest the motor has turned since the last reset.
+ *
+ * @return (float)  peak measured velocity (RPM)
+ */
+float VirtualMotor::get_velocity_peak()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return vel_peak;
+}
+
+void VirtualMotor::reset_velocity_peak()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	vel_peak = 0;
+}
+
+void VirtualMotor::set_motion_params(float limit_vel, float limit_accel, int limit_trq_percent)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	vel_limit = limit_vel;
+	accel_limit = limit_accel;
+}
+
+void VirtualMotor::stop(nodeStopCodes stop_type)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	advance();
+	vel_target = 0;
+	move_to_position = false;
+	// an abrupt stop drops the commanded velocity at once; the velocity loop still lags
+	vel_commanded = 0;
+}
+
+/**
+ * @brief Applies the soft position limits like the node does; torque is not modeled.
+ */
+void VirtualMotor::set_hardware_limits(int position_min, int position_max, float torque_min, float torque_max)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	has_soft_limits = true;
+	soft_limit_min = position_min;
+	soft_limit_max = position_max;
+}
+
+void VirtualMotor::set_e_stop(bool val)
+{
+	if (val)
+		stop();
+	std::lock_guard<std::mutex> lock(mutex);
+	estopped = val;
+}
+
+void VirtualMotor::set_enabled(bool val)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	advance();
+	enabled = val;
+}
+
+int64_t VirtualMotor::get_position(bool get_actual_pos)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	advance();
+	return int64_t(floor(get_actual_pos ? position_measured : position_commanded));
+}
+
+float VirtualMotor::get_velocity()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return vel_limit;
+}
+
+float VirtualMotor::get_velocity_actual()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	advance();
+	return vel_measured;
+}
+
+void VirtualMotor::set_velocity(float val)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	vel_limit = val;
+}
+
+float VirtualMotor::get_acceleration()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return accel_limit;
+}
+
+void VirtualMotor::set_acceleration(float val)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	accel_limit = val;
+}
+
+void VirtualMotor::move_position(int target_pos, bool is_absolute, bool add_dwell)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	advance();
+	position_target = is_absolute ? target_pos : position_commanded + target_pos;
+	move_to_position = true;
+}
+
+void VirtualMotor::move_velocity(float target_vel)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	advance();
+	vel_target = target_vel;
+	move_to_position = false;
+}
+
+bool VirtualMotor::is_estopped()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return estopped;
+}
+
+bool VirtualMotor::is_enabled()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return enabled;
+}
+
+bool VirtualMotor::is_moving()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	advance();
+	return move_to_position || abs(vel_measured) > 0.01;
+}
+
+/**
+ * @brief Integrates the motor up to the app's current time. Call with the mutex held.
+ */
+void VirtualMotor::advance()
+{
+	// microseconds keep the step exact over thousands of simulated seconds
+	double t = ofGetElapsedTimeMicros() / 1000000.0;
+	if (time_last < 0)
+		time_last = t;
+	float dt = t - time_last;
+	if (dt <= 0)
+		return;
+	time_last = t;
+
+	// substep so the velocity loop stays stable at low frame rates
+	int steps = ceil(dt / 0.001);
+	float h = dt / steps;
+	float counts_per_rpm = get_resolution() / 60.0;	// counts/s per RPM
+	for (int i = 0; i < steps; i++) {
+		float target = vel_target;
+		if (move_to_position) {
+			// trapezoidal profile: brake at the acceleration limit to land on the target
+			double remaining = position_target - position_commanded;
+			float vel_brake = 60 * sqrt(2 * (accel_limit / 60) * abs(remaining) / get_resolution());
+			target = ofSign(remaining) * MIN(vel_limit, vel_brake);
+			if (abs(remaining) < 0.5) {
+				position_commanded = position_target;
+				move_to_position = false;
+				vel_commanded = 0;
+				target = 0;
+			}
+		}
+		if (!enabled || estopped)
+			target = 0;
+		// a move past a soft limit is canceled
+		if (has_soft_limits && ((position_commanded <= soft_limit_min && target < 0) || (position_commanded >= soft_limit_max && target > 0))) {
+			move_to_position = false;
+			vel_commanded = 0;
+			target = 0;
+		}
+
+		vel_commanded += ofClamp(target - vel_commanded, -accel_limit * h, accel_limit * h);
+		vel_measured += (vel_commanded - vel_measured) * MIN(1.0f, h / time_constant);
+		position_commanded += vel_commanded * counts_per_rpm * h;
+		position_measured += vel_measured * counts_per_rpm * h;
+		vel_peak = MAX(vel_peak, abs(vel_measured));
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Motor.h"
+
+/**
+ * @brief Simulated Clearpath-SC motor, for running the controller without hardware.
+ *
+ * The motor's trajectory generator ramps the commanded velocity toward the
+ * target at the acceleration limit, and a first-order velocity loop makes the
+ * measured velocity lag behind it. Positions are integrated in encoder counts
+ * and reported as whole counts, like a real encoder.
+ *
+ * The model advances to the app's elapsed time whenever it is read or commanded,
+ * so it follows the app's clock: real time normally, or a fixed step per frame
+ * when simulating faster than real time.
+ */
+class VirtualMotor :
+	public Motor
+{
+public:
+	VirtualMotor(NodeInfo info);
+
+	void set_position_counts(double counts);
+	float get_velocity_peak();
+	void reset_velocity_peak();
+
+	float time_constant = 0.02;		// velocity loop (s)
+
+	void set_motion_params(float limit_vel = 200, float limit_accel = 400, int limit_trq_percent = 100);
+	void enable() { set_enabled(true); }
+	void disable() { set_enabled(false); }
+	void stop(nodeStopCodes stop_type = STOP_TYPE_ABRUPT);
+	void group_stop(nodeStopCodes stop_type = STOP_TYPE_ESTOP_ABRUPT) { set_e_stop(true); }	// no port: stops this motor only
+	void set_hardware_limits(int position_min, int position_max, float torque_min, float torque_max);
+	void arm_group_shutdown(nodeStopCodes stop_type = STOP_TYPE_ESTOP_ABRUPT) {}
+	void set_e_stop(bool val);
+	void set_enabled(bool val);
+
+	int64_t get_position(bool get_actual_pos = true);
+
+	float get_velocity();
+	float get_velocity_actual();
+	void set_velocity(float val);
+	float get_acceleration();
+	void set_acceleration(float val);
+	float get_torque() { return 0; }
+
+	void move_position(int target_pos, bool is_absolute, bool add_dwell = false);
+	void move_velocity(float target_vel);
+
+	bool is_estopped();
+	bool is_homed() { return true; }
+	bool is_enabled();
+	bool is_moving();
+
+	bool run_homing_routine(int _timeout = 20) { return true; }
+
+private:
+	std::mutex mutex;
+	double time_last = -1;		// s
+
+	float vel_limit = 200;			// RPM
+	float accel_limit = 400;		// RPM/s
+	bool enabled = true;
+	bool estopped = false;
+
+	float vel_target = 0;			// RPM
+	bool move_to_position = false;
+	double position_target = 0;		// counts
+
+	float vel_commanded = 0;		// RPM, from the trajectory generator
+	float vel_measured = 0;			// RPM, after the velocity loop
+	double position_commanded = 0;	// counts
+	double position_measured = 0;	// counts
+	float vel_peak = 0;
+
+	bool has_soft_limits = false;
+	double soft_limit_min = 0;		// counts
+	double soft_limit_max = 0;		// counts
+
+	void advance();
+};
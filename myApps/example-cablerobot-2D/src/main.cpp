@@ -2,7 +2,29 @@
 #include "ofApp.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+	// headless batch simulation:
+	// --simulate <replay.csv> [--duration s] [--rate hz] [--max-error mm]
+	Simulation::Settings simulation = Simulation::Settings::parse_args(argc, argv);
+	// headless benchmarks of the control tick:
+	// --benchmark [--label name] [--min-time s] [--repetitions n] [--threshold %]
+	Benchmark::Settings benchmark = Benchmark::Settings::parse_args(argc, argv);
+	// headless correctness checks:
+	// --self-test
+	bool self_test = false;
+	for (int i = 1; i < argc; i++)
+		if (string(argv[i]) == "--self-test")
+			self_test = true;
+	if (simulation.enabled || benchmark.enabled || self_test) {
+		ofAppNoWindow window;
+		ofSetupOpenGL(&window, 1920, 1080, OF_WINDOW);
+		ofApp* app = new ofApp();
+		app->simulation_settings = simulation;
+		app->benchmark_settings = benchmark;
+		app->self_test = self_test;
+		return ofRunApp(app);
+	}
+
 	ofSetupOpenGL(1920,1080,OF_WINDOW);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
@@ -5,6 +5,7 @@ void ofApp::setup() {
 	ofSetLogLevel(OF_LOG_NOTICE);
 	ofLogToConsole();
 	ofSetCircleResolution(60);
+	LatencyTrace::set_thread_name("app");
 
 	setup_gui();
 	setup_comms();
@@ -31,7 +32,7 @@ void ofApp::setup() {
 	// set the world coordinate system of the robots (flip to match screen coord axes)
 	origin.rotateAroundDeg(180, glm::vec3(1, 0, 0), glm::vec3(0, 0, 0));
 	origin.setGlobalPosition(-1 * (positions[0].x + positions[1].x) / 2.0, 0, 0);
-	robots = new RobotController(positions, &origin);
+	robots = new RobotController(positions, &origin, simulation_settings.enabled || benchmark_settings.enabled || self_test);
 	motion = new MotionController(positions, &origin, offset_z);
 
 	//agents = new AgentController();
@@ -51,6 +52,29 @@ void ofApp::setup() {
 
 	ofSetFrameRate(60);
 
+	// batch simulation: replay an OSC session into virtual motors on a fixed clock, as fast as possible
+	if (simulation_settings.enabled) {
+		// a missing or empty replay would run nothing and report a pass
+		if (!osc_replay.load(simulation_settings.replay)) {
+			ofLogError("ofApp::setup") << "Simulation FAILED: no OSC messages to replay from: /bin/data/" << simulation_settings.replay;
+			simulation_settings.enabled = false;
+			ofExit(1);
+		}
+		else {
+			if (simulation_settings.duration <= 0)
+				simulation_settings.duration = osc_replay.get_duration() + 2;	// let the robots settle
+			simulation.setup(simulation_settings);
+			ofSetTimeModeFixedRate(ofGetFixedStepForFps(simulation_settings.rate));
+			ofSetFrameRate(0);
+		}
+	}
+	else if (benchmark_settings.enabled) {
+		run_benchmarks();
+	}
+	else if (self_test) {
+		run_self_tests();
+	}
+
 	// Nest the robot panel under the OSC panel
 	robots->panel.setPosition(panel.getPosition().x, panel.getPosition().y + panel.getHeight() + 250);
 
@@ -72,13 +96,33 @@ void ofApp::update() {
 
 	skeleton = sensor_comms.get_data();
 
-	if (osc_status.get() == "CONNECTED") {
+	if (robots->is_offline()) {
+		// feed the recorded messages that are due on the simulated clock
+		ofxOscMessage m;
+		while (osc_replay.get_next_message(ofGetElapsedTimef(), m))
+			handle_message(m);
+	}
+	else if (osc_status.get() == "CONNECTED") {
 		check_for_messages();
 	}
 
+	// baked choreography overrides live drawing and geometric motion
+	if (choreography.is_playing()) {
+		auto targets = choreography.get_targets();
+		vector<float> x, y;
+		for (auto& target : targets) {
+			x.push_back(target.x);
+			y.push_back(target.y);
+		}
+		robots->set_targets(x, y);
+	}
 	// handle the master drawing all robots should follow first
-	if (path_drawing.getVertices().size()) {// > zone_drawing_length.get()) {
-		update_path(&path_drawing, path_drawing.getVertices().back());
+	else if (!path_drawing.empty()) {// > zone_drawing_length.get()) {
+		if (motion->motion_drawing_smooth) {
+			motion->apply_smoothing(&smoother_drawing);
+			smoother_drawing.update(ofGetLastFrameTime());
+		}
+		update_path(&path_drawing, path_drawing.back());
 	}
 	// handle geometric and individual movements second
 	else {
@@ -132,6 +176,21 @@ void ofApp::update() {
 	// @NOTE 8/18/2023: this is doing it by itself for some reason
 	//disable_camera(robots->disable_camera());
 	}
+
+	if (simulation_settings.enabled)
+		update_simulation();
+}
+
+/**
+ * @brief Steps the offline robots once, and exits with the report once the run is done.
+ */
+void ofApp::update_simulation()
+{
+	simulation.step(robots);
+	if (simulation.is_done(ofGetElapsedTimef())) {
+		bool pass = simulation.report();
+		ofExit(pass ? 0 : 1);
+	}
 }
 
 void ofApp::draw()
@@ -139,6 +198,9 @@ void ofApp::draw()
 	ofBackgroundGradient(background_inner, background_outer);
 	cam.begin();
 
+	// lines and shapes are collected here, and drawn together after the robots
+	batch.begin();
+
 	// draw the floor plane
 	ofSetColor(200, 180);
 	ofPushMatrix();
@@ -151,35 +213,31 @@ void ofApp::draw()
 	draw_zones();
 	draw_sensor_path();
 	draw_path(&path_drawing);
+	if (motion->motion_drawing_smooth)
+		smoother_drawing.draw(batch);
 
 	gizmo_sensor.draw(cam);
 
 	// draw the axis and planes
-	ofPushStyle();
 	//ofDrawGridPlane(1000, 10, true);
-	ofSetLineWidth(3);
-	ofSetColor(ofColor::blue, 200);
-	ofLine(glm::vec3(0, 0, 0), glm::vec3(0, 0, 10000));
-	ofSetColor(ofColor::blue, 80);
-	ofLine(glm::vec3(0, 0, 0), glm::vec3(0, 0, -10000));
-	ofSetColor(ofColor::green, 200);
-	ofLine(glm::vec3(0, 0, 0), glm::vec3(0, 10000, 0));
-	ofSetColor(ofColor::green, 80);
-	ofLine(glm::vec3(0, 0, 0), glm::vec3(0, -10000, 0));
-	ofSetColor(ofColor::red, 200);
-	ofLine(glm::vec3(0, 0, 0), glm::vec3(10000, 0, 0));
-	ofSetColor(ofColor::red, 80);
-	ofLine(glm::vec3(0, 0, 0), glm::vec3(-10000, 0, 0));
-	ofPopStyle();
+	batch.add_line(glm::vec3(0, 0, 0), glm::vec3(0, 0, 10000), ofColor(ofColor::blue, 200), 3);
+	batch.add_line(glm::vec3(0, 0, 0), glm::vec3(0, 0, -10000), ofColor(ofColor::blue, 80), 3);
+	batch.add_line(glm::vec3(0, 0, 0), glm::vec3(0, 10000, 0), ofColor(ofColor::green, 200), 3);
+	batch.add_line(glm::vec3(0, 0, 0), glm::vec3(0, -10000, 0), ofColor(ofColor::green, 80), 3);
+	batch.add_line(glm::vec3(0, 0, 0), glm::vec3(10000, 0, 0), ofColor(ofColor::red, 200), 3);
+	batch.add_line(glm::vec3(0, 0, 0), glm::vec3(-10000, 0, 0), ofColor(ofColor::red, 80), 3);
 
 	// draw the motion controller
-	motion->draw();
+	motion->draw(batch);
+	choreography.draw();
 
 	// draw the robots
-	robots->draw();
+	robots->draw(batch);
 
 	// draw the agents
-	//agents->draw();
+	//agents->draw(batch);
+
+	batch.end();
 
 	// draw all the gizmos
 	for (auto gizmo : robots->get_gizmos())
@@ -198,6 +256,13 @@ void ofApp::draw()
 	ofDrawBitmapStringHighlight(ofToString(ofGetFrameRate()), ofGetWidth() - 100, 20);
 }
 
+//--------------------------------------------------------------
+void ofApp::exit() {
+	// stop the control loop, then let the robots finish their last config save and close the ports
+	robots->waitForThread(true);
+	robots->shutdown();
+}
+
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key) {
 
@@ -312,6 +377,7 @@ void ofApp::setup_gui()
 	params.add(osc_port_listening.set("Listening_Port", 55555));
 	params.add(osc_connect.set("CONNECT"));
 	params.add(osc_status.set("Status", "DISCONNECTED"));
+	params.add(osc_record.set("Record_Session", false));
 
 	params_zones.setName("Zone_Params");
 	params_zone_sensor.setName("Zone_Sensor");
@@ -350,8 +416,33 @@ void ofApp::setup_gui()
 
 	panel.add(params);
 	panel.add(params_zones);
+	panel.add(formation.params);
+	panel.add(choreography.params);
 
 	osc_connect.addListener(this, &ofApp::on_osc_connect);
+	osc_record.addListener(this, &ofApp::on_osc_record);
+	choreography.btn_load.addListener(this, &ofApp::on_choreography_load);
+}
+
+/**
+ * @brief Checks each loaded trajectory against its robot's velocity and
+ * acceleration limits, so problems show up before the show instead of during it.
+ */
+void ofApp::validate_choreography()
+{
+	int count = MIN(choreography.trajectories.size(), robots->get_num_robots_2D());
+	if (choreography.trajectories.size() != robots->get_num_robots_2D()) {
+		ofLogWarning(__FUNCTION__) << "Choreography has " << choreography.trajectories.size() << " trajectories for " << robots->get_num_robots_2D() << " robots.";
+	}
+	for (int i = 0; i < count; i++) {
+		auto robot = robots->get_robot_2D(i);
+		choreography.validate(i, robot->get_anchors(), robot->get_bounds(), robots->get_target(i), robot->get_mm_per_rev(), robot->vel_limit.get(), robot->accel_limit.get());
+	}
+}
+
+void ofApp::on_choreography_load()
+{
+	validate_choreography();
 }
 
 void ofApp::on_zone_pos_changed(glm::vec3& val)
@@ -401,6 +492,283 @@ void ofApp::on_osc_connect()
 	}
 }
 
+/**
+ * @brief Times each operation of the control tick on virtual robots, and exits with the report.
+ */
+void ofApp::run_benchmarks()
+{
+	benchmark.setup(benchmark_settings);
+
+	// initialize the virtual robots
+	robots->step();
+
+	benchmark_conversions();
+	benchmark_solver_3D();
+	benchmark_pd_controller();
+	benchmark_paths();
+	benchmark_motion();
+	benchmark_agents();
+	benchmark_integrator();
+	benchmark_osc();
+
+	bool pass = benchmark.report();
+	ofExit(pass ? 0 : 1);
+}
+
+/**
+ * @brief Cable length conversions, one motor at a time and all the motors in one pass.
+ */
+void ofApp::benchmark_conversions()
+{
+	auto robot = robots->get_robot(0);
+
+	benchmark.run("CableRobot::compute_velocity", [&]() { Benchmark::keep(robot->compute_velocity()); });
+	int64_t count = 0;
+	benchmark.run("CableRobot::count_to_mm", [&]() { Benchmark::keep(robot->count_to_mm(count++)); });
+	float mm = 0;
+	benchmark.run("CableRobot::mm_to_count", [&]() { Benchmark::keep(robot->mm_to_count(mm += 0.1)); });
+
+	// all the motors converted in one pass, as in the control tick, through each drum's length model
+	int num_motors = robots->get_num_robots();
+	vector<int64_t> counts(num_motors);
+	vector<CountScale> scales(num_motors), scales_linear(num_motors);
+	vector<float> torques(num_motors, 20);
+	vector<float> mms(num_motors);
+	for (int i = 0; i < num_motors; i++) {
+		scales[i] = robots->get_robot(i)->get_scale();
+		scales_linear[i] = CountScale::from_drum(scales[i].model ? scales[i].model->get_mm_per_rev() : 0, robots->get_robot(i)->get_motor_controller()->get_motor()->get_resolution());
+	}
+	benchmark.run("CableRobot::get_scale", [&]() { Benchmark::keep(robot->get_scale().mm_per_count); });
+	benchmark.run("CountScale::to_mm (all motors)", [&]() {
+		for (auto& c : counts)
+			c++;
+		CountScale::to_mm(counts.data(), scales.data(), mms.data(), num_motors, true, torques.data());
+		Benchmark::keep(mms[0]);
+	});
+	benchmark.run("CountScale::to_mm (all motors, linear)", [&]() {
+		for (auto& c : counts)
+			c++;
+		CountScale::to_mm(counts.data(), scales_linear.data(), mms.data(), num_motors, true);
+		Benchmark::keep(mms[0]);
+	});
+}
+
+/**
+ * @brief 3D cable solver, with 4 to 8 cables.
+ */
+void ofApp::benchmark_solver_3D()
+{
+	// one 3D end effector per op, hung from the corners (and edge midpoints) of a 6 x 4 m frame;
+	// a control tick runs forward, distribute and inverse once (budget: 100 us at 250 Hz)
+	for (int num_cables : { 4, 6, 8 }) {
+		CableSolver3D solver;
+		solver.set_num_cables(num_cables);
+		for (int i = 0; i < num_cables; i++) {
+			float a = TWO_PI * i / num_cables;
+			solver.set_anchor(i, glm::vec3(3000 + 3000 * cos(a), 3000, 2000 + 2000 * sin(a)));
+			solver.set_attachment(i, glm::vec3(0));
+		}
+		solver.force = glm::dvec3(0, -9.81 * 2, 0);
+		vector<double> lengths(num_cables), tensions(num_cables);
+		glm::dvec3 target(3000, 1000, 2000), estimate = target;
+		float t = 0;
+		auto move = [&]() {
+			t += 0.01;
+			target = glm::dvec3(3000 + 1000 * cos(t), 1000 + 200 * sin(3 * t), 2000 + 800 * sin(t));
+		};
+
+		benchmark.run("CableSolver3D::inverse/" + ofToString(num_cables), [&]() {
+			move();
+			solver.inverse(target, lengths.data());
+			Benchmark::keep(lengths[0]);
+		});
+		benchmark.run("CableSolver3D::forward/" + ofToString(num_cables), [&]() {
+			move();
+			solver.inverse(target, lengths.data());
+			solver.forward(lengths.data(), estimate);
+			Benchmark::keep(estimate.x);
+		});
+		benchmark.run("CableSolver3D::distribute/" + ofToString(num_cables), [&]() {
+			move();
+			Benchmark::keep(solver.distribute(target, tensions.data()));
+		});
+		benchmark.run("CableSolver3D::tick/" + ofToString(num_cables), [&]() {
+			move();
+			solver.forward(lengths.data(), estimate);
+			Benchmark::keep(solver.distribute(target, tensions.data()));
+			solver.inverse(target, lengths.data());
+		});
+	}
+}
+
+/**
+ * @brief PD controller update.
+ */
+void ofApp::benchmark_pd_controller()
+{
+	PD_Controller pd;
+	float setpoint = 0;
+	benchmark.run("PD_Controller::update", [&]() {
+		setpoint = 1 - setpoint;
+		pd.update(setpoint);
+		Benchmark::keep(pd.get_smoothed_val());
+	});
+}
+
+/**
+ * @brief Sampling drawing paths of a few hundred to a few thousand points.
+ */
+void ofApp::benchmark_paths()
+{
+	// drawing paths run from a few hundred to a few thousand points
+	for (int size : { 100, 1000, 10000 }) {
+		ofPolyline path;
+		for (int i = 0; i < size; i++)
+			path.addVertex(ofRandom(-3000, 3000), ofRandom(-5000, 0));
+		float t = 0;
+		benchmark.run("ofPolyline::getPointAtPercent/" + ofToString(size), [&]() {
+			t = fmod(t + 0.618034f, 1.0f);
+			Benchmark::keep(path.getPointAtPercent(t));
+		});
+	}
+}
+
+/**
+ * @brief MotionController update, with 4 to 32 targets.
+ */
+void ofApp::benchmark_motion()
+{
+	for (int num_targets : { 4, 8, 16, 32 }) {
+		vector<glm::vec3> bases;
+		for (int j = 0; j < num_targets; j++) {
+			bases.push_back(glm::vec3(0, 0, -140 * j));
+			bases.push_back(glm::vec3(6100, 0, -140 * j));
+		}
+		MotionController motion_n(bases, &origin, -140);
+		motion_n.motion_line_follow.set(true);
+		benchmark.run("MotionController::update/" + ofToString(num_targets), [&]() { motion_n.update(); });
+	}
+}
+
+/**
+ * @brief Agent steering queries, brute force vs. the spatial hash.
+ */
+void ofApp::benchmark_agents()
+{
+	// agents spread over an area that grows with their number, so the crowd keeps the same density
+	for (int num_agents : { 4, 64, 1024, 10000 }) {
+		float half_width = 250 * sqrt(float(num_agents));
+		vector<Agent*> agents_n;
+		SpatialHash hash;
+		for (int i = 0; i < num_agents; i++) {
+			agents_n.push_back(new Agent());
+			agents_n.back()->setup(i);
+			agents_n.back()->pose.setGlobalPosition(ofRandom(-half_width, half_width), ofRandom(-half_width, half_width) - 2500, 0);
+			hash.add(agents_n.back()->pose.getGlobalPosition(), agents_n.back()->get_velocity(), agents_n.back()->radius);
+		}
+		hash.build();
+
+		// one query per op: a frame costs num_agents queries (plus one build for the hash)
+		int i = 0;
+		benchmark.run("Agent::separate/" + ofToString(num_agents), [&]() {
+			Benchmark::keep(agents_n[i]->separate(agents_n));
+			i = (i + 1) % num_agents;
+		});
+		benchmark.run("SpatialHash::separate/" + ofToString(num_agents), [&]() {
+			Benchmark::keep(hash.separate(i));
+			i = (i + 1) % num_agents;
+		});
+		benchmark.run("SpatialHash::cohere/" + ofToString(num_agents), [&]() {
+			Benchmark::keep(hash.cohere(i, 2 * hash.radius[i]));
+			i = (i + 1) % num_agents;
+		});
+		benchmark.run("SpatialHash::align/" + ofToString(num_agents), [&]() {
+			Benchmark::keep(hash.align(i, 2 * hash.radius[i]));
+			i = (i + 1) % num_agents;
+		});
+		benchmark.run("SpatialHash::build/" + ofToString(num_agents), [&]() {
+			hash.build();
+		});
+		for (auto agent : agents_n)
+			delete agent;
+	}
+}
+
+/**
+ * @brief Agent integration, with 64 to 100k agents.
+ */
+void ofApp::benchmark_integrator()
+{
+	ofLogNotice("ofApp::benchmark_integrator") << "AgentIntegrator is " << (AgentIntegrator::is_vectorized() ? "AVX2" : "scalar");
+	for (int num_agents : { 64, 1024, 10000, 100000 }) {
+		AgentIntegrator integrator;
+		integrator.resize(num_agents);
+		for (int i = 0; i < num_agents; i++) {
+			integrator.set_position(i, glm::vec3(ofRandom(-3000, 3000), ofRandom(-5000, 0), ofRandom(0, 1000)));
+			integrator.set_target(i, glm::vec3(ofRandom(-3000, 3000), ofRandom(-5000, 0), 0));
+		}
+		benchmark.run("AgentIntegrator::step/" + ofToString(num_agents), [&]() {
+			integrator.step(1 / 60., glm::vec3(0, 0, -1));
+		});
+	}
+}
+
+/**
+ * @brief OSC dispatch through handle_message.
+ */
+void ofApp::benchmark_osc()
+{
+	ofxOscMessage m;
+	m.setAddress("/drawing/tgt_norm");
+	m.addFloatArg(0.5);
+	m.addFloatArg(0.5);
+	benchmark.run("ofApp::handle_message", [&]() { handle_message(m); });
+}
+
+/**
+ * @brief Runs the correctness checks that need the app's controllers, and exits non-zero if any fails.
+ */
+void ofApp::run_self_tests()
+{
+	bool pass = true;
+	pass &= test_path_smoother();
+	ofLogNotice("ofApp::run_self_tests") << (pass ? "PASS" : "FAIL");
+	ofExit(pass ? 0 : 1);
+}
+
+/**
+ * @brief A long step that spans several of the smoother's segments still covers velocity * dt.
+ */
+bool ofApp::test_path_smoother()
+{
+	bool pass = true;
+	PathSmoother smoother(32);
+	smoother.accel_max = 1000000;
+	for (int i = 0; i < 30; i++)
+		smoother.add_point(glm::vec3(i * 50, 0, 0));
+	smoother.update(0.01);
+	for (int i = 0; i < 3; i++) {
+		float x = smoother.get_reference().x;
+		float moved = smoother.update(0.5).x - x;
+		if (abs(moved - smoother.get_velocity() * 0.5) > 1) {
+			ofLogError("ofApp::test_path_smoother") << "PathSmoother moved " << moved << " mm in a 0.5 s step, expected " << smoother.get_velocity() * 0.5 << " mm.";
+			pass = false;
+		}
+	}
+	return pass;
+}
+
+/**
+ * @brief Records the incoming OSC session, for replaying in a batch simulation.
+ */
+void ofApp::on_osc_record(bool& val)
+{
+	if (val)
+		osc_replay.start_recording();
+	else
+		osc_replay.stop_recording();
+}
+
 void ofApp::setup_sensors()
 {
 	sensor.setGlobalPosition(0, -3350, -140 * 3);
@@ -511,24 +879,22 @@ void ofApp::update_sensor_path()
 		auto chest = skeleton[K4ABT_JOINT_SPINE_CHEST]->getGlobalPosition();
 
 		if (hand_right.y > chest.y) {
-			if (path_sensor.getVertices().size() == 0)
-				path_sensor.addVertex(hand_right);
+			// the oldest point is dropped once the path is at capacity
+			if (path_sensor.empty())
+				path_sensor.push(hand_right);
 			else {
 				// filter out small differences
 				float dist_thresh = 10;
-				float dist_sq = glm::distance2(path_sensor.getVertices().back(), hand_right);
+				float dist_sq = glm::distance2(path_sensor.back(), hand_right);
 				if (dist_sq > dist_thresh * dist_thresh) {
-					path_sensor.addVertex(hand_right);
+					path_sensor.push(hand_right);
 				}
 			}
 		}
-		// remove that oldest point if we're over a certain size
-		if (path_sensor.getVertices().size() > 50)
-			path_sensor.removeVertex(0);
 	}
 	// clear the path if we stepped outside the zone
 	else {
-		if (path_sensor.getVertices().size() > 0)
+		if (!path_sensor.empty())
 			path_sensor.clear();
 	}
 }
@@ -542,7 +908,7 @@ void ofApp::draw_sensor_path()
 	ofPopStyle();
 }
 
-void ofApp::update_drawing_path(ofPolyline* path, glm::vec3 pt)
+void ofApp::update_drawing_path(PathQueue* path, glm::vec3 pt)
 {
 	// map incoming point to drawing zone
 	float bounds_x_min = zone_drawing.getTopLeft().x;
@@ -556,86 +922,64 @@ void ofApp::update_drawing_path(ofPolyline* path, glm::vec3 pt)
 	update_path(path, glm::vec3(x, y, 0));
 }
 
-void ofApp::update_path(ofPolyline* path, glm::vec3 pt)
+void ofApp::update_path(PathQueue* path, glm::vec3 pt)
 {
-	if (path->getVertices().size() == 0) {
-		path->addVertex(pt);
+	if (path->empty()) {
+		path->push(pt);
 	}
 	else {
 		// filter out small moves
 		float dist_thresh = 20;
-		float dist_sq = glm::distance2(path->getVertices().back(), pt);
+		float dist_sq = glm::distance2(path->back(), pt);
 		if (dist_sq > dist_thresh * dist_thresh) {
-			path->addVertex(pt);
+			path->push(pt);
 
 		}
 	}
+	if (motion->motion_drawing_smooth) {
+		smoother_drawing.add_point(pt);
+	}
 	// cap the length of the path
-	if (path->getVertices().size() > motion->motion_drawing_length_max.get()) {
-		path->removeVertex(0);
+	while (path->size() > motion->motion_drawing_length_max.get()) {
+		path->pop();
 	}
 
 	// move the robots
-	if (path->getVertices().size() > 2) {	// POLYLINE MUST HAVE AT LEAST 3 POINTS, OTHERWISE SENDS TO (0,0,0)
+	bool smoothing = motion->motion_drawing_smooth.get() && !smoother_drawing.is_empty();
+	if (smoothing || path->size() > 2) {	// wait for a few points before following the drawing
 
 		float dist_thresh = motion->motion_drawing_accuracy.get();// zone_drawing_accuracy.get();
 
-		auto pt_0 = path->getPointAtPercent(0.0);
-		auto pt_1 = robots->get_target(0);// path_drawing.getPointAtPercent(0.33);
-		auto pt_2 = robots->get_target(1);// path_drawing.getPointAtPercent(0.66);
-		auto pt_3 = robots->get_target(2);// path_drawing.getPointAtPercent(1.0);
-		/*auto pt_1 = path_drawing.getPointAtPercent(0.33);
-		auto pt_2 = path_drawing.getPointAtPercent(0.66);
-		auto pt_3 = path_drawing.getPointAtPercent(1.0);*/
-
-		//cout << "robots->get_target(0): " << robots->get_target(0) << ", pt_0: " << pt_0 << endl;
-		auto mid_pt = robots->get_target(3);
-		float dist_sq = glm::distance2(pt_0, glm::vec3(mid_pt.x, mid_pt.y, 0));
-		if (dist_sq < dist_thresh * dist_thresh) {
-			path->removeVertex(0);
-			pt_0 = path_drawing.getPointAtPercent(0.0);
-
-
-
-			//pt_1 = robots->get_target(0);// path_drawing.getPointAtPercent(0.33);
-			//pt_2 = robots->get_target(1);// path_drawing.getPointAtPercent(0.66);
-			//pt_3 = robots->get_target(2);// path_drawing.getPointAtPercent(1.0);
+		// read the robot positions once for the whole formation
+		auto actual = robots->get_actual_positions();
+		if (actual.size() == 0)
+			return;
+
+		auto pt_0 = path->front();
+		auto leader = actual.back();
+		float dist_sq = glm::distance2(pt_0, glm::vec3(leader.x, leader.y, 0));
+		// the smoother advances the leader continuously along the spline (see ofApp::update)
+		if (smoothing) {
+			pt_0 = smoother_drawing.get_reference();
+		}
+		else if (dist_sq < dist_thresh * dist_thresh) {
+			path->pop();
+			pt_0 = path->front();
 		}
 
-		robots->set_target(3, pt_0.x, pt_0.y);
 		// follow the leader
 		if (zone_drawing_follow.get()) {
-			float offset = zone_drawing_follow_offset.get(); //300;
-
-			// send them to the same point
-			if (offset < 50) {
-				robots->set_target(2, pt_0.x, pt_0.y);
-				robots->set_target(1, pt_0.x, pt_0.y);
-				robots->set_target(0, pt_0.x, pt_0.y);
-			}
-			// follow the leader with the given offset
-			else {
-				auto heading = robots->get_target(3) - pt_0;
-				auto p = glm::normalize(heading) * offset;
-				p += robots->get_target(3);
-				robots->set_target(2, p.x, p.y);
-
-				heading = robots->get_target(2) - p;
-				p = glm::normalize(heading) * offset;
-				p += robots->get_target(2);
-				robots->set_target(1, p.x, p.y);
-
-				heading = robots->get_target(1) - p;
-				p = glm::normalize(heading) * offset;
-				p += robots->get_target(1);
-				robots->set_target(0, p.x, p.y);
-			}
+			formation.resize(actual.size());
+			formation.update(pt_0, actual, zone_drawing_follow_offset.get());
+			robots->set_targets(formation.x, formation.y);
+		}
+		else {
+			robots->set_target(actual.size() - 1, pt_0.x, pt_0.y);
 		}
-
 	}
 }
 
-void ofApp::draw_path(ofPolyline* path)
+void ofApp::draw_path(PathQueue* path)
 {
 	ofPushStyle();
 	ofNoFill();
@@ -708,336 +1052,359 @@ void ofApp::check_for_messages()
 		// get the next message
 		ofxOscMessage m;
 		osc_receiver.getNextMessage(m);
+		LatencyTrace::begin(LatencyTrace::OSC_RECEIVE);
+		if (osc_record.get())
+			osc_replay.record(m, ofGetElapsedTimef());
+		handle_message(m);
+	}
+}
 
-		float bounds_x_min = zone_drawing.getTopLeft().x;
-		float bounds_x_max = zone_drawing.getBottomRight().x;
-		float bounds_y_min = zone_drawing.getBottomRight().y;
-		float bounds_y_max = zone_drawing.getTopLeft().y;
+/**
+ * @brief Dispatches one OSC message, either received live or replayed.
+ *
+ * @param (ofxOscMessage&)  m: incoming message
+ */
+void ofApp::handle_message(ofxOscMessage& m)
+{
+	float bounds_x_min = zone_drawing.getTopLeft().x;
+	float bounds_x_max = zone_drawing.getBottomRight().x;
+	float bounds_y_min = zone_drawing.getBottomRight().y;
+	float bounds_y_max = zone_drawing.getTopLeft().y;
 
-		if (m.getAddress() == "/stop") {
-			// stop all the cablebots (same as pressing SPACEBAR)
-			robots->pause();
-		}
-		else if (m.getAddress() == "/move") {
-			// turn on move_vel for all the cablebots
-			robots->move_vel_all(m.getArgAsBool(0));
-		}
-		// We received a normalized XY target in range {[0,1], [0,1]}
-		// Move all the Robots
-		else if (m.getAddress() == "/drawing/tgt_norm") {
-			//int i = m.getArgAsInt(0);
-			float x = m.getArgAsFloat(0);
-			float y = m.getArgAsFloat(1);
+	if (m.getAddress() == "/stop") {
+		// stop all the cablebots (same as pressing SPACEBAR)
+		robots->pause();
+	}
+	else if (m.getAddress() == "/move") {
+		// turn on move_vel for all the cablebots
+		robots->move_vel_all(m.getArgAsBool(0));
+	}
+	// We received a normalized XY target in range {[0,1], [0,1]}
+	// Move all the Robots
+	else if (m.getAddress() == "/drawing/tgt_norm") {
+		//int i = m.getArgAsInt(0);
+		float x = m.getArgAsFloat(0);
+		float y = m.getArgAsFloat(1);
 
-			x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
-			y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
+		x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
+		y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
 
-			//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
-			//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
+		//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
+		//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
 
-			//cout << "x: " << x << ", y: " << y << endl;
-			update_path(&path_drawing, glm::vec3(x, y, 0));	// does "follow the leader"
+		//cout << "x: " << x << ", y: " << y << endl;
+		update_path(&path_drawing, glm::vec3(x, y, 0));	// does "follow the leader"
 
-			//motion->add_to_path(0, glm::vec3(x, y, 0));
-			//motion->add_to_path(1, glm::vec3(x, y, 0));
-			//motion->add_to_path(2, glm::vec3(x, y, 0));
-			//motion->add_to_path(3, glm::vec3(x, y, 0));
+		//motion->add_to_path(0, glm::vec3(x, y, 0));
+		//motion->add_to_path(1, glm::vec3(x, y, 0));
+		//motion->add_to_path(2, glm::vec3(x, y, 0));
+		//motion->add_to_path(3, glm::vec3(x, y, 0));
 
-		}
-		// Add to Robot 0 Path
-		else if (m.getAddress() == "/drawing/0/tgt_norm") {
-			//cout << "move robot 0" << endl;
-			float x = m.getArgAsFloat(0);
-			float y = m.getArgAsFloat(1);
+	}
+	// Add to Robot 0 Path
+	else if (m.getAddress() == "/drawing/0/tgt_norm") {
+		//cout << "move robot 0" << endl;
+		float x = m.getArgAsFloat(0);
+		float y = m.getArgAsFloat(1);
 
-			x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
-			y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
+		x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
+		y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
 
-			//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
-			//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
+		//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
+		//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
 
-			motion->add_to_path(0, glm::vec3(x, y, 0));
-			//update_path(&path_drawing, glm::vec3(x, y, 0));
-		}
-		// Add to Robot 1 Path
-		else if (m.getAddress() == "/drawing/1/tgt_norm") {
-			//cout << "move robot 1" << endl;
-			float x = m.getArgAsFloat(0);
-			float y = m.getArgAsFloat(1);
+		motion->add_to_path(0, glm::vec3(x, y, 0));
+		//update_path(&path_drawing, glm::vec3(x, y, 0));
+	}
+	// Add to Robot 1 Path
+	else if (m.getAddress() == "/drawing/1/tgt_norm") {
+		//cout << "move robot 1" << endl;
+		float x = m.getArgAsFloat(0);
+		float y = m.getArgAsFloat(1);
 
-			x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
-			y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
+		x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
+		y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
 
-			//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
-			//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
+		//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
+		//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
 
-			motion->add_to_path(1, glm::vec3(x, y, 0));
+		motion->add_to_path(1, glm::vec3(x, y, 0));
 
-			//update_path(&path_drawing, glm::vec3(x, y, 0));
-		}
-		// Add to Robot 2 Path
-		else if (m.getAddress() == "/drawing/2/tgt_norm") {
-			//cout << "move robot 2" << endl;
-			float x = m.getArgAsFloat(0);
-			float y = m.getArgAsFloat(1);
+		//update_path(&path_drawing, glm::vec3(x, y, 0));
+	}
+	// Add to Robot 2 Path
+	else if (m.getAddress() == "/drawing/2/tgt_norm") {
+		//cout << "move robot 2" << endl;
+		float x = m.getArgAsFloat(0);
+		float y = m.getArgAsFloat(1);
 
-			x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
-			y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
+		x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
+		y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
 
-			//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
-			//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
+		//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
+		//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
 
-			motion->add_to_path(2, glm::vec3(x, y, 0));
+		motion->add_to_path(2, glm::vec3(x, y, 0));
 
-			//update_path(&path_drawing, glm::vec3(x, y, 0));
-		}
-		// Add to Robot 3 Path
-		else if (m.getAddress() == "/drawing/3/tgt_norm") {
-			//cout << "move robot 3" << endl;
-			float x = m.getArgAsFloat(0);
-			float y = m.getArgAsFloat(1);
+		//update_path(&path_drawing, glm::vec3(x, y, 0));
+	}
+	// Add to Robot 3 Path
+	else if (m.getAddress() == "/drawing/3/tgt_norm") {
+		//cout << "move robot 3" << endl;
+		float x = m.getArgAsFloat(0);
+		float y = m.getArgAsFloat(1);
 
-			x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
-			y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
+		x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
+		y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
 
-			//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
-			//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
+		//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
+		//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
 
-			motion->add_to_path(3, glm::vec3(x, y, 0));
+		motion->add_to_path(3, glm::vec3(x, y, 0));
 
-			//update_path(&path_drawing, glm::vec3(x, y, 0));
-		}
-		else if (m.getAddress() == "/drawing/clear") {
+		//update_path(&path_drawing, glm::vec3(x, y, 0));
+	}
+	else if (m.getAddress() == "/choreography/load") {
+		if (m.getNumArgs() > 0)
+			choreography.filename.set(m.getArgAsString(0));
+		choreography.btn_load.trigger();
+	}
+	else if (m.getAddress() == "/choreography/play") {
+		choreography.play_enable.set(m.getArgAsBool(0));
+	}
+	else if (m.getAddress() == "/drawing/clear") {
+		path_drawing.clear();
+		smoother_drawing.clear();
+		for (auto path : drawing_paths)
+			path->clear();
+		motion->clear_paths();
+	}
+	else if (m.getAddress() == "/drawing/enable_follow") {
+		zone_drawing_follow.set(m.getArgAsBool(0));
+		motion->motion_drawing_follow.set(m.getArgAsBool(0));
+	}
+	else if (m.getAddress() == "/drawing/accuracy") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_drawing_accuracy.getMin(), motion->motion_drawing_accuracy.getMax());
+		zone_drawing_accuracy.set(val);
+		motion->motion_drawing_accuracy.set(val);
+	}
+	else if (m.getAddress() == "/drawing/num_pts") {
+		//float val =; // normalized value between 0 and 1
+		int val = int(ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_drawing_length_max.getMin(), motion->motion_drawing_length_max.getMax(), true));
+		zone_drawing_length.set(val);
+		motion->motion_drawing_length_max.set(val);
+	}
+	else if (m.getAddress() == "/drawing/follow_offset") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_drawing_offset.getMin(), motion->motion_drawing_offset.getMax());
+		zone_drawing_follow_offset.set(val);
+		motion->motion_drawing_offset.set(val);
+	}
+	else if (m.getAddress() == "/line/enable_follow") {
+		bool val = m.getArgAsBool(0);
+		if (val) {
+			// clear any drawing paths
 			path_drawing.clear();
+			smoother_drawing.clear();
 			for (auto path : drawing_paths)
 				path->clear();
 			motion->clear_paths();
 		}
-		else if (m.getAddress() == "/drawing/enable_follow") {
-			zone_drawing_follow.set(m.getArgAsBool(0));
-			motion->motion_drawing_follow.set(m.getArgAsBool(0));
-		}
-		else if (m.getAddress() == "/drawing/accuracy") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_drawing_accuracy.getMin(), motion->motion_drawing_accuracy.getMax());
-			zone_drawing_accuracy.set(val);
-			motion->motion_drawing_accuracy.set(val);
-		}
-		else if (m.getAddress() == "/drawing/num_pts") {
-			//float val =; // normalized value between 0 and 1
-			int val = int(ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_drawing_length_max.getMin(), motion->motion_drawing_length_max.getMax(), true));
-			zone_drawing_length.set(val);
-			motion->motion_drawing_length_max.set(val);
-		}
-		else if (m.getAddress() == "/drawing/follow_offset") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_drawing_offset.getMin(), motion->motion_drawing_offset.getMax());
-			zone_drawing_follow_offset.set(val);
-			motion->motion_drawing_offset.set(val);
-		}
-		else if (m.getAddress() == "/line/enable_follow") {
-			bool val = m.getArgAsBool(0);
-			if (val) {
-				// clear any drawing paths
-				path_drawing.clear();
-				for (auto path : drawing_paths)
-					path->clear();
-				motion->clear_paths();
-			}
-			motion->motion_line_follow.set(val);
-		}
-		else if (m.getAddress() == "/line/length") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_line_length.getMin(), motion->motion_line_length.getMax());
-			motion->motion_line_length.set(val);
-		}
-		else if (m.getAddress() == "/line/reset") {
-			motion->on_motion_reset();
-		}
-		else if (m.getAddress() == "/line/theta") {
-			float val = ofMap(m.getArgAsFloat(0), -1, 1, motion->motion_theta.getMin(), motion->motion_theta.getMax());
-			motion->motion_theta.set(val);
-		}
-		else if (m.getAddress() == "/line/spin") {
-			motion->motion_spin_enable.set(m.getArgAsBool(0));
-		}
-		else if (m.getAddress() == "/line/spin_speed") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_spin_speed.getMin(), motion->motion_spin_speed.getMax());
-			motion->motion_spin_speed.set(val);
-		}
-		else if (m.getAddress() == "/line/position") {
-			float x = m.getArgAsFloat(0);
-			float y = m.getArgAsFloat(1);
+		motion->motion_line_follow.set(val);
+	}
+	else if (m.getAddress() == "/line/length") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_line_length.getMin(), motion->motion_line_length.getMax());
+		motion->motion_line_length.set(val);
+	}
+	else if (m.getAddress() == "/line/reset") {
+		motion->on_motion_reset();
+	}
+	else if (m.getAddress() == "/line/theta") {
+		float val = ofMap(m.getArgAsFloat(0), -1, 1, motion->motion_theta.getMin(), motion->motion_theta.getMax());
+		motion->motion_theta.set(val);
+	}
+	else if (m.getAddress() == "/line/spin") {
+		motion->motion_spin_enable.set(m.getArgAsBool(0));
+	}
+	else if (m.getAddress() == "/line/spin_speed") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_spin_speed.getMin(), motion->motion_spin_speed.getMax());
+		motion->motion_spin_speed.set(val);
+	}
+	else if (m.getAddress() == "/line/position") {
+		float x = m.getArgAsFloat(0);
+		float y = m.getArgAsFloat(1);
 
-			x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
-			y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
+		x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
+		y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
 
-			//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
-			//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
+		//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
+		//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
 
-			motion->motion_pos.set(glm::vec3(x, y, 0));
-			//motion->centroid.setGlobalPosition(motion->motion_pos);
-		}
-		else if (m.getAddress() == "/line/start") {
-			float x = m.getArgAsFloat(0);
-			float y = m.getArgAsFloat(1);
+		motion->motion_pos.set(glm::vec3(x, y, 0));
+		//motion->centroid.setGlobalPosition(motion->motion_pos);
+	}
+	else if (m.getAddress() == "/line/start") {
+		float x = m.getArgAsFloat(0);
+		float y = m.getArgAsFloat(1);
 
-			x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
-			y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
+		x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
+		y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
 
-			//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
-			//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
+		//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
+		//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
 
-			motion->motion_line.getVertices()[0].x = x;
-			motion->motion_line.getVertices()[0].y = y;
-			//motion->calculate_theta(motion->motion_line);
-			motion->centroid.setGlobalPosition((motion->motion_line.getVertices()[0] + motion->motion_line.getVertices()[1]) / 2);
+		motion->motion_line.getVertices()[0].x = x;
+		motion->motion_line.getVertices()[0].y = y;
+		//motion->calculate_theta(motion->motion_line);
+		motion->centroid.setGlobalPosition((motion->motion_line.getVertices()[0] + motion->motion_line.getVertices()[1]) / 2);
 
-			motion->motion_pos_prev = motion->centroid.getGlobalPosition();
-			motion->motion_pos.set(motion->centroid.getGlobalPosition());
+		motion->motion_pos_prev = motion->centroid.getGlobalPosition();
+		motion->motion_pos.set(motion->centroid.getGlobalPosition());
 
-			//motion->motion_pos.set(motion->motion_line.getCentroid2D());	// <-- not working
-		}
-		else if (m.getAddress() == "/line/end") {
-			float x = m.getArgAsFloat(0);
-			float y = m.getArgAsFloat(1);
+		//motion->motion_pos.set(motion->motion_line.getCentroid2D());	// <-- not working
+	}
+	else if (m.getAddress() == "/line/end") {
+		float x = m.getArgAsFloat(0);
+		float y = m.getArgAsFloat(1);
 
-			x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
-			y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
+		x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
+		y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
 
-			//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
-			//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
+		//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
+		//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
 
-			motion->motion_line.getVertices()[1].x = x;
-			motion->motion_line.getVertices()[1].y = y;
-			//motion->calculate_theta(motion->motion_line);
+		motion->motion_line.getVertices()[1].x = x;
+		motion->motion_line.getVertices()[1].y = y;
+		//motion->calculate_theta(motion->motion_line);
 
-			motion->centroid.setGlobalPosition((motion->motion_line.getVertices()[0] + motion->motion_line.getVertices()[1]) / 2);
-			motion->motion_pos_prev = motion->centroid.getGlobalPosition();
-			motion->motion_pos.set(motion->centroid.getGlobalPosition());
+		motion->centroid.setGlobalPosition((motion->motion_line.getVertices()[0] + motion->motion_line.getVertices()[1]) / 2);
+		motion->motion_pos_prev = motion->centroid.getGlobalPosition();
+		motion->motion_pos.set(motion->centroid.getGlobalPosition());
 
-			//motion->motion_pos.set(motion->motion_line.getCentroid2D());	// <-- not working
-		}
-		else if (m.getAddress() == "/circle/enable_follow") {
-			bool val = m.getArgAsBool(0);
-			if (val) {
-				// clear any drawing paths
-				path_drawing.clear();
-				for (auto path : drawing_paths)
-					path->clear();
-				motion->clear_paths();
-			}
-			motion->motion_circle_follow.set(val);
-		}
-		else if (m.getAddress() == "/circle/radius") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_circle_radius.getMin(), motion->motion_circle_radius.getMax());
-			motion->motion_circle_radius.set(val);
-		}
-		else if (m.getAddress() == "/circle/theta") {
-			float val = ofMap(m.getArgAsFloat(0), -1, 1, motion->motion_theta.getMin(), motion->motion_theta.getMax());
-			motion->motion_theta.set(val);
+		//motion->motion_pos.set(motion->motion_line.getCentroid2D());	// <-- not working
+	}
+	else if (m.getAddress() == "/circle/enable_follow") {
+		bool val = m.getArgAsBool(0);
+		if (val) {
+			// clear any drawing paths
+			path_drawing.clear();
+			smoother_drawing.clear();
+			for (auto path : drawing_paths)
+				path->clear();
+			motion->clear_paths();
 		}
-		else if (m.getAddress() == "/circle/position") {
-			float x = m.getArgAsFloat(0);
-			float y = m.getArgAsFloat(1);
+		motion->motion_circle_follow.set(val);
+	}
+	else if (m.getAddress() == "/circle/radius") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_circle_radius.getMin(), motion->motion_circle_radius.getMax());
+		motion->motion_circle_radius.set(val);
+	}
+	else if (m.getAddress() == "/circle/theta") {
+		float val = ofMap(m.getArgAsFloat(0), -1, 1, motion->motion_theta.getMin(), motion->motion_theta.getMax());
+		motion->motion_theta.set(val);
+	}
+	else if (m.getAddress() == "/circle/position") {
+		float x = m.getArgAsFloat(0);
+		float y = m.getArgAsFloat(1);
 
-			x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
-			y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
+		x = ofMap(x, 0, 1, zone_drawing.getMinX(), zone_drawing.getMaxX());
+		y = ofMap(y, 0, 1, zone_drawing.getMaxY(), zone_drawing.getMinY());
 
-			//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
-			//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
+		//x = ofMap(x, 0, 1, bounds_x_min, bounds_x_max);
+		//y = ofMap(y, 0, 1, bounds_y_min, bounds_y_max);
 
-			motion->motion_pos.set(glm::vec3(x, y, 0));
-		}
-		else if (m.getAddress() == "/circle/spin") {
-			motion->motion_spin_enable.set(m.getArgAsBool(0));
-		}
-		else if (m.getAddress() == "/circle/spin_speed") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_spin_speed.getMin(), motion->motion_spin_speed.getMax());
-			motion->motion_spin_speed.set(val);
-		}
-		else if (m.getAddress() == "/circle/reset") {
-			motion->on_motion_reset();
-		}
-		else if (m.getAddress() == "/circle/arc_angle") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_circle_angle_start.getMin(), motion->motion_circle_angle_start.getMax());
-			float theta = 90 + val / 2.0;
-			motion->motion_circle_angle_end.set(theta);
-			theta = 90 - val / 2.0;
-			motion->motion_circle_angle_start.set(theta);
-		}
-		else if (m.getAddress() == "/enable_sine") {
-			motion->enable_sine_wave.set(m.getArgAsBool(0));
-		}
-		else if (m.getAddress() == "/sine_speed") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->sine_wave_speed.getMin(), motion->sine_wave_speed.getMax());
-			motion->sine_wave_speed.set(val);
-		}
-		else if (m.getAddress() == "/sine_amp") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->sine_wave_amplitude.getMin(), motion->sine_wave_amplitude.getMax());
-			motion->sine_wave_amplitude.set(val);
-		}
-		else if (m.getAddress() == "/enable_pendulum") {
-			motion->enable_pendulum.set(m.getArgAsBool(0));
-		}
-		else if (m.getAddress() == "/pendulum_speed") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->pendulum_speed.getMin(), motion->pendulum_speed.getMax());
-			motion->pendulum_speed.set(val);
-		}
-		else if (m.getAddress() == "/pendulum_offset") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->pendulum_offset.getMin(), motion->pendulum_offset.getMax());
-			motion->pendulum_offset.set(val);
-		}
-		else if (m.getAddress() == "/eyes/enable") {
-			motion->enable_eyes.set(m.getArgAsBool(0));
-		}
-		else if (m.getAddress() == "/eyes/spacing") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->eye_spacing.getMin(), motion->eye_spacing.getMax());
-			motion->eye_spacing.set(val);
-		}
-		else if (m.getAddress() == "/eyes/radius") {
-			float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->eye_radius.getMin(), motion->eye_radius.getMax());
-			motion->eye_radius.set(val);
-		}
+		motion->motion_pos.set(glm::vec3(x, y, 0));
+	}
+	else if (m.getAddress() == "/circle/spin") {
+		motion->motion_spin_enable.set(m.getArgAsBool(0));
+	}
+	else if (m.getAddress() == "/circle/spin_speed") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_spin_speed.getMin(), motion->motion_spin_speed.getMax());
+		motion->motion_spin_speed.set(val);
+	}
+	else if (m.getAddress() == "/circle/reset") {
+		motion->on_motion_reset();
+	}
+	else if (m.getAddress() == "/circle/arc_angle") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->motion_circle_angle_start.getMin(), motion->motion_circle_angle_start.getMax());
+		float theta = 90 + val / 2.0;
+		motion->motion_circle_angle_end.set(theta);
+		theta = 90 - val / 2.0;
+		motion->motion_circle_angle_start.set(theta);
+	}
+	else if (m.getAddress() == "/enable_sine") {
+		motion->enable_sine_wave.set(m.getArgAsBool(0));
+	}
+	else if (m.getAddress() == "/sine_speed") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->sine_wave_speed.getMin(), motion->sine_wave_speed.getMax());
+		motion->sine_wave_speed.set(val);
+	}
+	else if (m.getAddress() == "/sine_amp") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->sine_wave_amplitude.getMin(), motion->sine_wave_amplitude.getMax());
+		motion->sine_wave_amplitude.set(val);
+	}
+	else if (m.getAddress() == "/enable_pendulum") {
+		motion->enable_pendulum.set(m.getArgAsBool(0));
+	}
+	else if (m.getAddress() == "/pendulum_speed") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->pendulum_speed.getMin(), motion->pendulum_speed.getMax());
+		motion->pendulum_speed.set(val);
+	}
+	else if (m.getAddress() == "/pendulum_offset") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->pendulum_offset.getMin(), motion->pendulum_offset.getMax());
+		motion->pendulum_offset.set(val);
+	}
+	else if (m.getAddress() == "/eyes/enable") {
+		motion->enable_eyes.set(m.getArgAsBool(0));
+	}
+	else if (m.getAddress() == "/eyes/spacing") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->eye_spacing.getMin(), motion->eye_spacing.getMax());
+		motion->eye_spacing.set(val);
+	}
+	else if (m.getAddress() == "/eyes/radius") {
+		float val = ofMap(m.getArgAsFloat(0), 0, 1, motion->eye_radius.getMin(), motion->eye_radius.getMax());
+		motion->eye_radius.set(val);
+	}
 
-		// We received an absolute XY target in range {[0,0], [bounds.min,bounds.max]}
-		//else if (m.getAddress() == "/tgt_abs") {
-		//	//int i = m.getArgAsInt(0);
-		//	float x = m.getArgAsFloat(0);
-		//	float y = m.getArgAsFloat(1);
+	// We received an absolute XY target in range {[0,0], [bounds.min,bounds.max]}
+	//else if (m.getAddress() == "/tgt_abs") {
+	//	//int i = m.getArgAsInt(0);
+	//	float x = m.getArgAsFloat(0);
+	//	float y = m.getArgAsFloat(1);
 
-		//	// just check the first set of robots
-		//	//if (i == 0) {
-		//	robots->set_target(0, x, y);
-		//	//}
-		//}
-		else {
-			// unrecognized message: display on the bottom of the screen
-			string msgString;
-			msgString = m.getAddress();
+	//	// just check the first set of robots
+	//	//if (i == 0) {
+	//	robots->set_target(0, x, y);
+	//	//}
+	//}
+	else {
+		// unrecognized message: display on the bottom of the screen
+		string msgString;
+		msgString = m.getAddress();
+		msgString += ":";
+		for (size_t i = 0; i < m.getNumArgs(); i++) {
+
+			// get the argument type
+			msgString += " ";
+			msgString += m.getArgTypeName(i);
 			msgString += ":";
-			for (size_t i = 0; i < m.getNumArgs(); i++) {
-
-				// get the argument type
-				msgString += " ";
-				msgString += m.getArgTypeName(i);
-				msgString += ":";
 
-				// display the argument - make sure we get the right type
-				if (m.getArgType(i) == OFXOSC_TYPE_INT32) {
-					msgString += ofToString(m.getArgAsInt32(i));
-				}
-				else if (m.getArgType(i) == OFXOSC_TYPE_FLOAT) {
-					msgString += ofToString(m.getArgAsFloat(i));
-				}
-				else if (m.getArgType(i) == OFXOSC_TYPE_STRING) {
-					msgString += m.getArgAsString(i);
-				}
-				else {
-					msgString += "unhandled argument type " + m.getArgTypeName(i);
-				}
+			// display the argument - make sure we get the right type
+			if (m.getArgType(i) == OFXOSC_TYPE_INT32) {
+				msgString += ofToString(m.getArgAsInt32(i));
+			}
+			else if (m.getArgType(i) == OFXOSC_TYPE_FLOAT) {
+				msgString += ofToString(m.getArgAsFloat(i));
+			}
+			else if (m.getArgType(i) == OFXOSC_TYPE_STRING) {
+				msgString += m.getArgAsString(i);
+			}
+			else {
+				msgString += "unhandled argument type " + m.getArgTypeName(i);
 			}
-			cout << msgString << endl;
 		}
-
+		cout << msgString << endl;
 	}
+
 }
 
 void ofApp::setup_camera()
@@ -7,7 +7,12 @@
 #include "CommsSensor.h"
 
 #include "controllers/robot/RobotController.h"
+#include "controllers/robot/Simulation.h"
 #include "controllers/motion/MotionController.h"
+#include "controllers/motion/Choreography.h"
+#include "controllers/motion/Formation.h"
+#include "controllers/motion/OscReplay.h"
+#include "controllers/Benchmark.h"
 #include "controllers/agent/AgentController.h"
 
 #define DEBUG
@@ -19,6 +24,7 @@ public:
 	void setup();
 	void update();
 	void draw();
+	void exit();
 
 	void keyPressed(int key);
 	void key_pressed_gizmo(int key);
@@ -35,6 +41,10 @@ public:
 
 	RobotController* robots;
 	MotionController* motion;
+	Formation formation;
+	Choreography choreography;
+	void validate_choreography();
+	void on_choreography_load();
 	AgentController* agents;
 
 	ofNode origin;
@@ -47,6 +57,28 @@ public:
 	ofxOscReceiver osc_receiver;
 	void check_for_messages();
 	void check_for_messages(ofxOscReceiver* receiver);
+	void handle_message(ofxOscMessage& m);
+	OscReplay osc_replay;
+
+	Simulation::Settings simulation_settings;	// set by main() before setup
+	Simulation simulation;
+	void update_simulation();
+
+	Benchmark::Settings benchmark_settings;		// set by main() before setup
+	Benchmark benchmark;
+	void run_benchmarks();
+	void benchmark_conversions();
+	void benchmark_solver_3D();
+	void benchmark_pd_controller();
+	void benchmark_paths();
+	void benchmark_motion();
+	void benchmark_agents();
+	void benchmark_integrator();
+	void benchmark_osc();
+
+	bool self_test = false;						// set by main() before setup
+	void run_self_tests();
+	bool test_path_smoother();
 
 	ofxOscReceiver osc_receiver_skeleton;
 	int port_skeleton = 12345;
@@ -76,6 +108,7 @@ public:
 	ofParameter<int> osc_port_listening = 55555;
 	ofParameter<void> osc_connect;
 	ofParameter<string> osc_status;
+	ofParameter<bool> osc_record;
 
 	ofParameterGroup params_zones;
 	ofParameterGroup params_zone_sensor;
@@ -112,6 +145,7 @@ public:
 	void on_zone_drawing_height_changed(float& val);
 
 	void on_osc_connect();
+	void on_osc_record(bool& val);
 
 	void setup_sensors();
 	ofxGizmo gizmo_sensor;
@@ -126,13 +160,16 @@ public:
 	void draw_skeleton(vector<ofNode*> joints);
 	void update_sensor_path();
 	void draw_sensor_path();
-	ofPolyline path_sensor;
+	PathQueue path_sensor = PathQueue(50);
 
-	ofPolyline path_drawing;
+	PathQueue path_drawing;
+	PathSmoother smoother_drawing;
+
+	BatchRenderer batch;		// one draw call per primitive type for the 3D scene
 	vector<ofPolyline*> drawing_paths;
-	void update_drawing_path(ofPolyline* path, glm::vec3 pt);
-	void update_path(ofPolyline* path, glm::vec3 pt);
-	void draw_path(ofPolyline* path);
+	void update_drawing_path(PathQueue* path, glm::vec3 pt);
+	void update_path(PathQueue* path, glm::vec3 pt);
+	void draw_path(PathQueue* path);
 
 	enum k4abt_joint_names {
 		K4ABT_JOINT_PELVIS,